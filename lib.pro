@@ -48,7 +48,9 @@ linux {
 		src/standard/linux/p_device.c \
 		src/standard/linux/p_standard.c \
 		src/intercept/linux/p_grabber.c \
-		src/intercept/linux/p_intercept.c
+		src/intercept/linux/p_intercept.c \
+		src/intercept/linux/p_ring.c \
+		src/intercept/linux/p_trace.c
 }
 none {
 	SOURCES += \
@@ -33,6 +33,7 @@
 #include "mcr/extras/string_key.h"
 #include "mcr/extras/wrap_trigger.h"
 #include "mcr/extras/macros_interrupted.h"
+#include "mcr/extras/macro_executor.h"
 
 namespace mcr
 {
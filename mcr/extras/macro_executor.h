@@ -0,0 +1,110 @@
+/* Libmacro - A multi-platform, extendable macro and hotkey C library
+  Copyright (C) 2013 Jonathan Pelletier, New Paradigm Software
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*! \file
+ *  \brief \ref MacroExecutor - Run many macros on a small set of threads.
+ */
+
+#ifndef MCR_EXTRAS_MACRO_EXECUTOR_H_
+#define MCR_EXTRAS_MACRO_EXECUTOR_H_
+
+#include "mcr/extras/model.h"
+
+/* C++20 coroutines, unless disabled */
+#ifndef MCR_EXECUTOR_COROUTINES
+	#if defined(__cpp_impl_coroutine) && __cplusplus >= 202002L
+		#define MCR_EXECUTOR_COROUTINES 1
+	#else
+		#define MCR_EXECUTOR_COROUTINES 0
+	#endif
+#endif
+
+namespace mcr
+{
+/*! Run macros as resumable tasks, instead of one thread per execution.
+ *
+ *  \ref mcr_NoOp, the interval of \ref StringKey, and the frames of
+ *  \ref mcr_Smooth suspend the task on a timer instead of blocking a
+ *  thread, so many macros share a few threads.  Other signals, such as \ref Command, are sent from the
+ *  executor threads.  With C++20 coroutines each task is a coroutine
+ *  that co_awaits its timers.  Otherwise each task resumes from the
+ *  position of its next signal.
+ *
+ *  Tasks are counted in \ref mcr_Macro.thread_count, limited by
+ *  \ref mcr_Macro.thread_max, queue by \ref mcr_Macro.queue_policy, and
+ *  follow \ref mcr_Macro.interruptor the same as macro threads.  Pauses
+ *  end after \ref MCR_MAX_PAUSE_COUNT seconds.  Executors are notified
+ *  by \ref mcr_Macro_set_interrupt_listener, so sleeping tasks of a
+ *  disabled, interrupted, or continued macro are woken immediately.
+ */
+class MCR_API MacroExecutor
+{
+public:
+	/*! \param threadCount Number of threads to run all tasks, at least 1 */
+	MacroExecutor(size_t threadCount = 2);
+	MacroExecutor(const MacroExecutor &) = delete;
+	/*! Cancel all tasks and join all threads */
+	~MacroExecutor();
+	MacroExecutor &operator =(const MacroExecutor &) = delete;
+
+	/*! Get the last created \ref MacroExecutor
+	 *
+	 *  Will throw EFAULT if none exists
+	 */
+	static MacroExecutor *instance();
+	/*! \ref mcr_Dispatcher_receive_fnc, trigger into \ref instance
+	 *
+	 *  \param mcrPt \ref mcr_Macro *
+	 *  \return \ref mcr_Macro.blocking
+	 */
+	static bool receive(void *mcrPt, mcr_Signal *dispatchSignal,
+						unsigned int mods);
+	/*! True if tasks are C++20 coroutines */
+	static inline bool isCoroutine()
+	{
+		return MCR_EXECUTOR_COROUTINES;
+	}
+
+	/*! Start one execution of a macro
+	 *
+	 *  Will throw ENOMEM, or mcr_err for a locking error
+	 *  \return False if not started or queued, because the macro is not
+	 *  enabled or all \ref mcr_Macro.thread_max are running and the
+	 *  \ref mcr_Macro.queue_policy drops it
+	 */
+	bool trigger(mcr_Macro *mcrPt);
+	inline bool trigger(Macro &macro)
+	{
+		return trigger(macro.ptr());
+	}
+	/*! Stop all tasks of a macro, without waiting for them to finish */
+	void cancel(mcr_Macro *mcrPt);
+	inline void cancel(Macro &macro)
+	{
+		cancel(macro.ptr());
+	}
+	/*! Number of tasks currently running or sleeping */
+	size_t taskCount() const;
+	size_t threadCount() const;
+private:
+	/* Executor internals */
+	void *_impl;
+};
+}
+
+#endif
@@ -502,6 +502,22 @@ struct MCR_API Macro {
 		return _macro.thread_max;
 	}
 	void setThreadMax(unsigned int val);
+	inline mcr_MacroQueuePolicy queuePolicy() const
+	{
+		return static_cast<mcr_MacroQueuePolicy>(_macro.queue_policy);
+	}
+	inline unsigned int queueMax() const
+	{
+		return _macro.queue_max;
+	}
+	/*! \ref mcr_Macro_set_queue_policy */
+	void setQueuePolicy(mcr_MacroQueuePolicy policy, unsigned int queueMax = 0);
+	inline const mcr_ThreadOptions &threadOptions() const
+	{
+		return _macro.thread_options;
+	}
+	/*! \ref mcr_Macro_set_thread_options */
+	void setThreadOptions(const mcr_ThreadOptions &val);
 	inline Interrupt interruptor() const
 	{
 		return _macro.interruptor;
@@ -526,6 +542,15 @@ struct MCR_API Macro {
 	{
 		return _macro.queued;
 	}
+	/*! \ref mcr_Macro_stats */
+	mcr_MacroStats stats();
+	/*! \ref mcr_Macro_reset_stats */
+	void resetStats();
+	/*! \ref mcr_Macro_thread_options_error */
+	inline int threadOptionsError()
+	{
+		return mcr_Macro_thread_options_error(ptr());
+	}
 
 	void copy(const Macro &copytron);
 	void copy(const mcr_Macro *copytron)
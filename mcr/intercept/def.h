@@ -28,4 +28,10 @@
 	#define MCR_POLL_TIMEOUT 3000
 #endif
 
+/*! Number of latency histogram buckets, bucket i counts latencies less
+ *  than 2^(i+1) microseconds */
+#ifndef MCR_LATENCY_BUCKETS
+	#define MCR_LATENCY_BUCKETS 24
+#endif
+
 #endif
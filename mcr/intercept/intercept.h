@@ -29,6 +29,36 @@
 extern "C" {
 #endif
 
+/*! Counts of latencies in power of two microsecond buckets
+ *
+ *  Updated by intercept threads without locking.
+ */
+struct mcr_LatencyHistogram {
+	/*! Bucket i counts latencies less than 2^(i+1) microseconds, and
+	 *  the last bucket counts all others. */
+	size_t buckets[MCR_LATENCY_BUCKETS];
+	/*! Number of latencies added */
+	size_t count;
+	/*! Sum of all latencies in microseconds */
+	size_t total_usec;
+	/*! Largest latency in microseconds */
+	size_t max_usec;
+};
+
+/*! Add one latency
+ *
+ *  Thread-safe with other adds.
+ */
+MCR_API void mcr_LatencyHistogram_add(struct mcr_LatencyHistogram *histPt,
+									  size_t usec);
+/*! Upper bound of the bucket containing a percentile
+ *
+ *  \param percentile 0 to 100
+ *  \return Microseconds, or 0 if nothing added
+ */
+MCR_API size_t mcr_LatencyHistogram_percentile(const struct
+		mcr_LatencyHistogram *histPt, double percentile);
+
 /*! Set known modifiers from hardware values. */
 MCR_API void mcr_intercept_reset_modifiers(struct mcr_context *ctx);
 /*! \ref mcr_intercept.blockable */
@@ -37,6 +67,35 @@ MCR_API bool mcr_intercept_is_blockable(struct mcr_context *ctx);
 MCR_API void mcr_intercept_set_blockable(struct mcr_context *ctx, bool enable);
 /*! If currently enabled this will reset all current hardware intercepts. */
 MCR_API int mcr_intercept_reset(struct mcr_context *ctx);
+/*! Set scheduling options for intercept threads.
+ *
+ *  Applied when intercept threads start, use \ref mcr_intercept_reset
+ *  to apply to current intercepts.
+ *  \param optionsPt \ref opt \ref mcr_intercept.thread_options, null to
+ *  reset to defaults
+ */
+MCR_API void mcr_intercept_set_thread_options(struct mcr_context *ctx,
+		const struct mcr_ThreadOptions *optionsPt);
+/*! Why the last intercept thread was not able to apply
+ *  \ref mcr_intercept.thread_options
+ *
+ *  \return Error number from \ref mcr_thrd_set_options, or 0 if
+ *  all options were applied
+ */
+MCR_API int mcr_intercept_thread_options_error(struct mcr_context *ctx);
+/*! \ref mcr_intercept.latency_enabled */
+MCR_API void mcr_intercept_set_latency_enabled(struct mcr_context *ctx,
+		bool enable);
+/*! Copy latency histograms
+ *
+ *  \param dispatchPt \ref opt \ref mcr_intercept.dispatch_latency
+ *  \param writePt \ref opt \ref mcr_intercept.write_latency
+ */
+MCR_API void mcr_intercept_latency(struct mcr_context *ctx,
+								   struct mcr_LatencyHistogram *dispatchPt,
+								   struct mcr_LatencyHistogram *writePt);
+/*! Zero all latency histograms */
+MCR_API void mcr_intercept_reset_latency(struct mcr_context *ctx);
 
 /* platform */
 /*! Is any hardware intercepting.
@@ -55,6 +114,17 @@ MCR_API int mcr_intercept_set_enabled(struct mcr_context *ctx, bool enable);
  *  \ref mcr_is_platform
  */
 MCR_API unsigned int mcr_intercept_modifiers(struct mcr_context *ctx);
+/*! Time the OS created the event currently dispatched from intercept.
+ *
+ *  Only valid for receivers called from intercept dispatch, on the same
+ *  thread.  Generated events, such as after resynchronizing, do not have
+ *  a time.  On Linux this is CLOCK_MONOTONIC if the device allows it,
+ *  otherwise CLOCK_REALTIME.
+ *  \ref mcr_is_platform
+ *  \param timePt Set to the event time
+ *  \return True if an intercepted event with a time is being dispatched
+ */
+MCR_API bool mcr_intercept_event_time(struct timespec *timePt);
 
 /*! Intercept module
  *
@@ -65,6 +135,20 @@ struct mcr_intercept {
 	 *
 	 *  Default false for OS compatibility. */
 	bool blockable;
+	/*! Scheduling applied by intercept threads when they start.  Not used
+	 *  by platforms without intercept threads. */
+	struct mcr_ThreadOptions thread_options;
+	/*! Error of the last intercept thread applying thread_options, or 0
+	 *  if applied successfully.  Written by intercept threads, use
+	 *  \ref mcr_intercept_thread_options_error to read. */
+	size_t thread_options_error;
+	/*! Measure latencies of intercepted events, default false */
+	bool latency_enabled;
+	/*! From the OS event time until dispatch starts */
+	struct mcr_LatencyHistogram dispatch_latency;
+	/*! From dispatch start until blocking passthrough is written, or
+	 *  until dispatch ends if not blocking */
+	struct mcr_LatencyHistogram write_latency;
 	/*! All data reserved for platform definitions */
 	void *platform;
 };
@@ -30,13 +30,41 @@ extern "C" {
 #include "mcr/standard/linux/p_standard.h"
 #include "mcr/intercept/def.h"
 
+/*! Maximum number of events read from a grabber at once.  Only events
+ *  of blocked signals are removed from a set. */
 #ifndef MCR_GRAB_SET_LENGTH
-#define MCR_GRAB_SET_LENGTH 16
+#define MCR_GRAB_SET_LENGTH 64
 #endif
 
 #define MCR_GRAB_SET_SIZE (sizeof(struct input_event) * \
 	MCR_GRAB_SET_LENGTH)
 
+/*! Coalescing window for grabbers limited only by frame count */
+#ifndef MCR_COALESCE_USEC
+#define MCR_COALESCE_USEC 1000
+#endif
+
+/*! Maximum number of reactor threads reading all grabbers */
+#ifndef MCR_REACTOR_MAX
+#define MCR_REACTOR_MAX 8
+#endif
+
+/*! Maximum number of ready grabbers read for one reactor wake */
+#ifndef MCR_REACTOR_EVENTS
+#define MCR_REACTOR_EVENTS 32
+#endif
+
+/*! Submission queue size of reactors using io_uring */
+#ifndef MCR_RING_ENTRIES
+#define MCR_RING_ENTRIES 256
+#endif
+
+/*! Passthrough writes of one io_uring reactor in progress at once.
+ *  Writes beyond this are written directly. */
+#ifndef MCR_RING_WRITES
+#define MCR_RING_WRITES 32
+#endif
+
 #ifdef __cplusplus
 }
 #endif
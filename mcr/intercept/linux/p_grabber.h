@@ -29,6 +29,58 @@
 extern "C" {
 #endif
 
+#define MCR_EVENTINDEX(keyCode) \
+((keyCode) / 8)
+
+#define MCR_EVENTBIT(keyCode) \
+(1 << ((keyCode) % 8))
+
+/*! True if a code is set in a bit array retrieved from evdev */
+#define MCR_EVENTBIT_ISSET(bitArr, code) \
+(!!((bitArr)[MCR_EVENTINDEX(code)] & MCR_EVENTBIT(code)))
+
+/*! Kind of device, chosen from capabilities when a grabber is enabled */
+enum mcr_GrabberClass {
+	/*! Unknown or mixed capabilities */
+	MCR_GRABBER_GENERIC = 0,
+	/*! Only keys or buttons */
+	MCR_GRABBER_KEYBOARD,
+	/*! Relative motion and scroll, and optionally buttons */
+	MCR_GRABBER_POINTER,
+	/*! Absolute position, and optionally buttons */
+	MCR_GRABBER_TABLET
+};
+
+/*! Device capabilities, read when a grabber is enabled */
+struct mcr_GrabberCapabilities {
+	/*! EV_* types, \ref MCR_EVENTBIT_ISSET */
+	char ev_bits[MCR_EVENTINDEX(EV_CNT) + 1];
+	/*! Key and button codes */
+	char key_bits[MCR_EVENTINDEX(KEY_CNT) + 1];
+	/*! REL_* codes */
+	char rel_bits[MCR_EVENTINDEX(REL_CNT) + 1];
+	/*! ABS_* codes */
+	char abs_bits[MCR_EVENTINDEX(ABS_CNT) + 1];
+	/*! Range of ABS_X, ABS_Y, and ABS_Z if available */
+	struct input_absinfo abs_info[MCR_DIMENSION_CNT];
+	/*! Device name */
+	char name[UINPUT_MAX_NAME_SIZE];
+	/*! \ref mcr_GrabberClass */
+	int grabber_class;
+};
+
+/*! Capabilities a device must have, see \ref mcr_Grabber_match */
+struct mcr_GrabFilter {
+	/*! Bits of (1 << EV_*) the device must all have, 0 for any device */
+	unsigned int ev_types;
+	/*! A key code the device must have, e.g. KEY_A for keyboards.
+	 *  0 for any device */
+	int key;
+	/*! Bits of (1 << \ref mcr_GrabberClass) the device may be, 0 for any
+	 *  class */
+	unsigned int classes;
+};
+
 /*! Take exclusive access to a /dev/input event. */
 struct mcr_Grabber {
 	/*! Allow blocked grabbing, \ref EVIOCGRAB
@@ -39,6 +91,20 @@ struct mcr_Grabber {
 	int fd;
 	/*! File path of input event */
 	struct mcr_Array path;
+	/*! Sum relative motion and scroll frames for this many microseconds
+	 *  before dispatching them as one frame.  Frames with any other
+	 *  event are never coalesced.
+	 *
+	 *  0 to not coalesce, or \ref MCR_COALESCE_USEC if
+	 *  \ref mcr_Grabber.coalesce_frames is set. */
+	unsigned int coalesce_usec;
+	/*! Dispatch coalesced motion after this many frames, 0 for no
+	 *  frame limit */
+	unsigned int coalesce_frames;
+	/*! Read when enabled, and zero'd if not readable */
+	struct mcr_GrabberCapabilities capabilities;
+	/*! Clock of event times, CLOCK_MONOTONIC if the device allows it */
+	int clock_id;
 };
 
 /*! ctor */
@@ -54,6 +120,20 @@ MCR_API int mcr_Grabber_set_blocking(struct mcr_Grabber *grabPt, bool enable);
 MCR_API const char *mcr_Grabber_path(struct mcr_Grabber *grabPt);
 /*! \ref mcr_Grabber.path */
 MCR_API int mcr_Grabber_set_path(struct mcr_Grabber *grabPt, const char *path);
+/*! \ref mcr_Grabber.coalesce_usec and \ref mcr_Grabber.coalesce_frames */
+MCR_API void mcr_Grabber_set_coalesce(struct mcr_Grabber *grabPt,
+									  unsigned int usec, unsigned int frames);
+/*! \ref mcr_GrabberCapabilities.grabber_class */
+#define mcr_Grabber_class(grabPt) ((grabPt)->capabilities.grabber_class)
+/*! True if an enabled grabber has all capabilities of a filter
+ *
+ *  \param filterPt \ref opt If null, all grabbers match
+ */
+MCR_API bool mcr_Grabber_match(struct mcr_Grabber *grabPt,
+							   const struct mcr_GrabFilter *filterPt);
+/*! True if relative motion may be coalesced */
+#define mcr_Grabber_is_coalescing(grabPt) \
+((grabPt)->coalesce_usec || (grabPt)->coalesce_frames)
 /*! Get enabled state, and set the grabber enabled
  *  state to the same.
  */
@@ -64,12 +144,6 @@ MCR_API bool mcr_Grabber_is_enabled(struct mcr_Grabber *grabPt);
  */
 MCR_API int mcr_Grabber_set_enabled(struct mcr_Grabber *grabPt, bool enable);
 
-#define MCR_EVENTINDEX(keyCode) \
-((keyCode) / 8)
-
-#define MCR_EVENTBIT(keyCode) \
-(1 << ((keyCode) % 8))
-
 #ifdef __cplusplus
 }
 #endif
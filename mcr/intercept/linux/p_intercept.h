@@ -24,32 +24,212 @@
 #ifndef MCR_INTERCEPT_LNX_NINTERCEPT_H_
 #define MCR_INTERCEPT_LNX_NINTERCEPT_H_
 
-#include "mcr/intercept/linux/p_grabber.h"
+#include "mcr/intercept/linux/p_ring.h"
+#include "mcr/intercept/linux/p_trace.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct mcr_context;
+
+/*! Events of one \ref mcr_intercept_platform.passthrough_fd write
+ *  submitted to io_uring */
+struct mcr_RingWrite {
+	struct input_event events[MCR_GRAB_SET_LENGTH];
+	/*! Submitted and not yet completed */
+	bool busy;
+};
+
+/*! One thread reading many grabbers with epoll */
+struct mcr_Reactor {
+	/*! Libmacro context */
+	struct mcr_context *ctx;
+	/*! epoll instance, -1 if the reactor is not running */
+	int epoll_fd;
+	/*! eventfd to wake the reactor thread */
+	int wake_fd;
+	/*! Reactor thread, valid while running */
+	thrd_t thread;
+	/*! Set to stop the reactor thread */
+	volatile bool stopping;
+	/*! Number of grabbers read by this reactor */
+	size_t grab_count;
+	/*! Grab contexts removed while they may still be read.  The reactor
+	 *  thread frees these between reads. */
+	struct mcr_Array garbage;
+	/*! Grab contexts with coalesced motion not yet dispatched */
+	struct mcr_Array pending;
+	/*! io_uring reading grabbers and writing passthrough events to
+	 *  \ref mcr_intercept_platform.passthrough_fd, not open if this
+	 *  reactor uses epoll. */
+	struct mcr_Ring ring;
+	/*! Grab contexts added while running, the reactor thread starts
+	 *  reading them with io_uring. */
+	struct mcr_Array added;
+	/*! Replays of regular files read with epoll.  epoll cannot wait on
+	 *  regular files, which are always readable, so the reactor thread
+	 *  reads them each loop without waiting. */
+	struct mcr_Array files;
+	/*! \ref MCR_RING_WRITES passthrough writes, null if not using
+	 *  io_uring */
+	struct mcr_RingWrite *ring_writes;
+	/*! Number of grabber reads and polls in progress */
+	size_t ring_reads;
+	/*! Last entry prepared, if it is a passthrough write not yet
+	 *  submitted.  Linked to the next write to keep order. */
+	struct io_uring_sqe *ring_last_write;
+};
+
 /*! Linux intercept platform structure */
 struct mcr_intercept_platform {
 	/*! Intercept critical sections */
 	mtx_t lock;
-	/*! Ordered list so each grab can remove itself */
+	/*! Ordered list of all grab contexts */
 	struct mcr_Array grab_contexts;
+	/*! Threads reading grabbers, each grabber is read by the reactor
+	 *  with the fewest grabbers when added. */
+	struct mcr_Reactor reactors[MCR_REACTOR_MAX];
+	/*! Number of reactors started when enabled, default 1 */
+	size_t reactor_count;
+	/*! Reactors read and write with io_uring instead of epoll and
+	 *  direct writes, default false.  Reactors use epoll if io_uring is
+	 *  not available. */
+	bool ring_enabled;
+	/*! \ref mcr_Grabber.coalesce_usec of new grabbers */
+	unsigned int coalesce_usec;
+	/*! \ref mcr_Grabber.coalesce_frames of new grabbers */
+	unsigned int coalesce_frames;
+	/*! Output of new grabbers, see \ref mcr_intercept_set_output */
+	unsigned int output;
+	/*! Intercepted cursor movement that is not blocked is applied to
+	 *  the tracked cursor position, default false.  See
+	 *  \ref mcr_cursor_position */
+	volatile bool track_cursor;
 	/*! Set of input event paths to try grabbing */
 	mcr_StringSet grab_paths;
-	/*! Get key pressed values from a device
-	 *
-	 *  KEY_CNT / 8 is a floor value, and may have remainder of keys. */
-	char bit_retrieval[MCR_EVENTINDEX(KEY_CNT) + 1];
+	/*! Auto-grab event devices when watching */
+	bool watch_enabled;
+	/*! Filter for devices to auto-grab */
+	struct mcr_GrabFilter watch_filter;
+	/*! inotify on the event directory, -1 if not watching */
+	int watch_fd;
+	/*! If not -1, events not blocked are written here instead of the
+	 *  generic devices, e.g. /dev/null for benchmarks without uinput. */
+	int passthrough_fd;
 };
-/* All use /dev/input/eventX files to read from */
+/* All use /dev/input/eventX files to read from.  While enabled, grabbers
+ * are added and removed without interrupting other grabbers. */
 MCR_API int mcr_intercept_add_grab(struct mcr_context *ctx,
 								   const char *grabPath);
 MCR_API void mcr_intercept_remove_grab(struct mcr_context *ctx,
 									   const char *grabPath);
 MCR_API int mcr_intercept_set_grabs(struct mcr_context *ctx,
 									const char **allGrabPaths, size_t pathCount);
+/*! \ref mcr_intercept_platform.watch_enabled */
+MCR_API bool mcr_intercept_is_watching(struct mcr_context *ctx);
+/*! Automatically grab event devices matching a filter.
+ *
+ *  While intercept is enabled, all present devices and devices
+ *  appearing later in the event directory are grabbed if they match.
+ *  Libmacro virtual devices are never grabbed.
+ *  \param filterPt \ref opt Devices to grab, or null to stop watching.
+ *  Devices already grabbed will remain grabbed.
+ *  \return \ref reterr
+ */
+MCR_API int mcr_intercept_set_watch(struct mcr_context *ctx,
+									const struct mcr_GrabFilter *filterPt);
+/*! Coalesce relative motion and scroll of grabbers, see
+ *  \ref mcr_Grabber.coalesce_usec
+ *
+ *  \param grabPath \ref opt Only set for this grabbed path.  If null, set
+ *  for all grabbers, including grabbers added later.
+ *  \param usec Coalescing window in microseconds
+ *  \param frames Maximum frames to coalesce, 0 for no limit.  Both 0 to
+ *  disable.
+ *  \return \ref reterr, ENOENT if grabPath is not grabbed
+ */
+MCR_API int mcr_intercept_set_coalesce(struct mcr_context *ctx,
+									   const char *grabPath, unsigned int usec, unsigned int frames);
+/*! Write events that are not blocked to an output, see
+ *  \ref mcr_output_add.
+ *
+ *  Ignored while \ref mcr_intercept_platform.passthrough_fd is set.
+ *  \param grabPath \ref opt Only set for this grabbed path.  If null, set
+ *  for all grabbers, including grabbers added later.
+ *  \param output 0 for the default output
+ *  \return \ref reterr, ENOENT if grabPath is not grabbed or output does
+ *  not exist
+ */
+MCR_API int mcr_intercept_set_output(struct mcr_context *ctx,
+									 const char *grabPath, unsigned int output);
+/*! Write a trace of raw events read from a grabbed device.
+ *
+ *  The trace header is written immediately, followed by all events read
+ *  from the device until capture is stopped.  Events are written when
+ *  read, before being dispatched.
+ *  \param grabPath Grabbed path
+ *  \param fd File to write to, owned by the caller.  -1 to stop capture.
+ *  \return \ref reterr, ENOENT if grabPath is not grabbed
+ */
+MCR_API int mcr_intercept_set_capture(struct mcr_context *ctx,
+									  const char *grabPath, int fd);
+/*! Read a trace as if it were a grabbed device, see
+ *  \ref mcr_Trace_replay.
+ *
+ *  Events are intercepted, dispatched and written to the generic
+ *  devices or \ref mcr_intercept_platform.passthrough_fd, the same as
+ *  from a device.  Reading starts immediately and does not require
+ *  permissions for input devices.  The replay is removed at the end of
+ *  the file, or when intercept is disabled.
+ *  \param fd File, pipe or socket starting with a trace header.
+ *  It is set non-blocking, and closed by intercept when removed.
+ *  \return \ref reterr, EPROTO if fd does not start with a trace
+ *  header
+ */
+MCR_API int mcr_intercept_add_replay(struct mcr_context *ctx, int fd);
+/*! \ref mcr_intercept_platform.passthrough_fd
+ *
+ *  \param fd Owned by the caller, or -1 to write to generic devices
+ *  \return \ref reterr
+ */
+MCR_API int mcr_intercept_set_passthrough_fd(struct mcr_context *ctx,
+		int fd);
+/*! \ref mcr_intercept_platform.track_cursor */
+MCR_API bool mcr_intercept_is_tracking_cursor(struct mcr_context *ctx);
+/*! Apply intercepted cursor movement to the tracked cursor position.
+ *
+ *  Relative movement is clamped to the absolute resolution.  Absolute
+ *  movement is in the coordinates of the grabbed device.
+ *  \return \ref reterr
+ */
+MCR_API int mcr_intercept_set_track_cursor(struct mcr_context *ctx,
+		bool enable);
+/*! \ref mcr_intercept_platform.ring_enabled */
+MCR_API bool mcr_intercept_is_ring_enabled(struct mcr_context *ctx);
+/*! Read grabbers and write passthrough events with io_uring.
+ *
+ *  Only \ref mcr_intercept_platform.passthrough_fd is written with
+ *  io_uring.  Output devices are written directly with their device
+ *  lock, because a device may be recreated while a write is queued.
+ *
+ *  Applied the next time intercept is enabled, see
+ *  \ref mcr_intercept_reset
+ *  \return \ref reterr
+ */
+MCR_API int mcr_intercept_set_ring_enabled(struct mcr_context *ctx,
+		bool enable);
+/*! \ref mcr_intercept_platform.reactor_count */
+MCR_API size_t mcr_intercept_reactor_count(struct mcr_context *ctx);
+/*! Set the number of threads reading all grabbers.
+ *
+ *  Applied the next time intercept is enabled, see
+ *  \ref mcr_intercept_reset
+ *  \param count 1 to \ref MCR_REACTOR_MAX
+ *  \return \ref reterr
+ */
+MCR_API int mcr_intercept_set_reactor_count(struct mcr_context *ctx,
+		size_t count);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,107 @@
+/* Libmacro - A multi-platform, extendable macro and hotkey C library
+  Copyright (C) 2013 Jonathan Pelletier, New Paradigm Software
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*! \file
+ *  \brief Ring - Minimal io_uring submission and completion queues,
+ *  used by reactors to read grabbers and write passthrough events with
+ *  fewer system calls.
+ */
+
+#ifndef MCR_INTERCEPT_LNX_NRING_H_
+#define MCR_INTERCEPT_LNX_NRING_H_
+
+#include "mcr/intercept/linux/p_def.h"
+
+#include <linux/io_uring.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! One io_uring instance, used by only one thread at a time */
+struct mcr_Ring {
+	/*! io_uring file, -1 if not open */
+	int fd;
+	/*! Mapped submission ring */
+	void *sq_map;
+	size_t sq_map_size;
+	/*! Mapped completion ring, may be the same as sq_map */
+	void *cq_map;
+	size_t cq_map_size;
+	/*! Mapped submission entries */
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+	unsigned int *sq_head;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	unsigned int sq_entries;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_cqe *cqes;
+	/*! Entries prepared and not yet submitted */
+	unsigned int sq_pending;
+};
+
+/*! ctor */
+MCR_API int mcr_Ring_init(void *ringPt);
+/*! dtor, \ref mcr_Ring_close */
+MCR_API int mcr_Ring_deinit(void *ringPt);
+
+/*! Create an io_uring
+ *
+ *  \param entries Submission queue size
+ *  \return \ref reterr, ENOSYS if io_uring is not available or does
+ *  not have all features required
+ */
+MCR_API int mcr_Ring_open(struct mcr_Ring *ringPt, unsigned int entries);
+/*! Close the io_uring, requests in progress are cancelled. */
+MCR_API void mcr_Ring_close(struct mcr_Ring *ringPt);
+/*! \ref mcr_Ring.fd != -1 */
+#define mcr_Ring_is_open(ringPt) ((ringPt)->fd != -1)
+/*! Get a zeroed submission entry to prepare
+ *
+ *  The entry is submitted with the next \ref mcr_Ring_submit.
+ *  \return Null if the submission queue is full
+ */
+MCR_API struct io_uring_sqe *mcr_Ring_sqe(struct mcr_Ring *ringPt);
+/*! Submit prepared entries, and wait for completions
+ *
+ *  \param waitCount Wait until at least this many completions are
+ *  available, 0 to not wait
+ *  \param timeoutMsec If waiting, maximum milliseconds to wait, or -1
+ *  to wait without timeout
+ *  \return \ref reterr, timing out and interruptions are not errors
+ */
+MCR_API int mcr_Ring_submit(struct mcr_Ring *ringPt, unsigned int waitCount,
+							int timeoutMsec);
+/*! Next available completion
+ *
+ *  \return Null if none available, otherwise call \ref mcr_Ring_seen
+ *  when finished with it
+ */
+MCR_API struct io_uring_cqe *mcr_Ring_cqe(struct mcr_Ring *ringPt);
+/*! Release the completion from \ref mcr_Ring_cqe */
+MCR_API void mcr_Ring_seen(struct mcr_Ring *ringPt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+/* Libmacro - A multi-platform, extendable macro and hotkey C library
+  Copyright (C) 2013 Jonathan Pelletier, New Paradigm Software
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*! \file
+ *  \brief Trace - Captured evdev events of one device, to replay into
+ *  intercept without devices or privileges.
+ *
+ *  A trace is a \ref mcr_TraceHeader followed by raw input_event
+ *  records, in the byte order and struct layout of the capturing system.
+ */
+
+#ifndef MCR_INTERCEPT_LNX_NTRACE_H_
+#define MCR_INTERCEPT_LNX_NTRACE_H_
+
+#include "mcr/intercept/linux/p_grabber.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! First bytes of a trace */
+#define MCR_TRACE_MAGIC "MCRTRACE"
+/*! Trace format version */
+#define MCR_TRACE_VERSION 1
+
+/*! Start of a trace, describing the device */
+struct mcr_TraceHeader {
+	/*! \ref MCR_TRACE_MAGIC, not null-terminated */
+	char magic[8];
+	/*! \ref MCR_TRACE_VERSION */
+	uint32_t version;
+	/*! sizeof(struct input_event) of the capturing system */
+	uint32_t event_size;
+	/*! Clock of captured event times */
+	int32_t clock_id;
+	/*! Unused, 0 */
+	uint32_t reserved;
+	/*! Device capabilities when captured */
+	struct mcr_GrabberCapabilities capabilities;
+};
+
+/*! Write a trace header
+ *
+ *  \param capsPt \ref opt Device capabilities
+ *  \param clockId Clock of event times that will be written
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Trace_write_header(int fd,
+								   const struct mcr_GrabberCapabilities *capsPt, int clockId);
+/*! Read and validate a trace header
+ *
+ *  \return \ref reterr, EPROTO if not a trace readable by this system
+ */
+MCR_API int mcr_Trace_read_header(int fd, struct mcr_TraceHeader *headerPt);
+/*! Copy a trace to a file, pipe or socket, for
+ *  \ref mcr_intercept_add_replay to read from the other end.
+ *
+ *  Event times are replaced with the current CLOCK_MONOTONIC time when
+ *  written, so intercept latencies measure replay and not capture.
+ *  This blocks until the end of the trace, run it in a separate thread
+ *  when replaying into a pipe.
+ *  \param traceFd Trace to read from, starting with the header
+ *  \param outFd Destination, the header is also written
+ *  \param realTime If true, wait between frames as long as when captured.
+ *  If false, write as fast as possible.
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Trace_replay(int traceFd, int outFd, bool realTime);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -34,15 +34,8 @@
 	#define MCR_THREAD_MAX 0x10
 #endif
 
-#ifndef MCR_MACRO_JOIN_TIMEOUT
-	/*! Seconds to wait for macros to respond when they are being
-	*  interrupted or paused
-	*/
-	#define MCR_MACRO_JOIN_TIMEOUT 2
-#endif
-
 #ifndef MCR_MAX_PAUSE_COUNT
-	/*! The number of times a macro will wait while paused until it resumes
+	/*! The number of seconds a macro will wait while paused until it resumes
 	*/
 	#define MCR_MAX_PAUSE_COUNT 5
 #endif
@@ -50,6 +50,55 @@ enum mcr_Interrupt {
 	MCR_DISABLE
 };
 
+/*! State of a \ref mcr_MacroThread */
+enum mcr_MacroThreadState {
+	/*! No thread exists, available to start a new thread */
+	MCR_THREAD_IDLE = 0,
+	/*! Thread is executing the macro */
+	MCR_THREAD_RUNNING,
+	/*! Thread has completed, but is not yet joined */
+	MCR_THREAD_FINISHED
+};
+
+/*! What to do with a trigger when all \ref mcr_Macro.thread_max threads
+ *  are running */
+enum mcr_MacroQueuePolicy {
+	/*! Trigger is dropped */
+	MCR_QUEUE_DROP = 0,
+	/*! Repeated triggers are merged into one pending execution */
+	MCR_QUEUE_MERGE,
+	/*! Trigger is queued, up to \ref mcr_Macro.queue_max pending
+	 *  executions */
+	MCR_QUEUE_LIMIT
+};
+
+/*! Counters of triggering and executing a \ref mcr_Macro */
+struct mcr_MacroStats {
+	/*! Number of times triggered while able to trigger */
+	unsigned long long triggers;
+	/*! Triggers dropped or merged by \ref mcr_Macro.queue_policy */
+	unsigned long long coalesced;
+	/*! Number of times the signal set has started sending */
+	unsigned long long executions;
+};
+
+struct mcr_Macro;
+/*! One joinable execution of a \ref mcr_Macro
+ *
+ *  Threads are joined when a finished thread slot is reused, and
+ *  when the macro is disabled with \ref mcr_Macro_disable_confirmed.
+ */
+struct mcr_MacroThread {
+	/*! Macro being executed */
+	struct mcr_Macro *macro;
+	/*! Thread handle, valid if not \ref MCR_THREAD_IDLE */
+	thrd_t thread;
+	/*! \ref mcr_MacroThreadState */
+	int state;
+	/*! This thread has consumed an \ref MCR_INTERRUPT */
+	bool interrupted;
+};
+
 /*! A macro, when triggered, will send all its signals */
 struct mcr_Macro {
 	/*! This will be the blocking
@@ -63,6 +112,17 @@ struct mcr_Macro {
 	 *
 	 *  Any value greater than \ref MCR_THREAD_MAX will be ignored. */
 	unsigned int thread_max;
+	/*! \ref mcr_MacroQueuePolicy when triggered with all threads
+	 *  running.  Default \ref MCR_QUEUE_DROP */
+	int queue_policy;
+	/*! Maximum pending executions for \ref MCR_QUEUE_LIMIT */
+	unsigned int queue_max;
+	/*! Scheduling applied by each macro thread when it starts, see
+	 *  \ref mcr_Macro_set_thread_options */
+	struct mcr_ThreadOptions thread_options;
+	/*! Output of all signals sent by this macro, see
+	 *  \ref mcr_output_add.  Default 0 uses routes of signal types. */
+	unsigned int output;
 
 	/* Internal */
 	/*! See \ref mcr_Macro_interrupt */
@@ -73,10 +133,21 @@ struct mcr_Macro {
 	struct mcr_Array signal_set;
 	/*! Current number of threads created from macro being triggered */
 	int thread_count;
-	/*! Wait for thread_count changes. */
+	/*! Notified for thread_count and interruptor changes. */
 	cnd_t thread_count_cnd;
-	/*! Current number of times the macro has been triggered. */
+	/*! Current number of pending executions. */
 	unsigned queued;
+	/*! Trigger and execution counters, see \ref mcr_Macro_stats */
+	struct mcr_MacroStats stats;
+	/*! Error of the last thread applying thread_options, or 0 if
+	 *  applied successfully. */
+	int thread_options_error;
+	/*! Lock for thread_count, queued, stats, and thread states.  Also
+	 *  used to wait on thread_count_cnd. */
+	mtx_t lock;
+	/*! Execution threads, at most \ref mcr_Macro.thread_max are
+	 *  running. */
+	struct mcr_MacroThread threads[MCR_THREAD_MAX];
 };
 
 /*! Data interface of macro structures
@@ -109,6 +180,44 @@ MCR_API int mcr_Macro_deinit(void *mcrPt);
 MCR_API int mcr_Macro_set_all(struct mcr_Macro *mcrPt,
 							  bool blocking, bool sticky, unsigned int threadMax, bool enable,
 							  struct mcr_context *ctx);
+/*! Set what to do when triggered while all threads are running.
+ *
+ *  \param policy \ref mcr_Macro.queue_policy
+ *  \param queueMax \ref mcr_Macro.queue_max, only used for
+ *  \ref MCR_QUEUE_LIMIT
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Macro_set_queue_policy(struct mcr_Macro *mcrPt,
+									   enum mcr_MacroQueuePolicy policy, unsigned int queueMax);
+/*! Get a consistent copy of trigger and execution counters.
+ *
+ *  \param statsOut Copy of \ref mcr_Macro.stats
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Macro_stats(struct mcr_Macro *mcrPt,
+							struct mcr_MacroStats *statsOut);
+/*! Set all trigger and execution counters to 0.
+ *
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Macro_reset_stats(struct mcr_Macro *mcrPt);
+/*! Set scheduling options for threads started after this call.
+ *
+ *  Threads which cannot apply an option will still run with default
+ *  scheduling.  See \ref mcr_Macro_thread_options_error
+ *  \param optionsPt \ref opt \ref mcr_Macro.thread_options, null
+ *  to reset to defaults
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Macro_set_thread_options(struct mcr_Macro *mcrPt,
+		const struct mcr_ThreadOptions *optionsPt);
+/*! Why the last macro thread was not able to apply
+ *  \ref mcr_Macro.thread_options, e.g. EPERM without real-time privileges.
+ *
+ *  \return Error number from \ref mcr_thrd_set_options, or 0 if
+ *  all options were applied
+ */
+MCR_API int mcr_Macro_thread_options_error(struct mcr_Macro *mcrPt);
 /*! Copy a macro
  *
  *  \param dstPt \ref mcr_Macro * Destination macro
@@ -203,11 +312,54 @@ MCR_API bool mcr_Macro_is_enabled(const struct mcr_Macro *mcrPt);
  */
 MCR_API int mcr_Macro_set_enabled(struct mcr_Macro *mcrPt, bool enable);
 /*! Disable and wait in current thread to confirm disable completed.
+ *
+ *  Running threads are woken from \ref mcr_Macro_sleep and pauses, and will
+ *  cancel before sending the next signal.  All threads are joined before
+ *  returning.  If called from a thread executing this macro, that thread
+ *  is not waited on.
  *
  *  Use before modifying signal set, C++ deconstructors, and program exit.
  *  \return \ref reterr
  */
 MCR_API int mcr_Macro_disable_confirmed(struct mcr_Macro *mcrPt);
+/*! Get the macro being executed by the current thread.
+ *
+ *  \return Macro executing in the current thread, or null if this is not
+ *  a macro thread
+ */
+MCR_API struct mcr_Macro *mcr_Macro_current();
+/*! Set the execution run by the current thread, for executors that run
+ *  macros without macro threads.
+ *
+ *  Disabling or interrupting that macro from the current thread will not
+ *  wait for itself to finish.
+ *  \param threadPt \ref opt Execution state, which must be counted in
+ *  \ref mcr_Macro.thread_count.  Null when the current thread is done
+ *  executing.
+ */
+MCR_API void mcr_Macro_set_current(struct mcr_MacroThread *threadPt);
+/*! Set a function to call when any macro interruptor is changed by
+ *  \ref mcr_Macro_interrupt or \ref mcr_Macro_disable_confirmed, for
+ *  executors that do not wait on \ref mcr_Macro.thread_count_cnd.
+ *
+ *  The listener is called with \ref mcr_Macro.lock locked, and must not
+ *  lock the macro.
+ *  \param listener \ref opt Process-wide listener, or null for none
+ */
+MCR_API void mcr_Macro_set_interrupt_listener(void (*listener)(
+			struct mcr_Macro *mcrPt));
+/*! Cancellation point, sleep the current thread.
+ *
+ *  If the current thread is executing a macro, the sleep will end early
+ *  when that macro is interrupted or disabled.
+ *  \param duration Time to sleep
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Macro_sleep(const struct timespec *duration);
+/*! True if the current thread is executing a macro that has been
+ *  interrupted or disabled, so long signals may end early
+ */
+MCR_API bool mcr_Macro_is_interrupted(void);
 /*! Send all signals in current thread.
  *
  *  Any interrupt besides MCR_CONTINUE will complete this function and return.
@@ -50,7 +50,8 @@ MCR_API int mcr_HidEcho_send(struct mcr_Signal *signalPt);
  *  \ref mcr_is_platform
  *  \return \ref reterr
  */
-MCR_API int mcr_HidEcho_send_data(struct mcr_HidEcho *dataPt);
+MCR_API int mcr_HidEcho_send_data(struct mcr_context *ctx,
+								  struct mcr_HidEcho *dataPt);
 /* Default init, deinit, copy, compare */
 
 /* Echo names */
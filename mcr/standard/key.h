@@ -57,7 +57,8 @@ MCR_API int mcr_Key_send(struct mcr_Signal *sigPt);
  *  \ref mcr_is_platform
  *  \return \ref reterr
  */
-MCR_API int mcr_Key_send_data(struct mcr_Key *dataPt);
+MCR_API int mcr_Key_send_data(struct mcr_context *ctx,
+							  struct mcr_Key *dataPt);
 /* Default init, deinit, compare, and copy */
 
 /* Key names */
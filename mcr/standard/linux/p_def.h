@@ -37,11 +37,34 @@
 	/*! Default value for device input event path when library is built. */
 	#define MCR_EVENT_PATH /dev/input
 #endif
+#ifndef MCR_SYSFS_INPUT_PATH
+	/*! sysfs directory of uinput devices, named by UI_GET_SYSNAME */
+	#define MCR_SYSFS_INPUT_PATH /sys/devices/virtual/input
+#endif
 /*! Default value for \ref mcr_AbsDev resolution when library is built.
  *  Default is 4095, or 0x0FFF
  */
 #ifndef MCR_ABS_RESOLUTION
 	#define MCR_ABS_RESOLUTION 0x0FFF
 #endif
+/*! Maximum events buffered by one thread between output flushes,
+ *  see \ref mcr_output_begin */
+#ifndef MCR_OUTPUT_LENGTH
+	#define MCR_OUTPUT_LENGTH 256
+#endif
+/*! Maximum outputs, including the default output, see
+ *  \ref mcr_output_add */
+#ifndef MCR_OUTPUT_MAX
+	#define MCR_OUTPUT_MAX 16
+#endif
+/*! High resolution wheel units of one wheel detent */
+#define MCR_WHEEL_HI_RES 120
+/* Kernel headers before 5.0 */
+#ifndef REL_WHEEL_HI_RES
+	#define REL_WHEEL_HI_RES 0x0b
+#endif
+#ifndef REL_HWHEEL_HI_RES
+	#define REL_HWHEEL_HI_RES 0x0c
+#endif
 
 #endif
@@ -33,46 +33,153 @@
 extern "C" {
 #endif
 
+/*! When events sent to a \ref mcr_Device are written */
+enum mcr_FlushPolicy {
+	/*! Buffered until the thread flushes, see \ref mcr_output_begin.
+	 *  Written immediately if not buffering.  Default. */
+	MCR_FLUSH_BATCHED = 0,
+	/*! Buffered until the end of a frame, SYN_REPORT */
+	MCR_FLUSH_FRAME,
+	/*! Always written immediately */
+	MCR_FLUSH_IMMEDIATE
+};
+
+/*! Where a \ref mcr_Device writes events, see \ref mcr_Device_set_sink */
+enum mcr_SinkType {
+	/*! Written to the uinput device, default */
+	MCR_SINK_UINPUT = 0,
+	/*! Discarded */
+	MCR_SINK_NULL,
+	/*! Counted and discarded */
+	MCR_SINK_COUNT,
+	/*! Counted, and the most recent events kept in memory */
+	MCR_SINK_RING
+};
+
+/*! Bytes of a bit array for count codes */
+#define MCR_DEVICE_BYTES(count) (((count) + 7) / 8)
+/*! True if a code is set in a bit array */
+#define MCR_DEVICE_ISSET(bitArr, code) \
+(!!((bitArr)[(code) / 8] & (1 << ((code) % 8))))
+
+/*! Codes a uinput device is created with, one bit per code for each
+ *  UI_SET_*BIT type */
+struct mcr_DeviceCapabilities {
+	unsigned char ev[MCR_DEVICE_BYTES(EV_CNT)];
+	unsigned char key[MCR_DEVICE_BYTES(KEY_CNT)];
+	unsigned char rel[MCR_DEVICE_BYTES(REL_CNT)];
+	unsigned char abs[MCR_DEVICE_BYTES(ABS_CNT)];
+	unsigned char msc[MCR_DEVICE_BYTES(MSC_CNT)];
+	unsigned char led[MCR_DEVICE_BYTES(LED_CNT)];
+	unsigned char snd[MCR_DEVICE_BYTES(SND_CNT)];
+	unsigned char ff[MCR_DEVICE_BYTES(FF_CNT)];
+	unsigned char sw[MCR_DEVICE_BYTES(SW_CNT)];
+	unsigned char prop[MCR_DEVICE_BYTES(INPUT_PROP_CNT)];
+};
+
+/*! Counts of events written to a sink */
+struct mcr_SinkCounts {
+	/*! Number of writes, one for each unbuffered send or flush */
+	size_t writes;
+	/*! Bytes of all events written */
+	size_t bytes;
+	/*! Number of events of each type */
+	size_t types[EV_CNT];
+};
+
+/*! Events of a device written to memory instead of uinput, to
+ *  benchmark and test sending without uinput */
+struct mcr_DeviceSink {
+	/*! \ref mcr_SinkType */
+	int type;
+	/*! Counted for \ref MCR_SINK_COUNT and \ref MCR_SINK_RING */
+	struct mcr_SinkCounts counts;
+	/*! \ref MCR_SINK_RING events, oldest are overwritten when full */
+	struct input_event *ring;
+	/*! Number of events ring holds */
+	size_t capacity;
+	/*! Number of events written to ring */
+	size_t head;
+	/*! Number of events read from ring */
+	size_t tail;
+};
+
 /*! Linux - Wrapper for uinput devices. */
 struct mcr_Device {
-	/*! Create a device and write to it */
+	/*! Name, id, and absolute axis ranges of the device to create,
+	 *  with UI_DEV_SETUP and UI_ABS_SETUP, or written directly to
+	 *  uinput versions without them. */
 	struct uinput_user_dev device;
-	/*! int => mcr_Array, input type to input bit array */
-	struct mcr_Map type_value_map;
+	/*! Set with \ref mcr_Device_set_bits */
+	struct mcr_DeviceCapabilities capabilities;
 	/*! File descriptor to write input_events */
 	int fd;
 	/*! File descriptor for event node, to ioctl and read from */
 	int event_fd;
 	/*! false disabled, otherwise can write events to fd */
 	bool enabled;
+	/*! Writes and changes of fd, so devices are written without
+	 *  waiting for each other */
+	mtx_t lock;
+	/*! \ref mcr_FlushPolicy */
+	int flush_policy;
+	/*! Open with O_SYNC, applied when enabled.  Default false.
+	 *
+	 *  uinput handles events when written, so this only changes
+	 *  writes to other files. */
+	bool synchronous;
+	/*! If not \ref MCR_SINK_UINPUT, events are written to the sink
+	 *  instead of fd, and the device does not need to be enabled. */
+	struct mcr_DeviceSink sink;
 };
 
-/* Non-static to inline write function. */
-/*! Linux - To send non-absolute events. */
-extern MCR_API struct mcr_Device mcr_genDev;
-/*! Linux - To send MoveCursor unjustified */
-extern MCR_API struct mcr_Device mcr_absDev;
+/*! Linux - Generic and absolute devices of one output, see
+ *  \ref mcr_output_add */
+struct mcr_OutputDevice {
+	/*! To send non-absolute events */
+	struct mcr_Device *gen;
+	/*! To send MoveCursor unjustified */
+	struct mcr_Device *abs;
+	/*! Devices have been enabled or failed to enable.  Devices of an
+	 *  added output are enabled at first use. */
+	volatile bool created;
+};
+
+struct mcr_context;
+
 /*! Linux - Append similar input_event to the end of all sending of events. */
 extern MCR_API const struct input_event mcr_syncer;
-/*! Linux - Resolution of absolute devices */
-extern MCR_API __s32 mcr_abs_resolution;
 
-/*! Linux - Set the uinput file to read and write uinput devices
+/*! Linux - Set the uinput file to read and write uinput devices, for
+ *  all contexts
  *
  *  \return \ref reterr
  */
 MCR_API int mcr_Device_set_uinput_path(const char *path);
-/*! Linux - Set the directory event files are located in
+/*! Linux - Set the directory event files are located in, for all
+ *  contexts
  *
  *  Event files are used to read device state
  *  \return \ref reterr
  */
 MCR_API int mcr_Device_set_event_path(const char *directoryPath);
-/*! Linux - Set absolute device resolution
+/*! Linux - Generic device of the default output, to send non-absolute
+ *  events */
+MCR_API struct mcr_Device *mcr_Device_gen(struct mcr_context *ctx);
+/*! Linux - Absolute device of the default output, to send MoveCursor
+ *  unjustified */
+MCR_API struct mcr_Device *mcr_Device_abs(struct mcr_context *ctx);
+/*! Linux - Resolution of absolute devices */
+MCR_API __s32 mcr_Device_absolute_resolution(struct mcr_context *ctx);
+/*! Linux - Set resolution of all absolute devices of a context
  *
+ *  uinput axis ranges are fixed when a device is created, so each
+ *  enabled absolute device is destroyed and created again.  Nothing is
+ *  done if the resolution is not changed.
  *  \return \ref reterr
  */
-MCR_API int mcr_Device_set_absolute_resolution(__s32 resolution);
+MCR_API int mcr_Device_set_absolute_resolution(struct mcr_context *ctx,
+		__s32 resolution);
 /*! \ref mcr_Device ctor
  *
  *  \param devPt \ref opt \ref mcr_Device *
@@ -88,35 +195,127 @@ MCR_API int mcr_Device_deinit(void *devPt);
 /*! Start or end user device. This will modify fd, event_fd,
  *  and enabled state.
  *
+ *  An enabled device is destroyed and created again.  uinput sets one
+ *  capability bit per ioctl, so creating the generic device is about
+ *  800 ioctls, most of them key bits.
  *  \return \ref reterr
  */
 MCR_API int mcr_Device_enable(struct mcr_Device *devPt, bool enable);
-/*! \ref mcr_Device_enable for all devices
+/*! \ref mcr_Device_enable for devices of the default output
  *
  *  \return \ref reterr
  */
-MCR_API int mcr_Device_enable_all(bool enable);
+MCR_API int mcr_Device_enable_all(struct mcr_context *ctx, bool enable);
 
 /*! Set input bit values for a single bit type.
  *
- *  \param bitType Type of event to set values for
- *  \param bits Set of all values to set for bitType
+ *  Applied the next time the device is enabled.
+ *  \param bitType UI_SET_*BIT of values to set
+ *  \param bits Set of all values to set for bitType, replacing all
+ *  previous values
  *  \param bitLen Length of bits
- *  \return \ref reterr
+ *  \return \ref reterr, EINVAL for an unknown type or out of range
+ *  value
  */
 MCR_API int mcr_Device_set_bits(struct mcr_Device *devPt, int bitType,
 								int *bits, size_t bitLen);
-/*! Get all input bits to be set.
+/*! Set or unset a range of input bit values for a single bit type.
+ *
+ *  \param bitType UI_SET_*BIT of values to set
+ *  \param first First value of the range
+ *  \param count Number of values in the range
+ *  \return \ref reterr, EINVAL for an unknown type or out of range
+ */
+MCR_API int mcr_Device_set_bit_range(struct mcr_Device *devPt, int bitType,
+									 int first, int count, bool enable);
+/*! True if an input bit value is set
  *
- *  \param bitType Type of event to find values for
- *  \return The set of all input bits to be set, or
- *  null if not found.
+ *  \param bitType UI_SET_*BIT of the value
  */
-MCR_API struct mcr_Array *mcr_Device_bits(struct mcr_Device *devPt,
-		int bitType);
+MCR_API bool mcr_Device_has_bit(struct mcr_Device *devPt, int bitType,
+								int value);
+/*! \ref mcr_Device.flush_policy */
+#define mcr_Device_flush_policy(devPt) ((devPt)->flush_policy)
+/*! \ref mcr_Device.flush_policy
+ *
+ *  \param policy \ref mcr_FlushPolicy
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Device_set_flush_policy(struct mcr_Device *devPt,
+										int policy);
+/*! \ref mcr_Device.synchronous, reopening the device if enabled
+ *
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Device_set_synchronous(struct mcr_Device *devPt,
+									   bool synchronous);
+/*! Write events to a sink instead of uinput
+ *
+ *  Sink counts and events are reset.
+ *  \param type \ref mcr_SinkType
+ *  \param capacity Number of events kept by \ref MCR_SINK_RING,
+ *  otherwise ignored
+ *  \return \ref reterr, EINVAL for unknown type or a ring without
+ *  capacity
+ */
+MCR_API int mcr_Device_set_sink(struct mcr_Device *devPt, int type,
+								size_t capacity);
+/*! Copy counts of events written to the sink */
+MCR_API void mcr_Device_sink_counts(struct mcr_Device *devPt,
+									struct mcr_SinkCounts *countsPt);
+/*! Read and remove the oldest events of \ref MCR_SINK_RING
+ *
+ *  Events overwritten before reading are lost.
+ *  \param count Maximum events to read
+ *  \return Number of events read
+ */
+MCR_API size_t mcr_Device_sink_read(struct mcr_Device *devPt,
+									struct input_event *buffer, size_t count);
+/*! Remove sink counts and events */
+MCR_API void mcr_Device_sink_reset(struct mcr_Device *devPt);
+/*! \ref mcr_Device_set_sink for devices of all outputs, including
+ *  outputs added later
+ *
+ *  \return \ref reterr
+ */
+MCR_API int mcr_output_set_sink(struct mcr_context *ctx, int type,
+								size_t capacity);
 /*! Does the device have UI_SET_EVBIT? */
 MCR_API bool mcr_Device_has_evbit(struct mcr_Device *devPt);
 
+/*! Linux - Devices of an output
+ *
+ *  Devices of an added output are enabled if not yet created.
+ *  \param output 0 for \ref mcr_Device_gen and \ref mcr_Device_abs
+ *  \return Output devices, or null if output does not exist
+ */
+MCR_API struct mcr_OutputDevice *mcr_output_device(struct mcr_context *ctx,
+		unsigned int output);
+/*! Linux - Devices for a signal type sent by the current thread
+ *
+ *  The thread route is used if set, then the route of the signal
+ *  type, otherwise the default output.
+ *  \param signalType \ref mcr_OutputSignal
+ *  \return Output devices, never null
+ */
+MCR_API struct mcr_OutputDevice *mcr_output_routed(struct mcr_context *ctx,
+		int signalType);
+/*! Linux - True if a device name is one of the output devices of a
+ *  context.  Output devices are never grabbed by intercept. */
+MCR_API bool mcr_output_is_device_name(struct mcr_context *ctx,
+									   const char *name);
+
+/*! Write input_events, or buffer them if the current thread is
+ *  buffering, see \ref mcr_output_begin
+ *
+ *  Events sent to a device that is not enabled and has no sink are
+ *  discarded.
+ *  \param count Number of input_events
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Device_send(struct mcr_Device *devPt,
+							const struct input_event *events, size_t count);
+
 /* Sending, macro inlined for efficiency. */
 /*! Send input_events to given device.
  *
@@ -126,9 +325,7 @@ MCR_API bool mcr_Device_has_evbit(struct mcr_Device *devPt);
  *  \return \ref reterr
  */
 #define MCR_DEV_SEND(dev, eventObjects, size) \
-((dev).fd == -1 ? \
-	ENXIO : \
-	write((dev).fd, eventObjects, size))
+mcr_Device_send(&(dev), eventObjects, (size) / sizeof(struct input_event))
 
 /*! \ref MCR_DEV_SEND for single input_event.
  *
@@ -143,11 +340,11 @@ MCR_DEV_SEND(dev, eventObject, sizeof (struct input_event))
 #define MCR_DEV_SYNC(dev, success) \
 MCR_DEV_SEND_ONE(dev, &mcr_syncer)
 
-/*! Initialize values for known mcr_Device objects,
+/*! Initialize devices of the default output of a context,
  *  and allocate resources.
  */
 MCR_API int mcr_Device_initialize(struct mcr_context *context);
-/*! Dealocate resources for linux devices. */
+/*! Dealocate all devices of a context. */
 MCR_API int mcr_Device_deinitialize(struct mcr_context *context);
 
 /// \todo dynamic path.
@@ -20,15 +20,119 @@
 #define MCR_STANDARD_LNX_NSTANDARD_H_
 
 #include "mcr/standard/linux/p_device.h"
+#include "mcr/standard/standard.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* In order to inline we cannot privatize this. */
-extern MCR_API struct mcr_Array mcr_echoEvents;
-extern MCR_API struct mcr_Map mcr_keyToEcho[2];
-extern MCR_API mcr_SpacePosition mcr_cursor;
+/*! Linux - Tracked cursor position, read without locking
+ *
+ *  Sequence lock: the sequence is odd while a writer is changing the
+ *  position.  Readers retry if the sequence is odd or changed while
+ *  reading.  Writers are serialized by incrementing the sequence from
+ *  even to odd.
+ */
+struct mcr_CursorState {
+	volatile size_t sequence;
+	volatile long long pos[MCR_DIMENSION_CNT];
+};
+
+/*! Linux standard platform structure, \ref mcr_standard.platform */
+struct mcr_standard_platform {
+	/*! Adding and creating outputs */
+	mtx_t lock;
+	/*! Generic device of the default output */
+	struct mcr_Device gen_dev;
+	/*! Absolute device of the default output */
+	struct mcr_Device abs_dev;
+	/*! Output 0, gen_dev and abs_dev */
+	struct mcr_OutputDevice default_output;
+	/*! Outputs are only added, and removed when deinitialized, so
+	 *  they are read without locking. */
+	struct mcr_OutputDevice *outputs[MCR_OUTPUT_MAX];
+	/*! Number of outputs, including the default output.  Stored with
+	 *  release after the output is added, and loaded with acquire. */
+	unsigned int output_count;
+	/*! Output of each \ref mcr_OutputSignal, 0 if not routed */
+	unsigned int signal_routes[MCR_OUTPUT_SIGNAL_CNT];
+	/*! \ref mcr_SinkType of outputs added later, see
+	 *  \ref mcr_output_set_sink */
+	int sink_type;
+	/*! Ring capacity of outputs added later */
+	size_t sink_capacity;
+	/*! Resolution of absolute devices, default
+	 *  \ref MCR_ABS_RESOLUTION */
+	__s32 abs_resolution;
+	/*! \ref mcr_Key of each echo code */
+	struct mcr_Array echo_events;
+	/*! Key code => echo code, for key down and key up.
+	 *  \ref MCR_ECHO_ANY if a key has no echo. */
+	size_t key_echo[2][KEY_CNT];
+	/*! Last known cursor position */
+	struct mcr_CursorState cursor;
+	/*! Scroll values are high resolution wheel units, see
+	 *  \ref mcr_Scroll_set_hi_res */
+	volatile bool scroll_hi_res;
+	/*! High resolution units scrolled horizontally and vertically,
+	 *  to write a detent for each \ref MCR_WHEEL_HI_RES */
+	long long wheel_total[2];
+};
+
+/*! Linux - Apply a cursor movement to the tracked cursor position
+ *
+ *  Justified movement is added and clamped to the absolute resolution,
+ *  otherwise the position is replaced.  Readers of
+ *  \ref mcr_cursor_position never see a partial update.
+ */
+MCR_API void mcr_cursor_apply(struct mcr_context *ctx,
+							  const struct mcr_MoveCursor *mcPt);
+
+/*! Linux - \ref mcr_standard_platform.scroll_hi_res */
+MCR_API bool mcr_Scroll_is_hi_res(struct mcr_context *ctx);
+/*! Linux - Set units of horizontal and vertical scroll values
+ *
+ *  If enabled, scroll values are 1/\ref MCR_WHEEL_HI_RES of a wheel
+ *  detent and written as REL_WHEEL_HI_RES and REL_HWHEEL_HI_RES.
+ *  REL_WHEEL and REL_HWHEEL are written for each full detent.
+ *  Otherwise scroll values are wheel detents, and both are written.
+ *  Default false.
+ */
+MCR_API void mcr_Scroll_set_hi_res(struct mcr_context *ctx, bool enable);
+
+/*! Set the key sent for an echo code
+ *
+ *  \param keyPt Key code must be less than KEY_CNT
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Echo_set_key(struct mcr_context *ctx, size_t echoCode,
+							 struct mcr_Key *keyPt);
+
+/*! Linux - Echo code of a key
+ *
+ *  \param apply \ref MCR_SET for key down, otherwise key up
+ *  \return \ref MCR_ECHO_ANY if the key has no echo
+ */
+static inline size_t mcr_Key_echo(const struct mcr_standard_platform
+								  *platformPt, int key, enum mcr_ApplyType apply)
+{
+	if (key < 0 || key >= KEY_CNT)
+		return MCR_ECHO_ANY;
+	return platformPt->key_echo[apply == MCR_SET ? 0 : 1][key];
+}
+
+/*! Linux - Key sent for an echo code
+ *
+ *  \return Null if echo code has no key
+ */
+static inline const struct mcr_Key *mcr_Echo_key(const struct
+		mcr_standard_platform *platformPt, size_t echoCode)
+{
+	if (echoCode >= platformPt->echo_events.used)
+		return NULL;
+	return (const struct mcr_Key *)MCR_ARR_ELEMENT(platformPt->echo_events,
+			echoCode);
+}
 
 #ifdef __cplusplus
 }
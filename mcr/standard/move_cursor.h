@@ -54,14 +54,16 @@ MCR_API int mcr_MoveCursor_send(struct mcr_Signal *sigPt);
  *  \ref mcr_is_platform
  *  \return \ref reterr
  */
-MCR_API int mcr_MoveCursor_send_data(struct mcr_MoveCursor *mcPt);
+MCR_API int mcr_MoveCursor_send_data(struct mcr_context *ctx,
+									 struct mcr_MoveCursor *mcPt);
 /* Default init, deinit, compare, and copy */
 
 /*! Current cursor position
  *
  *  \ref mcr_is_platform
  */
-MCR_API void mcr_cursor_position(mcr_SpacePosition buffer);
+MCR_API void mcr_cursor_position(struct mcr_context *ctx,
+								 mcr_SpacePosition buffer);
 /*! If justified then \ref mcr_resembles_justified,
  *  else \ref mcr_resembles_absolute
  *
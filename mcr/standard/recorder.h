@@ -0,0 +1,160 @@
+/* Libmacro - A multi-platform, extendable macro and hotkey C library
+  Copyright (C) 2013 Jonathan Pelletier, New Paradigm Software
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*! \file
+ *  \brief \ref mcr_Recorder - Record intercepted signals into a macro.
+ */
+
+#ifndef MCR_STANDARD_RECORDER_H_
+#define MCR_STANDARD_RECORDER_H_
+
+#include "mcr/standard/key.h"
+#include "mcr/standard/move_cursor.h"
+#include "mcr/standard/scroll.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Default number of recorded signals, before signals are dropped.
+ *
+ *  About 8 seconds of an 8 kHz mouse. */
+#ifndef MCR_RECORDER_CAPACITY
+#define MCR_RECORDER_CAPACITY 0x10000
+#endif
+/*! Default \ref mcr_Recorder.min_delay_msec */
+#ifndef MCR_RECORDER_MIN_DELAY
+#define MCR_RECORDER_MIN_DELAY 1
+#endif
+
+/*! One recorded signal */
+struct mcr_RecordEvent {
+	/*! Monotonic time the signal was dispatched */
+	struct timespec time;
+	/*! Signal type of data */
+	struct mcr_ISignal *isignal;
+	/*! Copy of the signal data */
+	union {
+		struct mcr_Key key;
+		struct mcr_MoveCursor move_cursor;
+		struct mcr_Scroll scroll;
+	} data;
+	/* Internal */
+	/*! Ring sequence, this slot is readable when equal to position + 1 */
+	size_t sequence;
+};
+
+/*! Record intercepted \ref mcr_Key, \ref mcr_MoveCursor, and
+ *  \ref mcr_Scroll signals into a macro.
+ *
+ *  \ref mcr_HidEcho is not recorded.  Intercept dispatches it with the
+ *  \ref mcr_Key of the same event, so one press is recorded once.
+ *
+ *  Recording receives from the generic dispatcher into a preallocated
+ *  lock-free ring.  Receiving does not allocate or lock, and may be
+ *  called from any number of intercept threads.  When the ring is full
+ *  signals are dropped and counted.  \ref mcr_Recorder_to_macro is the
+ *  only reader, and must not be called from more than one thread at
+ *  a time.
+ */
+struct mcr_Recorder {
+	/*! Delays shorter than this many milliseconds are accumulated
+	 *  into the next delay instead of adding a \ref mcr_NoOp */
+	int min_delay_msec;
+
+	/* Internal */
+	/*! Dispatching context */
+	struct mcr_context *ctx;
+	/*! True while receiving from the generic dispatcher */
+	volatile bool recording;
+	/*! Preallocated ring of recorded signals */
+	struct mcr_RecordEvent *ring;
+	/*! Ring length, a power of 2 */
+	size_t capacity;
+	/*! Next position to write */
+	size_t head;
+	/*! Next position to read */
+	size_t tail;
+	/*! Number of signals not recorded because the ring was full */
+	size_t dropped;
+};
+
+/*! \ref mcr_Recorder ctor
+ *
+ *  \param recPt \ref opt \ref mcr_Recorder *
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Recorder_init(void *recPt);
+/*! \ref mcr_Recorder dtor
+ *
+ *  Recording will be stopped.
+ *  \param recPt \ref opt \ref mcr_Recorder *
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Recorder_deinit(void *recPt);
+/*! Set context and allocate the ring.
+ *
+ *  Recording must be stopped.  Recorded signals are discarded.
+ *  \param ctx \ref mcr_Recorder.ctx
+ *  \param capacity Number of signals before signals are dropped, rounded
+ *  up to a power of 2.  0 for \ref MCR_RECORDER_CAPACITY
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Recorder_set_all(struct mcr_Recorder *recPt,
+								 struct mcr_context *ctx, size_t capacity);
+/*! Start or stop receiving from the generic dispatcher.
+ *
+ *  Starting will also enable generic dispatching.
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Recorder_set_enabled(struct mcr_Recorder *recPt,
+									 bool enable);
+/*! \ref mcr_Recorder.recording */
+#define mcr_Recorder_is_enabled(recPt) ((recPt)->recording)
+/*! \ref mcr_Dispatcher_receive_fnc for the generic dispatcher
+ *
+ *  \param recPt \ref mcr_Recorder *
+ *  \param sigPt \ref opt Intercepted signal
+ *  \param mods Ignored
+ *  \return false, never blocks
+ */
+MCR_API bool mcr_Recorder_receive(void *recPt, struct mcr_Signal *sigPt,
+								  unsigned int mods);
+/*! Number of signals recorded and not yet read */
+MCR_API size_t mcr_Recorder_count(struct mcr_Recorder *recPt);
+/*! Number of signals dropped because the ring was full */
+MCR_API size_t mcr_Recorder_dropped(struct mcr_Recorder *recPt);
+/*! Discard all recorded signals, and reset the dropped count. */
+MCR_API void mcr_Recorder_clear(struct mcr_Recorder *recPt);
+/*! Read all recorded signals into the signal set of a macro.
+ *
+ *  A \ref mcr_NoOp is inserted for time between signals.  Recorded signals
+ *  will not be dispatched when the macro is sent.  The macro signals are
+ *  set with one \ref mcr_Macro_set_signals.  Recorded signals are removed
+ *  from the recorder.
+ *  \param mcrPt Macro to set signals into
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Recorder_to_macro(struct mcr_Recorder *recPt,
+								  struct mcr_Macro *mcrPt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -42,7 +42,8 @@ struct mcr_Scroll {
  */
 MCR_API int mcr_Scroll_send(struct mcr_Signal *sigPt);
 /*! \ref mcr_Scroll_send */
-MCR_API int mcr_Scroll_send_data(struct mcr_Scroll *dataPt);
+MCR_API int mcr_Scroll_send_data(struct mcr_context *ctx,
+								 struct mcr_Scroll *dataPt);
 /* Default init, deinit, compare, copy */
 
 /*! Signal interface of \ref mcr_Scroll */
@@ -0,0 +1,89 @@
+/* Libmacro - A multi-platform, extendable macro and hotkey C library
+  Copyright (C) 2013 Jonathan Pelletier, New Paradigm Software
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*! \file
+ *  \brief \ref mcr_Smooth - Scroll or move the cursor over time.
+ */
+
+#ifndef MCR_STANDARD_SMOOTH_H_
+#define MCR_STANDARD_SMOOTH_H_
+
+#include "mcr/standard/def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Scroll or move the cursor a total distance, divided into frames
+ *  sent at a fixed interval.
+ *
+ *  Frames are scheduled from the time sending starts, so time spent
+ *  sending does not delay later frames.  Sent from a macro, frames end
+ *  early if the macro is interrupted.  A macro thread sleeps between
+ *  frames, and \ref mcr::MacroExecutor waits on a timer instead.
+ */
+struct mcr_Smooth {
+	/*! Total distance of all frames, scrolled or moved relative to the
+	 *  current cursor position */
+	mcr_Dimensions dm;
+	/*! If true scroll, otherwise move the cursor */
+	bool is_scroll;
+	/*! Number of frames, 0 is the same as 1 */
+	unsigned int frames;
+	/*! Microseconds between frames */
+	unsigned int interval_usec;
+};
+
+/*! Set all values */
+MCR_API void mcr_Smooth_set_all(struct mcr_Smooth *smPt,
+								const mcr_Dimensions dm, bool isScroll, unsigned int frames,
+								unsigned int intervalUsec);
+/*! \pre Signal has data member \ref mcr_Smooth
+ *  \brief Send interpolated \ref mcr_Scroll or \ref mcr_MoveCursor
+ *  frames
+ *
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Smooth_send(struct mcr_Signal *sigPt);
+/*! \ref mcr_Smooth_send */
+MCR_API int mcr_Smooth_send_data(struct mcr_context *ctx,
+								 struct mcr_Smooth *smPt);
+/*! Send one frame without waiting
+ *
+ *  \param frame 1 to \ref mcr_Smooth.frames, this frame reaches its
+ *  part of the total distance
+ *  \return \ref reterr
+ */
+MCR_API int mcr_Smooth_send_frame(struct mcr_context *ctx,
+								  const struct mcr_Smooth *smPt, unsigned int frame);
+/* Default init, deinit, compare, and copy */
+
+/*! Signal interface of \ref mcr_Smooth */
+MCR_API struct mcr_ISignal *mcr_iSmooth(struct mcr_context *ctx);
+/*! Signal data casted \ref mcr_Smooth * */
+#define mcr_Smooth_data(sigPt) \
+mcr_castpt(struct mcr_Smooth, mcr_Instance_data(sigPt))
+/*! Signal data casted \ref mcr_Smooth * */
+#define MCR_SMOOTH_DATA(sig) \
+mcr_castpt(struct mcr_Smooth, (sig).instance.data.data)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -22,9 +22,10 @@
  *  \ref mcr_standard - Standard signal and trigger types module
  *  \ref mcr_Signal data types: \ref mcr_HidEcho,
  *  \ref mcr_Key, \ref mcr_Modifier, \ref mcr_MoveCursor, \ref mcr_NoOp,
- *  and \ref mcr_Scroll \n
+ *  \ref mcr_Scroll, and \ref mcr_Smooth \n
  *  \ref mcr_ISignal: \ref mcr_iHidEcho, \ref mcr_iKey,
- *  \ref mcr_iMoveCursor, \ref mcr_iNoOp, and \ref mcr_iScroll\n
+ *  \ref mcr_iMoveCursor, \ref mcr_iNoOp, \ref mcr_iScroll, and
+ *  \ref mcr_iSmooth\n
  *  \n
  *  \ref mcr_Trigger date types: \ref mcr_Action, \ref mcr_Staged\n
  *  \ref mcr_ITrigger: \ref mcr_iAction, \ref mcr_iStaged
@@ -40,6 +41,8 @@
 #include "mcr/standard/move_cursor.h"
 #include "mcr/standard/noop.h"
 #include "mcr/standard/scroll.h"
+#include "mcr/standard/smooth.h"
+#include "mcr/standard/recorder.h"
 #include "mcr/standard/action.h"
 #include "mcr/standard/staged.h"
 
@@ -71,6 +74,7 @@ struct mcr_standard {
 	struct mcr_ISignal imove_cursor;
 	struct mcr_ISignal inoop;
 	struct mcr_ISignal iscroll;
+	struct mcr_ISignal ismooth;
 	/* Key dispatch */
 	struct mcr_CtxDispatcher key_dispatcher;
 	/* down, up, generic is set into both */
@@ -92,6 +96,8 @@ struct mcr_standard {
 	mcr_String key_name_any;
 	struct mcr_StringIndex echo_name_index;
 	mcr_String echo_name_any;
+	/*! Platform data, e.g. devices and cursor tracking */
+	void *platform;
 };
 
 /* Platform signal */
@@ -99,10 +105,80 @@ struct mcr_HidEcho;
 struct mcr_Key;
 struct mcr_MoveCursor;
 struct mcr_Scroll;
-MCR_API int mcr_HidEcho_send_data(struct mcr_HidEcho *dataPt);
-MCR_API int mcr_Key_send_data(struct mcr_Key *dataPt);
-MCR_API int mcr_MoveCursor_send_data(struct mcr_MoveCursor *dataPt);
-MCR_API int mcr_Scroll_send_data(struct mcr_Scroll *dataPt);
+MCR_API int mcr_HidEcho_send_data(struct mcr_context *ctx,
+								  struct mcr_HidEcho *dataPt);
+MCR_API int mcr_Key_send_data(struct mcr_context *ctx,
+							  struct mcr_Key *dataPt);
+MCR_API int mcr_MoveCursor_send_data(struct mcr_context *ctx,
+									 struct mcr_MoveCursor *dataPt);
+MCR_API int mcr_Scroll_send_data(struct mcr_context *ctx,
+								 struct mcr_Scroll *dataPt);
+
+/*! Buffer events sent by the current thread, and write them together
+ *  at \ref mcr_output_flush or \ref mcr_output_end.
+ *
+ *  Sending to a different device first flushes events of the previous
+ *  one, so events are always written in order.  Calls may be nested,
+ *  and only the outermost \ref mcr_output_end flushes.
+ *  \param mergeFrames If true, a synchronization between sent signals
+ *  is removed unless the next signal changes a key or absolute axis of
+ *  the same frame.  Merging continues until the \ref mcr_output_end of
+ *  this call, including nested calls.
+ */
+MCR_API void mcr_output_begin(bool mergeFrames);
+/*! Write all events buffered by the current thread, and continue
+ *  buffering
+ *
+ *  \return \ref reterr
+ */
+MCR_API int mcr_output_flush(void);
+/*! End \ref mcr_output_begin, and flush if this is the outermost call
+ *
+ *  \return \ref reterr
+ */
+MCR_API int mcr_output_end(void);
+/*! True if the current thread is buffering events */
+MCR_API bool mcr_output_is_buffering(void);
+
+/*! Signal types that can be routed to an output, see
+ *  \ref mcr_output_set_signal_route */
+enum mcr_OutputSignal {
+	MCR_OUTPUT_HID_ECHO = 0,
+	MCR_OUTPUT_KEY,
+	MCR_OUTPUT_MOVE_CURSOR,
+	MCR_OUTPUT_SCROLL,
+	/*! Number of routed signal types */
+	MCR_OUTPUT_SIGNAL_CNT
+};
+
+/*! Add another output, with its own devices and write locks.
+ *
+ *  Output 0 always exists, and is used if nothing is routed.  Devices
+ *  of the new output are created when first written to.
+ *  \param outputPt Set to the new output
+ *  \return \ref reterr, ENOTSUP if the platform has only one output,
+ *  ENOSPC if there are already \ref MCR_OUTPUT_MAX outputs
+ */
+MCR_API int mcr_output_add(struct mcr_context *ctx, unsigned int *outputPt);
+/*! Number of outputs, including output 0 */
+MCR_API unsigned int mcr_output_count(struct mcr_context *ctx);
+/*! Route all signals of one type to an output
+ *
+ *  \param isigPt Standard signal type of ctx, HidEcho, Key,
+ *  MoveCursor or Scroll
+ *  \param output Output to send to, 0 to remove the route
+ *  \return \ref reterr, EINVAL if the signal type is not routed,
+ *  ENOENT if output does not exist
+ */
+MCR_API int mcr_output_set_signal_route(struct mcr_context *ctx,
+										struct mcr_ISignal *isigPt, unsigned int output);
+/*! Route all signals sent by the current thread to an output,
+ *  before routes of signal types.  Used by \ref mcr_Macro.output
+ *
+ *  \param output Output to send to, 0 to remove the route
+ *  \return Previous route of the thread
+ */
+MCR_API unsigned int mcr_output_set_thread_route(unsigned int output);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,72 @@
+/* Libmacro - A multi-platform, extendable macro and hotkey C library
+  Copyright (C) 2013 Jonathan Pelletier, New Paradigm Software
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*! \file
+ *  \brief Minimal atomic operations on size_t, for lock-free
+ *  structures shared with intercept threads.
+ *
+ *  Only size_t is supported, which is enough for ring indices and
+ *  counters, and keeps structures using it usable from C++.
+ */
+
+#ifndef MCR_UTIL_ATOMIC_H_
+#define MCR_UTIL_ATOMIC_H_
+
+#include "mcr/util/def.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#ifdef _WIN64
+	#define mcr_atomic_fetch_add(sizePt, value) \
+	mcr_cast(size_t, _InterlockedExchangeAdd64( \
+		mcr_castpt(volatile __int64, sizePt), mcr_cast(__int64, value)))
+	#define mcr_atomic_cas(sizePt, expected, desired) \
+	(_InterlockedCompareExchange64(mcr_castpt(volatile __int64, sizePt), \
+		mcr_cast(__int64, desired), mcr_cast(__int64, expected)) == \
+	mcr_cast(__int64, expected))
+#else
+	#define mcr_atomic_fetch_add(sizePt, value) \
+	mcr_cast(size_t, _InterlockedExchangeAdd( \
+		mcr_castpt(volatile long, sizePt), mcr_cast(long, value)))
+	#define mcr_atomic_cas(sizePt, expected, desired) \
+	(_InterlockedCompareExchange(mcr_castpt(volatile long, sizePt), \
+		mcr_cast(long, desired), mcr_cast(long, expected)) == \
+	mcr_cast(long, expected))
+#endif
+/* MSVC volatile has acquire and release semantics. */
+#define mcr_atomic_load(sizePt) (*mcr_castpt(volatile size_t, sizePt))
+#define mcr_atomic_store(sizePt, value) \
+(*mcr_castpt(volatile size_t, sizePt) = (value))
+#else
+/*! Add to value and return the previous value, sequentially consistent */
+#define mcr_atomic_fetch_add(sizePt, value) \
+__atomic_fetch_add(sizePt, value, __ATOMIC_SEQ_CST)
+/*! If value is expected, replace with desired.
+ *
+ *  \return True if replaced
+ */
+#define mcr_atomic_cas(sizePt, expected, desired) \
+__sync_bool_compare_and_swap(sizePt, expected, desired)
+/*! Load with acquire semantics */
+#define mcr_atomic_load(sizePt) __atomic_load_n(sizePt, __ATOMIC_ACQUIRE)
+/*! Store with release semantics */
+#define mcr_atomic_store(sizePt, value) \
+__atomic_store_n(sizePt, value, __ATOMIC_RELEASE)
+#endif
+
+#endif
@@ -119,7 +119,9 @@ MCR_API int cnd_signal(cnd_t * cond);
 MCR_API int cnd_broadcast(cnd_t * cond);
 /*! Pre: mutex must be mtx_plain. */
 MCR_API int cnd_wait(cnd_t * cond, mtx_t * mutex);
-/*! Pre: mutex must be mtx_plain. */
+/*! Pre: mutex must be mtx_plain.
+ *
+ *  time_point is an absolute TIME_UTC time, as C11 cnd_timedwait. */
 MCR_API int cnd_timedwait(cnd_t * __restrict cond, mtx_t * __restrict mutex,
 						  const struct timespec *__restrict time_point);
 MCR_API void cnd_destroy(cnd_t * cond);
@@ -37,6 +37,52 @@ extern "C" {
  */
 MCR_API int mcr_privilege_deactivate();
 
+/*! Scheduling policy for \ref mcr_ThreadOptions */
+enum mcr_ThreadPolicy {
+	/*! Do not change scheduling */
+	MCR_SCHED_DEFAULT = 0,
+	/*! Real-time first in, first out */
+	MCR_SCHED_FIFO,
+	/*! Real-time round robin */
+	MCR_SCHED_RR
+};
+
+/*! Scheduling options applied by a thread to itself when it starts.
+ *
+ *  All zero is the default, and does not change anything.
+ */
+struct mcr_ThreadOptions {
+	/*! \ref mcr_ThreadPolicy */
+	int policy;
+	/*! Real-time priority, only used for \ref MCR_SCHED_FIFO and
+	 *  \ref MCR_SCHED_RR */
+	int priority;
+	/*! CPU affinity, bit index is the CPU index.  0 will not change
+	 *  affinity. */
+	unsigned long long cpu_mask;
+	/*! Lock all current and future process memory into RAM */
+	bool lock_memory;
+};
+
+/*! Apply scheduling options to the current thread.
+ *
+ *  Every option is attempted, even if a previous option failed.  A failed
+ *  option leaves the thread with its previous scheduling, and the error
+ *  of the first failure is returned.  EPERM is returned without the
+ *  privilege to use real-time scheduling or lock memory, EINVAL for an
+ *  out-of-range priority or CPU, and ENOTSUP if the platform has no
+ *  support for that option.
+ *
+ *  \ref mcr_is_platform
+ *  \param optionsPt \ref opt Options to apply
+ *  \return \ref reterr
+ */
+MCR_API int mcr_thrd_set_options(const struct mcr_ThreadOptions *optionsPt);
+/*! \ref mcr_ThreadOptions has at least one option set */
+#define mcr_ThreadOptions_isset(optionsPt) \
+((optionsPt)->policy != MCR_SCHED_DEFAULT || (optionsPt)->cpu_mask || \
+(optionsPt)->lock_memory)
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,745 @@
+/* Libmacro - A multi-platform, extendable macro and hotkey C library
+  Copyright (C) 2013 Jonathan Pelletier, New Paradigm Software
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "mcr/extras/extras.h"
+
+#include "mcr/extras/isignal.h"
+#include "mcr/libmacro.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#if MCR_EXECUTOR_COROUTINES
+	#include <coroutine>
+#endif
+
+namespace mcr
+{
+typedef std::chrono::steady_clock Clock;
+
+static MacroExecutor *_lastExecutor = nullptr;
+static const std::chrono::seconds _maxPause(MCR_MAX_PAUSE_COUNT);
+
+#if MCR_EXECUTOR_COROUTINES
+/* One macro execution, suspended at the start and at each timer. */
+struct TaskCoroutine {
+	struct promise_type {
+		TaskCoroutine get_return_object()
+		{
+			return TaskCoroutine(
+					   std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+		std::suspend_always initial_suspend() noexcept
+		{
+			return {};
+		}
+		std::suspend_always final_suspend() noexcept
+		{
+			return {};
+		}
+		void return_void()
+		{
+		}
+		void unhandled_exception()
+		{
+			dmsg;
+		}
+	};
+	std::coroutine_handle<promise_type> handle;
+
+	TaskCoroutine(std::coroutine_handle<promise_type> h = nullptr)
+		: handle(h)
+	{
+	}
+	TaskCoroutine(const TaskCoroutine &) = delete;
+	TaskCoroutine(TaskCoroutine &&copytron)
+		: handle(copytron.handle)
+	{
+		copytron.handle = nullptr;
+	}
+	~TaskCoroutine()
+	{
+		if (handle)
+			handle.destroy();
+	}
+	TaskCoroutine &operator =(const TaskCoroutine &) = delete;
+	TaskCoroutine &operator =(TaskCoroutine &&copytron)
+	{
+		if (&copytron != this) {
+			if (handle)
+				handle.destroy();
+			handle = copytron.handle;
+			copytron.handle = nullptr;
+		}
+		return *this;
+	}
+};
+#endif
+
+struct ExecutorTask {
+	/* Counted in macro thread_count while this task exists */
+	mcr_MacroThread thread;
+	/* Read without the executor lock by the running thread */
+	std::atomic<bool> canceled;
+	/* Resume after this time */
+	Clock::time_point wake;
+	/* Waiting for the macro to continue, or until pauseEnd */
+	bool paused;
+	Clock::time_point pauseEnd;
+#if MCR_EXECUTOR_COROUTINES
+	TaskCoroutine coroutine;
+#else
+	/* Resume state: next signal, and next character of a StringKey */
+	size_t index;
+	bool inText;
+	size_t charIndex;
+	std::string text;
+	mcr_NoOp interval;
+	/* Next frame of a Smooth, 0 if not sending one */
+	unsigned int frame;
+	mcr_Smooth smooth;
+	Clock::time_point smoothStart;
+#endif
+
+	ExecutorTask(mcr_Macro *mcrPt)
+		: canceled(false), paused(false)
+#if !MCR_EXECUTOR_COROUTINES
+		, index(0), inText(false), charIndex(0), frame(0)
+#endif
+	{
+		std::memset(&thread, 0, sizeof(thread));
+		thread.macro = mcrPt;
+		thread.state = MCR_THREAD_RUNNING;
+#if !MCR_EXECUTOR_COROUTINES
+		interval.sec = interval.msec = 0;
+#endif
+	}
+};
+
+struct ExecutorImpl {
+	std::mutex lock;
+	std::condition_variable cnd;
+	std::vector<std::thread> threads;
+	std::deque<ExecutorTask *> ready;
+	std::multimap<Clock::time_point, ExecutorTask *> sleeping;
+	std::set<ExecutorTask *> tasks;
+	bool stopping;
+
+	ExecutorImpl() : stopping(false)
+	{
+	}
+};
+
+/* All executors, woken when any macro is interrupted */
+static std::mutex _executorsLock;
+static std::set<ExecutorImpl *> _executors;
+
+/* mcr_Macro_set_interrupt_listener, wake sleeping tasks to check their
+ * macro.  Executor locks are never held while locking a macro. */
+static void interrupted(mcr_Macro *)
+{
+	std::lock_guard<std::mutex> lock(_executorsLock);
+	for (auto implPt: _executors) {
+		/* Not notified between checking and waiting */
+		{
+			std::lock_guard<std::mutex> implLock(implPt->lock);
+		}
+		implPt->cnd.notify_all();
+	}
+}
+
+enum class Gate {
+	Run, Pause, Stop
+};
+
+/* Same cancellation rules as macro threads */
+static Gate gate(ExecutorTask *taskPt)
+{
+	mcr_Macro *mcrPt = taskPt->thread.macro;
+	if (taskPt->canceled)
+		return Gate::Stop;
+	switch (mcrPt->interruptor) {
+	case MCR_CONTINUE:
+		taskPt->paused = false;
+		break;
+	case MCR_PAUSE:
+		if (!taskPt->paused) {
+			taskPt->paused = true;
+			taskPt->pauseEnd = Clock::now() + _maxPause;
+			return Gate::Pause;
+		}
+		if (Clock::now() < taskPt->pauseEnd)
+			return Gate::Pause;
+		/* Max pause reached */
+		taskPt->paused = false;
+		if (mtx_lock(&mcrPt->lock) == thrd_success) {
+			if (mcrPt->interruptor == MCR_PAUSE) {
+				mcrPt->interruptor = MCR_CONTINUE;
+				cnd_broadcast(&mcrPt->thread_count_cnd);
+			}
+			mtx_unlock(&mcrPt->lock);
+		}
+		break;
+	case MCR_INTERRUPT:
+		taskPt->paused = false;
+		/* Only one task or thread will consume the interrupt. */
+		if (mtx_lock(&mcrPt->lock) == thrd_success) {
+			if (mcrPt->interruptor == MCR_INTERRUPT) {
+				mcrPt->interruptor = MCR_CONTINUE;
+				cnd_broadcast(&mcrPt->thread_count_cnd);
+			}
+			mtx_unlock(&mcrPt->lock);
+		}
+		return Gate::Stop;
+	default:
+		taskPt->paused = false;
+		return Gate::Stop;
+	}
+	if (taskPt->thread.interrupted) {
+		taskPt->thread.interrupted = false;
+		return Gate::Stop;
+	}
+	return Gate::Run;
+}
+
+/* Sleeping task should be woken to finish or resume. */
+static inline bool isWaking(ExecutorTask *taskPt)
+{
+	int interruptor = taskPt->thread.macro->interruptor;
+	return taskPt->canceled || interruptor >= MCR_INTERRUPT ||
+		   (taskPt->paused && interruptor != MCR_PAUSE);
+}
+
+/* \pre Macro locked */
+static void finishLocked(mcr_Macro *mcrPt)
+{
+	--mcrPt->thread_count;
+	/* Last to finish will reset interrupting all. */
+	if (mcrPt->interruptor == MCR_INTERRUPT_ALL && !mcrPt->thread_count)
+		mcrPt->interruptor = MCR_CONTINUE;
+	cnd_broadcast(&mcrPt->thread_count_cnd);
+}
+
+static void finish(ExecutorTask *taskPt)
+{
+	mcr_Macro *mcrPt = taskPt->thread.macro;
+	if (mtx_lock(&mcrPt->lock) != thrd_success) {
+		dmsg;
+		return;
+	}
+	finishLocked(mcrPt);
+	mtx_unlock(&mcrPt->lock);
+}
+
+/* Take the next queued execution, or repeat the last execution of a
+ * sticky macro.  Otherwise the task is finished, in the same lock as
+ * triggers are queued so no queued execution is left behind.
+ * \return True to execute again, false if finished */
+static bool nextExecution(ExecutorTask *taskPt)
+{
+	mcr_Macro *mcrPt = taskPt->thread.macro;
+	bool ret = false;
+	if (mtx_lock(&mcrPt->lock) != thrd_success) {
+		dmsg;
+		return false;
+	}
+	/* Interrupted while waiting after the last signal */
+	if (mcrPt->interruptor == MCR_INTERRUPT) {
+		mcrPt->interruptor = MCR_CONTINUE;
+		cnd_broadcast(&mcrPt->thread_count_cnd);
+	}
+	if (!taskPt->canceled && mcrPt->interruptor < MCR_INTERRUPT) {
+		if (mcrPt->queued) {
+			--mcrPt->queued;
+			ret = true;
+		} else if (mcrPt->sticky && mcrPt->thread_count == 1) {
+			ret = true;
+		}
+	}
+	if (ret) {
+		++mcrPt->stats.executions;
+	} else {
+		finishLocked(mcrPt);
+	}
+	mtx_unlock(&mcrPt->lock);
+	return ret;
+}
+
+static inline Clock::time_point noopWake(const mcr_NoOp &noop)
+{
+	return Clock::now() + std::chrono::seconds(noop.sec) +
+		   std::chrono::milliseconds(noop.msec);
+}
+
+static inline bool isNoOp(mcr_Macro *mcrPt, mcr_Signal *sigPt)
+{
+	return sigPt->isignal == mcr_iNoOp(mcrPt->ctx);
+}
+
+static inline bool isStringKey(mcr_Signal *sigPt)
+{
+	return sigPt->isignal && sigPt->isignal->send == ISignal<StringKey>::send;
+}
+
+static inline bool isSmooth(mcr_Macro *mcrPt, mcr_Signal *sigPt)
+{
+	return sigPt->isignal == mcr_iSmooth(mcrPt->ctx);
+}
+
+static inline unsigned int smoothFrames(const mcr_Smooth &smooth)
+{
+	return smooth.frames ? smooth.frames : 1;
+}
+
+/* Frames are scheduled from the first frame, same as
+ * mcr_Smooth_send_data */
+static inline Clock::time_point smoothWake(const mcr_Smooth &smooth,
+		Clock::time_point start, unsigned int frame)
+{
+	return start + std::chrono::microseconds(
+			   static_cast<long long>(smooth.interval_usec) * frame);
+}
+
+/* Same as macro threads, only debugging stops at an error.  The interrupt
+ * is locked and wakes other tasks and threads of the macro. */
+static inline void sendFailed(mcr_Macro *mcrPt)
+{
+	dmsg;
+	ddo(mcr_Macro_interrupt(mcrPt, MCR_DISABLE);)
+	UNUSED(mcrPt);
+}
+
+/* Same as StringKey::send for one character */
+static void sendCharacter(mcr_Macro *mcrPt, char c)
+{
+	Libmacro *context = Libmacro::instance();
+	size_t characterCount, j;
+	Signal *chara;
+	if (static_cast<size_t>(c) >= context->characterCount())
+		return;
+	chara = context->characterData(c);
+	characterCount = context->characterCount(c);
+	for (j = 0; j < characterCount; j++) {
+		if (mcr_send(context->ptr(), chara[j].ptr())) {
+			sendFailed(mcrPt);
+			return;
+		}
+	}
+}
+
+/* Same as mcr_Smooth_send_data for one frame */
+static void sendFrame(mcr_Macro *mcrPt, const mcr_Smooth *smPt,
+					  unsigned int frame)
+{
+	if (mcr_Smooth_send_frame(mcrPt->ctx, smPt, frame))
+		sendFailed(mcrPt);
+}
+
+static void sendSignal(mcr_Macro *mcrPt, mcr_Signal *sigPt)
+{
+	if (sigPt->isignal && mcr_send(mcrPt->ctx, sigPt))
+		sendFailed(mcrPt);
+}
+
+#if MCR_EXECUTOR_COROUTINES
+/* Suspend the task until a time point */
+struct WakeAt {
+	ExecutorTask *task;
+	Clock::time_point time;
+
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+	void await_suspend(std::coroutine_handle<>) noexcept
+	{
+		task->wake = time;
+	}
+	void await_resume() const noexcept
+	{
+	}
+};
+
+/* Signal set changes disable the macro and wait for this task, so the
+ * set is valid between cancellation points. */
+static TaskCoroutine run(ExecutorTask *taskPt)
+{
+	mcr_Macro *mcrPt = taskPt->thread.macro;
+	mcr_Signal *sigPt;
+	StringKey *textPt;
+	mcr_Smooth *smPt;
+	Gate state;
+	size_t i;
+	do {
+		state = Gate::Run;
+		for (i = 0; i < mcrPt->signal_set.used; i++) {
+			while ((state = gate(taskPt)) == Gate::Pause)
+				co_await WakeAt {taskPt, taskPt->pauseEnd};
+			if (state == Gate::Stop)
+				break;
+			sigPt = mcr_Macro_signal(mcrPt, i);
+			if (isNoOp(mcrPt, sigPt)) {
+				if (mcr_NoOp_data(sigPt))
+					co_await WakeAt {taskPt, noopWake(*mcr_NoOp_data(sigPt))};
+			} else if (isStringKey(sigPt)) {
+				if (!(textPt = StringKey::data(sigPt)))
+					continue;
+				mcr_NoOp interval = textPt->interval;
+				for (char c: textPt->text()) {
+					while ((state = gate(taskPt)) == Gate::Pause)
+						co_await WakeAt {taskPt, taskPt->pauseEnd};
+					if (state == Gate::Stop)
+						break;
+					sendCharacter(mcrPt, c);
+					co_await WakeAt {taskPt, noopWake(interval)};
+				}
+				if (state == Gate::Stop)
+					break;
+			} else if (isSmooth(mcrPt, sigPt)) {
+				if (!(smPt = mcr_Smooth_data(sigPt)))
+					continue;
+				mcr_Smooth smooth = *smPt;
+				Clock::time_point start = Clock::now();
+				for (unsigned int frame = 1;; frame++) {
+					sendFrame(mcrPt, &smooth, frame);
+					if (frame == smoothFrames(smooth))
+						break;
+					co_await WakeAt {taskPt, smoothWake(smooth, start, frame)};
+					while ((state = gate(taskPt)) == Gate::Pause)
+						co_await WakeAt {taskPt, taskPt->pauseEnd};
+					if (state == Gate::Stop)
+						break;
+				}
+				if (state == Gate::Stop)
+					break;
+			} else {
+				sendSignal(mcrPt, sigPt);
+			}
+		}
+		/* Let other tasks run between executions */
+		if (state != Gate::Stop)
+			co_await WakeAt {taskPt, Clock::now()};
+	} while (nextExecution(taskPt));
+}
+
+/* \return True if waiting for wake time, false if finished */
+static bool resume(ExecutorTask *taskPt)
+{
+	if (!taskPt->coroutine.handle)
+		taskPt->coroutine = run(taskPt);
+	taskPt->coroutine.handle.resume();
+	return !taskPt->coroutine.handle.done();
+}
+#else
+/* Send signals until the next timer.
+ * \return True if waiting for wake time, false if finished */
+static bool resume(ExecutorTask *taskPt)
+{
+	mcr_Macro *mcrPt = taskPt->thread.macro;
+	mcr_Signal *sigPt;
+	StringKey *textPt;
+	mcr_Smooth *smPt;
+	for (;;) {
+		switch (gate(taskPt)) {
+		case Gate::Stop:
+			/* An interrupted execution may continue with the next queued
+			 * execution. */
+			taskPt->inText = false;
+			taskPt->text.clear();
+			taskPt->frame = 0;
+			if (!nextExecution(taskPt))
+				return false;
+			taskPt->index = 0;
+			taskPt->wake = Clock::now();
+			return true;
+		case Gate::Pause:
+			taskPt->wake = taskPt->pauseEnd;
+			return true;
+		default:
+			break;
+		}
+		if (taskPt->inText) {
+			if (taskPt->charIndex < taskPt->text.size()) {
+				sendCharacter(mcrPt, taskPt->text[taskPt->charIndex++]);
+				taskPt->wake = noopWake(taskPt->interval);
+				return true;
+			}
+			taskPt->inText = false;
+			taskPt->text.clear();
+			++taskPt->index;
+			continue;
+		}
+		if (taskPt->frame) {
+			sendFrame(mcrPt, &taskPt->smooth, taskPt->frame);
+			if (taskPt->frame < smoothFrames(taskPt->smooth)) {
+				taskPt->wake = smoothWake(taskPt->smooth, taskPt->smoothStart,
+										  taskPt->frame++);
+				return true;
+			}
+			taskPt->frame = 0;
+			++taskPt->index;
+			continue;
+		}
+		if (taskPt->index >= mcrPt->signal_set.used) {
+			if (!nextExecution(taskPt))
+				return false;
+			/* Let other tasks run between executions */
+			taskPt->index = 0;
+			taskPt->wake = Clock::now();
+			return true;
+		}
+		/* Signal set changes disable the macro and wait for this task, so
+		 * the set is valid between cancellation points. */
+		sigPt = mcr_Macro_signal(mcrPt, taskPt->index);
+		if (isNoOp(mcrPt, sigPt)) {
+			++taskPt->index;
+			if (mcr_NoOp_data(sigPt)) {
+				taskPt->wake = noopWake(*mcr_NoOp_data(sigPt));
+				return true;
+			}
+		} else if (isStringKey(sigPt)) {
+			if ((textPt = StringKey::data(sigPt))) {
+				taskPt->text = textPt->text();
+				taskPt->interval = textPt->interval;
+				taskPt->charIndex = 0;
+				taskPt->inText = true;
+			} else {
+				++taskPt->index;
+			}
+		} else if (isSmooth(mcrPt, sigPt)) {
+			if ((smPt = mcr_Smooth_data(sigPt))) {
+				taskPt->smooth = *smPt;
+				taskPt->smoothStart = Clock::now();
+				taskPt->frame = 1;
+			} else {
+				++taskPt->index;
+			}
+		} else {
+			sendSignal(mcrPt, sigPt);
+			++taskPt->index;
+		}
+	}
+}
+#endif
+
+static void work(ExecutorImpl *implPt)
+{
+	std::unique_lock<std::mutex> lock(implPt->lock);
+	ExecutorTask *taskPt;
+	Clock::time_point now;
+	unsigned int output, route = 0;
+	bool waiting;
+	while (!implPt->stopping) {
+		now = Clock::now();
+		/* Wake tasks that are due, or need to finish early. */
+		for (auto iter = implPt->sleeping.begin();
+			 iter != implPt->sleeping.end();) {
+			if (iter->first <= now || isWaking(iter->second)) {
+				implPt->ready.push_back(iter->second);
+				iter = implPt->sleeping.erase(iter);
+			} else {
+				++iter;
+			}
+		}
+		/* Interrupting a macro notifies all executors. */
+		if (implPt->ready.empty()) {
+			if (implPt->sleeping.empty()) {
+				implPt->cnd.wait(lock);
+			} else {
+				implPt->cnd.wait_until(lock, implPt->sleeping.begin()->first);
+			}
+			continue;
+		}
+		taskPt = implPt->ready.front();
+		implPt->ready.pop_front();
+		lock.unlock();
+		mcr_Macro_set_current(&taskPt->thread);
+		/* Signals and characters are sent to the macro output. */
+		output = taskPt->thread.macro->output;
+		if (output)
+			route = mcr_output_set_thread_route(output);
+		/* Signals between timers are written together.  Not waiting
+		 * after the task is finished. */
+		mcr_output_begin(false);
+		waiting = resume(taskPt);
+		if (mcr_output_end())
+			dmsg;
+		if (output)
+			mcr_output_set_thread_route(route);
+		mcr_Macro_set_current(nullptr);
+		lock.lock();
+		if (waiting) {
+			implPt->sleeping.insert(std::make_pair(taskPt->wake, taskPt));
+		} else {
+			implPt->tasks.erase(taskPt);
+			delete taskPt;
+		}
+	}
+}
+
+MacroExecutor::MacroExecutor(size_t threadCount)
+	: _impl(new ExecutorImpl())
+{
+	auto implPt = static_cast<ExecutorImpl *>(_impl);
+	if (!threadCount)
+		threadCount = 1;
+	for (size_t i = 0; i < threadCount; i++) {
+		implPt->threads.push_back(std::thread(work, implPt));
+	}
+	{
+		std::lock_guard<std::mutex> lock(_executorsLock);
+		_executors.insert(implPt);
+		mcr_Macro_set_interrupt_listener(interrupted);
+	}
+	_lastExecutor = this;
+}
+
+MacroExecutor::~MacroExecutor()
+{
+	auto implPt = static_cast<ExecutorImpl *>(_impl);
+	{
+		std::lock_guard<std::mutex> lock(_executorsLock);
+		_executors.erase(implPt);
+	}
+	{
+		std::lock_guard<std::mutex> lock(implPt->lock);
+		implPt->stopping = true;
+	}
+	implPt->cnd.notify_all();
+	for (auto &iter: implPt->threads) {
+		iter.join();
+	}
+	/* Remaining tasks never finished, but must not be counted. */
+	for (auto taskPt: implPt->tasks) {
+		finish(taskPt);
+		delete taskPt;
+	}
+	delete implPt;
+	if (_lastExecutor == this)
+		_lastExecutor = nullptr;
+}
+
+MacroExecutor *MacroExecutor::instance()
+{
+	if (!_lastExecutor)
+		throw EFAULT;
+	return _lastExecutor;
+}
+
+bool MacroExecutor::receive(void *mcrPt, mcr_Signal *, unsigned int)
+{
+	mcr_Macro *localPt = static_cast<mcr_Macro *>(mcrPt);
+	if (!localPt)
+		return false;
+	try {
+		instance()->trigger(localPt);
+	} catch (int err) {
+		mset_error(err);
+	}
+	return localPt->blocking;
+}
+
+bool MacroExecutor::trigger(mcr_Macro *mcrPt)
+{
+	auto implPt = static_cast<ExecutorImpl *>(_impl);
+	ExecutorTask *taskPt;
+	int thrdErr;
+	bool queued;
+	dassert(mcrPt);
+	if ((thrdErr = mtx_lock(&mcrPt->lock)) != thrd_success) {
+		mset_error(mcr_thrd_errno(thrdErr));
+		throw mcr_err;
+	}
+	++mcrPt->stats.triggers;
+	if (mcrPt->interruptor != MCR_CONTINUE || !mcrPt->signal_set.used) {
+		mtx_unlock(&mcrPt->lock);
+		return false;
+	}
+	/* Any value greater than MCR_THREAD_MAX will be ignored.  A running
+	 * task takes queued executions before finishing. */
+	if (mcrPt->thread_count >= MCR_THREAD_MAX
+		|| static_cast<unsigned>(mcrPt->thread_count) >= mcrPt->thread_max) {
+		switch (mcrPt->queue_policy) {
+		case MCR_QUEUE_MERGE:
+			queued = !mcrPt->queued;
+			break;
+		case MCR_QUEUE_LIMIT:
+			queued = mcrPt->queued < mcrPt->queue_max;
+			break;
+		default:
+			queued = false;
+			break;
+		}
+		if (queued) {
+			++mcrPt->queued;
+		} else {
+			++mcrPt->stats.coalesced;
+		}
+		mtx_unlock(&mcrPt->lock);
+		return queued;
+	}
+	++mcrPt->thread_count;
+	++mcrPt->stats.executions;
+	mtx_unlock(&mcrPt->lock);
+	try {
+		taskPt = new ExecutorTask(mcrPt);
+		std::lock_guard<std::mutex> lock(implPt->lock);
+		implPt->tasks.insert(taskPt);
+		implPt->ready.push_back(taskPt);
+	} catch (std::bad_alloc &) {
+		ExecutorTask uncounted(mcrPt);
+		finish(&uncounted);
+		mset_error(ENOMEM);
+		throw ENOMEM;
+	}
+	implPt->cnd.notify_one();
+	return true;
+}
+
+void MacroExecutor::cancel(mcr_Macro *mcrPt)
+{
+	auto implPt = static_cast<ExecutorImpl *>(_impl);
+	{
+		std::lock_guard<std::mutex> lock(implPt->lock);
+		for (auto taskPt: implPt->tasks) {
+			if (taskPt->thread.macro == mcrPt)
+				taskPt->canceled = true;
+		}
+	}
+	implPt->cnd.notify_all();
+}
+
+size_t MacroExecutor::taskCount() const
+{
+	auto implPt = static_cast<ExecutorImpl *>(_impl);
+	std::lock_guard<std::mutex> lock(implPt->lock);
+	return implPt->tasks.size();
+}
+
+size_t MacroExecutor::threadCount() const
+{
+	return static_cast<ExecutorImpl *>(_impl)->threads.size();
+}
+}
@@ -219,6 +219,32 @@ void Macro::setThreadMax(unsigned int val)
 		_macro.thread_max = val;
 }
 
+void Macro::setQueuePolicy(mcr_MacroQueuePolicy policy, unsigned int queueMax)
+{
+	if (mcr_Macro_set_queue_policy(ptr(), policy, queueMax))
+		throw mcr_err;
+}
+
+void Macro::setThreadOptions(const mcr_ThreadOptions &val)
+{
+	if (mcr_Macro_set_thread_options(ptr(), &val))
+		throw mcr_err;
+}
+
+mcr_MacroStats Macro::stats()
+{
+	mcr_MacroStats ret;
+	if (mcr_Macro_stats(ptr(), &ret))
+		throw mcr_err;
+	return ret;
+}
+
+void Macro::resetStats()
+{
+	if (mcr_Macro_reset_stats(ptr()))
+		throw mcr_err;
+}
+
 void Macro::setInterruptor(Interrupt val)
 {
 	if (mcr_Macro_interrupt(ptr(), val))
@@ -48,16 +48,26 @@ void StringKey::send()
 	Libmacro *context = Libmacro::instance();
 	std::string str = text();
 	size_t totalCount = context->characterCount(), characterCount, j;
-	for (auto i: str) {
-		if (static_cast<size_t>(i) < totalCount) {
-			auto chara = context->characterData(i);
-			characterCount = context->characterCount(i);
-			for (j = 0; j < characterCount; j++) {
-				if (mcr_send(context->ptr(), chara[j].ptr()))
-					throw mcr_err;
+	/* Characters without an interval are written together, and
+	 * characters of different keys share frames. */
+	mcr_output_begin(true);
+	try {
+		for (auto i: str) {
+			if (static_cast<size_t>(i) < totalCount) {
+				auto chara = context->characterData(i);
+				characterCount = context->characterCount(i);
+				for (j = 0; j < characterCount; j++) {
+					if (mcr_send(context->ptr(), chara[j].ptr()))
+						throw mcr_err;
+				}
+				mcr_NoOp_send_data(&interval);
 			}
-			mcr_NoOp_send_data(&interval);
 		}
+	} catch (...) {
+		mcr_output_end();
+		throw;
 	}
+	if (mcr_output_end())
+		throw mcr_err;
 }
 }
@@ -20,6 +20,9 @@
 
 #include "mcr/libmacro.h"
 #include "mcr/private.h"
+#include "mcr/util/atomic.h"
+
+#include <string.h>
 
 void mcr_intercept_reset_modifiers(struct mcr_context *ctx)
 {
@@ -36,6 +39,84 @@ void mcr_intercept_set_blockable(struct mcr_context *ctx, bool enable)
 	ctx->intercept.blockable = enable;
 }
 
+void mcr_intercept_set_thread_options(struct mcr_context *ctx,
+									  const struct mcr_ThreadOptions *optionsPt)
+{
+	if (optionsPt) {
+		ctx->intercept.thread_options = *optionsPt;
+	} else {
+		memset(&ctx->intercept.thread_options, 0,
+			   sizeof(ctx->intercept.thread_options));
+	}
+	mcr_atomic_store(&ctx->intercept.thread_options_error, 0);
+}
+
+int mcr_intercept_thread_options_error(struct mcr_context *ctx)
+{
+	return (int)mcr_atomic_load(&ctx->intercept.thread_options_error);
+}
+
+void mcr_intercept_set_latency_enabled(struct mcr_context *ctx, bool enable)
+{
+	ctx->intercept.latency_enabled = enable;
+}
+
+void mcr_intercept_latency(struct mcr_context *ctx,
+						   struct mcr_LatencyHistogram *dispatchPt,
+						   struct mcr_LatencyHistogram *writePt)
+{
+	if (dispatchPt)
+		*dispatchPt = ctx->intercept.dispatch_latency;
+	if (writePt)
+		*writePt = ctx->intercept.write_latency;
+}
+
+void mcr_intercept_reset_latency(struct mcr_context *ctx)
+{
+	memset(&ctx->intercept.dispatch_latency, 0,
+		   sizeof(ctx->intercept.dispatch_latency));
+	memset(&ctx->intercept.write_latency, 0,
+		   sizeof(ctx->intercept.write_latency));
+}
+
+void mcr_LatencyHistogram_add(struct mcr_LatencyHistogram *histPt,
+							  size_t usec)
+{
+	size_t bucket = 0, max;
+	dassert(histPt);
+	while ((usec >> (bucket + 1)) && bucket < MCR_LATENCY_BUCKETS - 1)
+		++bucket;
+	mcr_atomic_fetch_add(histPt->buckets + bucket, 1);
+	mcr_atomic_fetch_add(&histPt->total_usec, usec);
+	mcr_atomic_fetch_add(&histPt->count, 1);
+	while ((max = mcr_atomic_load(&histPt->max_usec)) < usec) {
+		if (mcr_atomic_cas(&histPt->max_usec, max, usec))
+			break;
+	}
+}
+
+size_t mcr_LatencyHistogram_percentile(const struct mcr_LatencyHistogram
+									   *histPt, double percentile)
+{
+	size_t i, sum = 0, target;
+	dassert(histPt);
+	if (!histPt->count)
+		return 0;
+	if (percentile < 0)
+		percentile = 0;
+	target = (size_t)(histPt->count * (percentile > 100 ? 100 : percentile) /
+					  100.0);
+	if (!target)
+		target = 1;
+	for (i = 0; i < MCR_LATENCY_BUCKETS - 1; i++) {
+		if ((sum += histPt->buckets[i]) >= target) {
+			return ((size_t)2 << i) < histPt->max_usec ?
+				   (size_t)2 << i : histPt->max_usec;
+		}
+	}
+	return histPt->max_usec;
+}
+
 int mcr_intercept_reset(struct mcr_context *ctx)
 {
 	if (mcr_intercept_is_enabled(ctx)) {
@@ -27,6 +27,7 @@
 static int grabber_open(struct mcr_Grabber *grabPt);
 static int grabber_close(struct mcr_Grabber *grabPt);
 static int grabber_grab(struct mcr_Grabber *grabPt, bool toGrab);
+static void grabber_read_capabilities(struct mcr_Grabber *grabPt);
 
 int mcr_Grabber_init(void *grabPt)
 {
@@ -90,6 +91,37 @@ int mcr_Grabber_set_path(struct mcr_Grabber *grabPt, const char *path)
 	return 0;
 }
 
+void mcr_Grabber_set_coalesce(struct mcr_Grabber *grabPt, unsigned int usec,
+							  unsigned int frames)
+{
+	dassert(grabPt);
+	grabPt->coalesce_usec = usec;
+	grabPt->coalesce_frames = frames;
+}
+
+bool mcr_Grabber_match(struct mcr_Grabber *grabPt,
+					   const struct mcr_GrabFilter *filterPt)
+{
+	struct mcr_GrabberCapabilities *capsPt;
+	int type;
+	dassert(grabPt);
+	if (!filterPt)
+		return true;
+	capsPt = &grabPt->capabilities;
+	for (type = 0; type < EV_CNT && type < 32; type++) {
+		if ((filterPt->ev_types & (1u << type))
+			&& !MCR_EVENTBIT_ISSET(capsPt->ev_bits, type)) {
+			return false;
+		}
+	}
+	if (filterPt->key && (filterPt->key < 0 || filterPt->key >= KEY_CNT
+						  || !MCR_EVENTBIT_ISSET(capsPt->key_bits, filterPt->key))) {
+		return false;
+	}
+	return !filterPt->classes
+		   || (filterPt->classes & (1u << capsPt->grabber_class));
+}
+
 bool mcr_Grabber_is_enabled(struct mcr_Grabber * grabPt)
 {
 	return grabPt ? grabPt->fd != -1 : false;
@@ -117,6 +149,11 @@ static int grabber_open(struct mcr_Grabber *grabPt)
 		mcr_errno(EINTR);
 		return mcr_err;
 	}
+	grabber_read_capabilities(grabPt);
+	/* Event times comparable with the monotonic clock */
+	grabPt->clock_id = CLOCK_MONOTONIC;
+	if (ioctl(grabPt->fd, EVIOCSCLOCKID, &grabPt->clock_id) < 0)
+		grabPt->clock_id = CLOCK_REALTIME;
 	if (grabPt->blocking)
 		return grabber_grab(grabPt, true);
 	return 0;
@@ -140,6 +177,36 @@ static int grabber_close(struct mcr_Grabber *grabPt)
 	return mcr_err;
 }
 
+/* Not able to read is not an error, capabilities are empty. */
+static void grabber_read_capabilities(struct mcr_Grabber *grabPt)
+{
+	struct mcr_GrabberCapabilities *capsPt = &grabPt->capabilities;
+	int fd = grabPt->fd, pos;
+	bool hasKey, hasRel, hasAbs;
+	memset(capsPt, 0, sizeof(struct mcr_GrabberCapabilities));
+	if (ioctl(fd, EVIOCGBIT(0, sizeof(capsPt->ev_bits)), capsPt->ev_bits) < 0)
+		return;
+	ioctl(fd, EVIOCGNAME(sizeof(capsPt->name) - 1), capsPt->name);
+	if ((hasKey = MCR_EVENTBIT_ISSET(capsPt->ev_bits, EV_KEY)))
+		ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(capsPt->key_bits)), capsPt->key_bits);
+	if ((hasRel = MCR_EVENTBIT_ISSET(capsPt->ev_bits, EV_REL)))
+		ioctl(fd, EVIOCGBIT(EV_REL, sizeof(capsPt->rel_bits)), capsPt->rel_bits);
+	if ((hasAbs = MCR_EVENTBIT_ISSET(capsPt->ev_bits, EV_ABS))) {
+		ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(capsPt->abs_bits)), capsPt->abs_bits);
+		for (pos = MCR_DIMENSION_CNT; pos--;) {
+			if (MCR_EVENTBIT_ISSET(capsPt->abs_bits, ABS_X + pos))
+				ioctl(fd, EVIOCGABS(ABS_X + pos), capsPt->abs_info + pos);
+		}
+	}
+	if (hasRel && !hasAbs) {
+		capsPt->grabber_class = MCR_GRABBER_POINTER;
+	} else if (hasAbs && !hasRel) {
+		capsPt->grabber_class = MCR_GRABBER_TABLET;
+	} else if (hasKey && !hasRel && !hasAbs) {
+		capsPt->grabber_class = MCR_GRABBER_KEYBOARD;
+	}
+}
+
 static int grabber_grab(struct mcr_Grabber *grabPt, bool toGrab)
 {
 	if (ioctl(grabPt->fd, EVIOCGRAB, toGrab ? 1 : 0) < 0) {
@@ -19,18 +19,102 @@
 #include "mcr/intercept/linux/p_intercept.h"
 #include "mcr/intercept/intercept.h"
 
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 
 #include "mcr/libmacro.h"
+#include "mcr/util/atomic.h"
 
-typedef struct {
+/* Event time while dispatching, see mcr_intercept_event_time */
+static __thread struct timeval _eventTime;
+static __thread bool _hasEventTime;
+
+/* Signals and memory to dispatch events of one grabber */
+struct _dispatch_state {
+	struct mcr_Key key;
+	struct mcr_HidEcho echo;
+	struct mcr_MoveCursor abs;
+	struct mcr_MoveCursor rel;
+	struct mcr_Scroll scr;
+	struct mcr_Signal keysig, echosig, abssig, relsig, scrsig;
+	/* For abs, keep memory of having such event type at least once. */
+	bool bAbs[MCR_DIMENSION_CNT];
+	/* Device state, to resynchronize after dropped events */
+	char key_bits[MCR_EVENTINDEX(KEY_CNT) + 1];
+	int abs_values[MCR_DIMENSION_CNT];
+	/* Modifiers of keys set in key_bits */
+	volatile unsigned int mods;
+	/* Events until SYN_REPORT, dispatched together */
+	struct input_event frame[MCR_GRAB_SET_LENGTH];
+	int frame_count;
+	/* SYN_DROPPED, ignore events until the next SYN_REPORT */
+	bool frame_dropped;
+	/* Sum of coalesced relative events by code */
+	int coalesce_sums[REL_CNT];
+	/* Number of coalesced frames, 0 if none pending */
+	unsigned int coalesce_count;
+	/* Time of the first coalesced frame */
+	struct timespec coalesce_start;
+	/* Event time of the first coalesced frame */
+	struct timeval coalesce_time;
+};
+
+typedef struct _grab_context _grab_context;
+/* Decode and dispatch one frame of events */
+typedef int (*_dispatch_fnc)(_grab_context *gcPt, struct input_event *events,
+							 int count);
+
+struct _grab_context {
 	struct mcr_context *ctx;
 	struct mcr_Grabber grabber;
-} _grab_context;
+	/* Reactor reading this grabber, NULL if not yet read */
+	struct mcr_Reactor *reactor;
+	/* Removed from intercept, waiting to be freed by the reactor */
+	volatile bool removed;
+	/* Grabbed by the watcher, not in grab_paths */
+	bool auto_grab;
+	/* Reading a trace, not a device, see mcr_intercept_add_replay */
+	bool replay;
+	/* Replay of a regular file, which cannot be added to epoll */
+	bool file;
+	/* Raw events read are also written here, -1 if not capturing */
+	volatile int capture_fd;
+	/* Output passthrough events are written to, see mcr_output_add */
+	volatile unsigned int output;
+	/* Read or poll submitted to the reactor io_uring */
+	bool ring_busy;
+	/* Cancel submitted for the read or poll in progress */
+	bool ring_canceled;
+	/* user_data of the read or poll in progress */
+	uint64_t ring_data;
+	/* io_uring reads into this */
+	struct input_event ring_buffer[MCR_GRAB_SET_LENGTH];
+	struct _dispatch_state disp;
+	/* Decode loop for the device class */
+	_dispatch_fnc dispatch;
+};
+
+/* io_uring user_data is a pointer tagged with the kind of request. */
+#define RING_READ 0
+#define RING_POLL 1
+#define RING_WRITE 2
+#define RING_EPOLL 3
+#define RING_DATA(pointer, tag) ((uint64_t)(uintptr_t)(pointer) | (tag))
+#define RING_TAG(data) ((int)((data) & 3))
+#define RING_POINTER(data) ((void *)(uintptr_t)((data) & ~(uint64_t)3))
+
+static void dispatch_state_init(struct mcr_context *ctx,
+								struct _dispatch_state *dsPt);
 
 /* Remember (*gcPt) is a _grab_context reference, and not a grabber */
 static int grab_context_malloc(_grab_context ** gcPt, struct mcr_context *ctx)
@@ -38,6 +122,7 @@ static int grab_context_malloc(_grab_context ** gcPt, struct mcr_context *ctx)
 	*gcPt = malloc(sizeof(_grab_context));
 	if (!*gcPt)
 		mset_error_return(ENOMEM);
+	memset(*gcPt, 0, sizeof(_grab_context));
 	if (mcr_Grabber_init(&(*gcPt)->grabber)) {
 		free(*gcPt);
 		*gcPt = NULL;
@@ -45,22 +130,23 @@ static int grab_context_malloc(_grab_context ** gcPt, struct mcr_context *ctx)
 	}
 	mcr_Grabber_set_blocking(&(*gcPt)->grabber, ctx->intercept.blockable);
 	(*gcPt)->ctx = ctx;
+	(*gcPt)->capture_fd = -1;
+	dispatch_state_init(ctx, &(*gcPt)->disp);
 	return 0;
 }
 
 static int grab_context_free(_grab_context ** gcPt)
 {
-	int err = mcr_Grabber_deinit(&(*gcPt)->grabber);
+	int err;
+	/* Replay is not grabbed from evdev */
+	if ((*gcPt)->replay)
+		(*gcPt)->grabber.blocking = false;
+	err = mcr_Grabber_deinit(&(*gcPt)->grabber);
 	free(*gcPt);
 	*gcPt = NULL;
 	return err;
 }
 
-static inline void grab_context_disable(_grab_context ** gcPtPt)
-{
-	mcr_Grabber_set_enabled(&(*gcPtPt)->grabber, false);
-}
-
 typedef struct {
 	struct mcr_context *ctx;
 	bool bVal;
@@ -70,20 +156,54 @@ static bool is_enabled_impl(struct mcr_context *ctx);
 static int set_enabled_impl(struct mcr_context *ctx, bool enable);
 static unsigned int get_mods_impl(struct mcr_context *ctx);
 static int thread_enable(void *threadArgs);
-static int grab_impl(struct mcr_context *ctx, const char *grabPath);
-static int intercept_start(void *threadArgs);
-static int read_grabber_loop(struct mcr_context *ctx,
-							 struct mcr_Grabber *grabPt);
-static unsigned int modify_eventbits(struct mcr_context *ctx,
-									 unsigned int *modBuffer, size_t modBufferSize, char *keybit_values);
-static unsigned int max_modifier_val(void);
+static int grab_impl(struct mcr_context *ctx, const char *grabPath,
+					 bool autoGrab);
+static int context_add(struct mcr_context *ctx, _grab_context *pt);
+static int sync_grabbers(struct mcr_context *ctx);
+static _grab_context *find_context(struct mcr_intercept_platform *nPt,
+								   const char *grabPath);
+static void remove_context(_grab_context *gcPt);
+static bool reactors_running(struct mcr_intercept_platform *nPt);
+static int start_reactors(struct mcr_context *ctx);
+static void stop_reactors(struct mcr_context *ctx);
+static int reactor_loop(void *threadArgs);
+static int watch_start(struct mcr_context *ctx);
+static void watch_stop(struct mcr_context *ctx);
+static void watch_read(struct mcr_context *ctx);
+static void watch_grab(struct mcr_context *ctx, const char *grabPath);
+static bool filter_match(struct mcr_context *ctx,
+						 const struct mcr_GrabFilter *filterPt, const char *grabPath);
+static void reactor_collect(struct mcr_Reactor *reactorPt);
+static void reactor_ready(struct mcr_Reactor *reactorPt,
+						  struct epoll_event *events, int count);
+static bool reactor_files(struct mcr_Reactor *reactorPt);
+static int ring_loop(struct mcr_Reactor *reactorPt);
+static int ring_arm(struct mcr_Reactor *reactorPt, _grab_context *gcPt,
+					int tag);
+static void ring_added(struct mcr_Reactor *reactorPt);
+static void ring_drain(struct mcr_Reactor *reactorPt);
+static int ring_open(struct mcr_Reactor *reactorPt);
+static void ring_close(struct mcr_Reactor *reactorPt);
+static void ring_cancel(struct mcr_Reactor *reactorPt, _grab_context *gcPt);
+static bool ring_write(struct mcr_Reactor *reactorPt, int fd,
+					   const struct input_event *events, int count, const bool *dropArr);
+static int read_grabber(_grab_context *gcPt);
+static int grabber_events(_grab_context *gcPt, struct input_event *events,
+						  int rdb);
+static int frame_add(_grab_context *gcPt, const struct input_event *evPt);
+static void state_read(_grab_context *gcPt);
+static bool coalesce_frame(_grab_context *gcPt, struct input_event *events,
+						   int count);
+static int coalesce_flush(_grab_context *gcPt);
+static int reactor_flush(struct mcr_Reactor *reactorPt, int *timeoutPt);
+static int state_resync(_grab_context *gcPt);
+static void set_dispatch(_grab_context *gcPt);
+static int dispatch_frame(_grab_context *gcPt, struct input_event *events,
+						  int count, const struct timeval *timePt);
+static void mods_update(struct mcr_context *ctx,
+						struct _dispatch_state *dsPt);
 static int clear_grabbers(struct mcr_context *ctx);
 
-static inline size_t modbit_size()
-{
-	return sizeof(char) * max_modifier_val() / 8 + 1;
-}
-
 bool mcr_intercept_is_enabled(struct mcr_context *ctx)
 {
 	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
@@ -120,7 +240,10 @@ int mcr_intercept_add_grab(struct mcr_context *ctx, const char *grabPath)
 	int thrdErr = mtx_lock(&nPt->lock);
 	int err = mcr_StringSet_add(&nPt->grab_paths, &grabPath, 1, true);
 	dassert(grabPath);
-	/// \todo add grabber?
+	/* Already reading, start reading the new grabber without
+	 * restarting others. */
+	if (!err && reactors_running(nPt) && !find_context(nPt, grabPath))
+		err = grab_impl(ctx, grabPath, false);
 	if (thrdErr == thrd_success)
 		mtx_unlock(&nPt->lock);
 	return err;
@@ -130,9 +253,11 @@ void mcr_intercept_remove_grab(struct mcr_context *ctx, const char *grabPath)
 {
 	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
 	int thrdErr = mtx_lock(&nPt->lock);
-	/// \todo remove grabber?
+	_grab_context *gcPt;
 	dassert(grabPath);
 	mcr_StringSet_remove(&nPt->grab_paths, grabPath);
+	if ((gcPt = find_context(nPt, grabPath)))
+		remove_context(gcPt);
 	if (thrdErr == thrd_success)
 		mtx_unlock(&nPt->lock);
 }
@@ -144,15 +269,237 @@ int mcr_intercept_set_grabs(struct mcr_context *ctx, const char **allGrabPaths,
 	int thrdErr = mtx_lock(&nPt->lock);
 	int err = mcr_StringSet_replace(&nPt->grab_paths, allGrabPaths,
 									pathCount);
-	/// \todo remove grabber?
+	/* Only grab or remove the difference */
+	if (!err && reactors_running(nPt))
+		err = sync_grabbers(ctx);
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
+	return err;
+}
+
+bool mcr_intercept_is_watching(struct mcr_context *ctx)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	return nPt->watch_enabled;
+}
+
+int mcr_intercept_set_watch(struct mcr_context *ctx,
+							const struct mcr_GrabFilter *filterPt)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	int thrdErr = mtx_lock(&nPt->lock);
+	int err = 0;
+	watch_stop(ctx);
+	nPt->watch_enabled = filterPt != NULL;
+	if (filterPt) {
+		nPt->watch_filter = *filterPt;
+		err = watch_start(ctx);
+	}
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
+	return err;
+}
+
+int mcr_intercept_set_coalesce(struct mcr_context *ctx, const char *grabPath,
+							   unsigned int usec, unsigned int frames)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	int thrdErr = mtx_lock(&nPt->lock);
+	_grab_context **ptArr = MCR_ARR_FIRST(nPt->grab_contexts);
+	_grab_context *gcPt;
+	size_t i = nPt->grab_contexts.used;
+	int err = 0;
+	if (grabPath) {
+		if ((gcPt = find_context(nPt, grabPath))) {
+			mcr_Grabber_set_coalesce(&gcPt->grabber, usec, frames);
+		} else {
+			mset_error(ENOENT);
+			err = ENOENT;
+		}
+	} else {
+		nPt->coalesce_usec = usec;
+		nPt->coalesce_frames = frames;
+		while (i--) {
+			mcr_Grabber_set_coalesce(&ptArr[i]->grabber, usec, frames);
+		}
+	}
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
+	return err;
+}
+
+int mcr_intercept_set_output(struct mcr_context *ctx, const char *grabPath,
+							 unsigned int output)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	int thrdErr;
+	_grab_context **ptArr;
+	_grab_context *gcPt;
+	size_t i;
+	int err = 0;
+	if (output >= mcr_output_count(ctx))
+		mset_error_return(ENOENT);
+	thrdErr = mtx_lock(&nPt->lock);
+	ptArr = MCR_ARR_FIRST(nPt->grab_contexts);
+	i = nPt->grab_contexts.used;
+	if (grabPath) {
+		if ((gcPt = find_context(nPt, grabPath))) {
+			gcPt->output = output;
+		} else {
+			mset_error(ENOENT);
+			err = ENOENT;
+		}
+	} else {
+		nPt->output = output;
+		while (i--) {
+			ptArr[i]->output = output;
+		}
+	}
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
+	return err;
+}
+
+int mcr_intercept_set_capture(struct mcr_context *ctx, const char *grabPath,
+							  int fd)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	int thrdErr = mtx_lock(&nPt->lock);
+	_grab_context *gcPt = find_context(nPt, grabPath);
+	int err = 0;
+	dassert(grabPath);
+	if (!gcPt) {
+		mset_error(ENOENT);
+		err = ENOENT;
+	} else if (fd == -1 || !(err = mcr_Trace_write_header(fd,
+								   &gcPt->grabber.capabilities, gcPt->grabber.clock_id))) {
+		gcPt->capture_fd = fd;
+	}
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
+	return err;
+}
+
+int mcr_intercept_add_replay(struct mcr_context *ctx, int fd)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	struct mcr_TraceHeader header;
+	struct stat fileStat;
+	char path[32];
+	_grab_context *pt = NULL;
+	int flags, thrdErr, err = 0;
+	if (mcr_Trace_read_header(fd, &header))
+		return mcr_err;
+	if (fstat(fd, &fileStat) == -1) {
+		mcr_errno(EINVAL);
+		return mcr_err;
+	}
+	/* Reactors only read what is available. */
+	if ((flags = fcntl(fd, F_GETFL)) == -1
+		|| fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+		mcr_errno(EINVAL);
+		return mcr_err;
+	}
+	snprintf(path, sizeof(path), "replay:%d", fd);
+	thrdErr = mtx_lock(&nPt->lock);
+	if (!reactors_running(nPt))
+		err = start_reactors(ctx);
+	if (!err)
+		err = grab_context_malloc(&pt, ctx);
+	if (!err && !(err = mcr_Grabber_set_path(&pt->grabber, path))) {
+		/* Opened and grabbed as if it were the captured device */
+		pt->replay = true;
+		pt->file = S_ISREG(fileStat.st_mode);
+		pt->grabber.fd = fd;
+		pt->grabber.capabilities = header.capabilities;
+		pt->grabber.clock_id = header.clock_id;
+		pt->grabber.blocking = ctx->intercept.blockable;
+		if ((err = context_add(ctx, pt)))
+			pt->grabber.fd = -1;
+	}
+	/* Caller still owns the file if not added */
+	if (err && pt) {
+		grab_context_free(&pt);
+		mset_error(err);
+	}
 	if (thrdErr == thrd_success)
 		mtx_unlock(&nPt->lock);
 	return err;
 }
 
+int mcr_intercept_set_passthrough_fd(struct mcr_context *ctx, int fd)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	int thrdErr = mtx_lock(&nPt->lock);
+	nPt->passthrough_fd = fd;
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
+	return 0;
+}
+
+bool mcr_intercept_event_time(struct timespec *timePt)
+{
+	dassert(timePt);
+	if (!_hasEventTime)
+		return false;
+	timePt->tv_sec = _eventTime.tv_sec;
+	timePt->tv_nsec = _eventTime.tv_usec * 1000;
+	return true;
+}
+
+bool mcr_intercept_is_tracking_cursor(struct mcr_context *ctx)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	return nPt->track_cursor;
+}
+
+/* Read by reactors once per frame, no need to lock */
+int mcr_intercept_set_track_cursor(struct mcr_context *ctx, bool enable)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	nPt->track_cursor = enable;
+	return 0;
+}
+
+bool mcr_intercept_is_ring_enabled(struct mcr_context *ctx)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	return nPt->ring_enabled;
+}
+
+int mcr_intercept_set_ring_enabled(struct mcr_context *ctx, bool enable)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	int thrdErr = mtx_lock(&nPt->lock);
+	nPt->ring_enabled = enable;
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
+	return 0;
+}
+
+size_t mcr_intercept_reactor_count(struct mcr_context *ctx)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	return nPt->reactor_count;
+}
+
+int mcr_intercept_set_reactor_count(struct mcr_context *ctx, size_t count)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	int thrdErr;
+	if (!count || count > MCR_REACTOR_MAX)
+		mset_error_return(EINVAL);
+	thrdErr = mtx_lock(&nPt->lock);
+	nPt->reactor_count = count;
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
+	return 0;
+}
+
 int mcr_intercept_platform_initialize(struct mcr_context *ctx)
 {
 	int thrdErr = 0, err = 0;
+	size_t i;
 	/* Free in deinitialize */
 	struct mcr_intercept_platform *nPt =
 		malloc(sizeof(struct mcr_intercept_platform));
@@ -168,6 +515,27 @@ int mcr_intercept_platform_initialize(struct mcr_context *ctx)
 	mcr_Array_init(&nPt->grab_contexts);
 	mcr_Array_set_all(&nPt->grab_contexts, mcr_ref_compare,
 					  sizeof(_grab_context *));
+	for (i = 0; i < MCR_REACTOR_MAX; i++) {
+		nPt->reactors[i].ctx = ctx;
+		nPt->reactors[i].epoll_fd = -1;
+		nPt->reactors[i].wake_fd = -1;
+		mcr_Array_init(&nPt->reactors[i].garbage);
+		mcr_Array_set_all(&nPt->reactors[i].garbage, NULL,
+						  sizeof(_grab_context *));
+		mcr_Array_init(&nPt->reactors[i].pending);
+		mcr_Array_set_all(&nPt->reactors[i].pending, NULL,
+						  sizeof(_grab_context *));
+		mcr_Array_init(&nPt->reactors[i].added);
+		mcr_Array_set_all(&nPt->reactors[i].added, NULL,
+						  sizeof(_grab_context *));
+		mcr_Array_init(&nPt->reactors[i].files);
+		mcr_Array_set_all(&nPt->reactors[i].files, NULL,
+						  sizeof(_grab_context *));
+		mcr_Ring_init(&nPt->reactors[i].ring);
+	}
+	nPt->reactor_count = 1;
+	nPt->watch_fd = -1;
+	nPt->passthrough_fd = -1;
 	mcr_StringSet_init(&nPt->grab_paths);
 	mcr_StringSet_set_all(&nPt->grab_paths, mcr_String_compare);
 	return err;
@@ -178,11 +546,18 @@ int mcr_intercept_platform_deinitialize(struct mcr_context *ctx)
 	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
 	/* Clear grabbers manages lock internally */
 	int thrdErr;
+	size_t i;
 	if (clear_grabbers(ctx))
 		dmsg;
 	thrdErr = mtx_lock(&nPt->lock);
 	mcr_StringSet_deinit(&nPt->grab_paths);
 	mcr_Array_deinit(&nPt->grab_contexts);
+	for (i = 0; i < MCR_REACTOR_MAX; i++) {
+		mcr_Array_deinit(&nPt->reactors[i].garbage);
+		mcr_Array_deinit(&nPt->reactors[i].pending);
+		mcr_Array_deinit(&nPt->reactors[i].added);
+		mcr_Array_deinit(&nPt->reactors[i].files);
+	}
 	if (thrdErr == thrd_success)
 		mtx_unlock(&nPt->lock);
 	mtx_destroy(&nPt->lock);
@@ -207,7 +582,8 @@ static int set_enabled_impl(struct mcr_context *ctx, bool enable)
 {
 	_context_bool *argEnable;
 	/* Do not disable if already disabled. */
-	if (enable || is_enabled_impl(ctx)) {
+	if (enable || is_enabled_impl(ctx)
+		|| reactors_running(ctx->intercept.platform)) {
 		/* Free in thread */
 		argEnable = malloc(sizeof(_context_bool));
 		if (!argEnable)
@@ -223,437 +599,1671 @@ static int set_enabled_impl(struct mcr_context *ctx, bool enable)
 	return 0;
 }
 
+/* Modifiers are kept from each key stream, and read from devices only
+ * when opened or after dropped events. */
 static unsigned int get_mods_impl(struct mcr_context *ctx)
 {
 	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
 	_grab_context **grabSet = MCR_ARR_FIRST(nPt->grab_contexts);
-	unsigned int ret;
-	/* One modifier for each key that has a modifier mapped */
-	size_t modKeysCount = mcr_Key_modifier_count(ctx);
-	unsigned int *modArr = malloc(sizeof(unsigned int) * modKeysCount);
-	char *bitRetrieval = nPt->bit_retrieval;
-	size_t modSize = modbit_size(), i = nPt->grab_contexts.used;
-	int fd;
-	if (!modArr)
-		mset_error_return(ENOMEM);
-	/* Fill modifiers mapped from a key */
-	mcr_Key_modifier_all(ctx, modArr, modKeysCount);
-	if (ioctl(mcr_genDev.fd, EVIOCGKEY(modSize), bitRetrieval) < 0) {
-		mcr_errno(EINTR);
-		free(modArr);
-		return MCR_MF_NONE;
-	}
-	/// \bug handle MCR_MOD_ANY as an error
-	ret = modify_eventbits(ctx, modArr, modKeysCount, bitRetrieval);
+	size_t i = nPt->grab_contexts.used;
+	unsigned int ret = MCR_MF_NONE;
 	while (i--) {
-		if ((fd = grabSet[i]->grabber.fd) != -1) {
-			if (ioctl(fd, EVIOCGKEY(modSize),
-					  bitRetrieval) < 0) {
-				mcr_errno(EINTR);
-			} else {
-				ret |= modify_eventbits(ctx, modArr,
-										modKeysCount, bitRetrieval);
-			}
-		}
+		ret |= grabSet[i]->disp.mods;
 	}
-	free(modArr);
 	return ret;
 }
 
+/* Modifiers of all modifier keys set in a device key state */
+static void mods_update(struct mcr_context *ctx,
+						struct _dispatch_state *dsPt)
+{
+	struct mcr_Map *mapPt = &ctx->standard.map_key_modifier;
+	unsigned int mods = MCR_MF_NONE;
+	char *itPt, *end;
+	size_t bytes;
+	int key;
+	for (mcr_Array_iter(&mapPt->set, &itPt, &end, &bytes); itPt < end;
+		 itPt += bytes) {
+		key = *(int *)itPt;
+		if (key > 0 && key < KEY_CNT
+			&& MCR_EVENTBIT_ISSET(dsPt->key_bits, key)) {
+			mods |= *(unsigned int *)MCR_MAP_VALUEOF(*mapPt, itPt);
+		}
+	}
+	dsPt->mods = mods;
+}
+
 static int thread_enable(void *threadArgs)
 {
 	_context_bool cb = *(_context_bool *) threadArgs;
 	struct mcr_intercept_platform *nPt = cb.ctx->intercept.platform;
 	int err = 0, thrdErr;
-	mcr_String *pathArr = MCR_ARR_FIRST(nPt->grab_paths);
-	size_t i = nPt->grab_paths.used;
 	/* Free args when no longer in use */
 	free(threadArgs);
-	/* Always clear. Do not grab what is already grabbed */
+	if (!cb.bVal)
+		return clear_grabbers(cb.ctx) ? thrd_error : thrd_success;
+	/* Already enabled, only grab what is not grabbed yet. */
+	thrdErr = mtx_lock(&nPt->lock);
+	if (!reactors_running(nPt))
+		err = start_reactors(cb.ctx);
+	if (!err)
+		err = sync_grabbers(cb.ctx);
+	/* Grabbing listed paths does not depend on watching. */
+	if (!err && watch_start(cb.ctx))
+		dmsg;
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
 	/* Clear grabbers manages mutex internally */
-	if (nPt->grab_contexts.used)
-		err = clear_grabbers(cb.ctx);
-	if (!err && cb.bVal) {
-		thrdErr = mtx_lock(&nPt->lock);
-		while (i--) {
-			if (grab_impl(cb.ctx, pathArr[i].array))
-				break;
+	if (err)
+		clear_grabbers(cb.ctx);
+	return mcr_err ? thrd_error : thrd_success;
+}
+
+/* Remove grabbers not in grab_paths, grab paths not yet grabbed, and
+ * apply blocking to existing grabbers.
+ * \pre mutex locked
+ * \post mutex locked
+ */
+static int sync_grabbers(struct mcr_context *ctx)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	_grab_context **ptArr = MCR_ARR_FIRST(nPt->grab_contexts);
+	mcr_String *pathArr = MCR_ARR_FIRST(nPt->grab_paths);
+	size_t i = nPt->grab_contexts.used;
+	struct timespec delay;
+	delay.tv_sec = 0;
+	/* 10 milli */
+	delay.tv_nsec = 1000 * 1000 * 10;
+	/* Removing only moves contexts after the current one. */
+	while (i--) {
+		if (ptArr[i]->replay) {
+			ptArr[i]->grabber.blocking = ctx->intercept.blockable;
+		} else if (!ptArr[i]->auto_grab
+			&& !mcr_StringSet_find(&nPt->grab_paths,
+								   ptArr[i]->grabber.path.array)) {
+			remove_context(ptArr[i]);
+		} else if (mcr_Grabber_set_blocking(&ptArr[i]->grabber,
+											ctx->intercept.blockable)) {
+			dmsg;
 		}
-		if (thrdErr == thrd_success)
-			mtx_unlock(&nPt->lock);
 	}
-	return mcr_err ? thrd_error : thrd_success;
+	for (i = nPt->grab_paths.used; i--;) {
+		if (find_context(nPt, pathArr[i].array))
+			continue;
+		/* One device failing to open does not stop others. */
+		if (grab_impl(ctx, pathArr[i].array, false)) {
+			dmsg;
+		} else {
+			/* Give a delay between grabs. */
+			thrd_sleep(&delay, NULL);
+		}
+	}
+	return 0;
 }
 
 /* \pre mutex locked
  * \post mutex locked
  */
-static int grab_impl(struct mcr_context *ctx, const char *grabPath)
+static int grab_impl(struct mcr_context *ctx, const char *grabPath,
+					 bool autoGrab)
 {
-	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
-	/* Freed when thread is done with it */
+	/* Freed by the reactor when removed */
 	_grab_context *pt;
+	int err;
 	if (!grabPath || grabPath[0] == '\0')
 		return 0;
 	dassert(grabPath);
 	if (grab_context_malloc(&pt, ctx))
 		return mcr_err;
-	if (mcr_Grabber_set_path(&pt->grabber, grabPath)) {
+	if (mcr_Grabber_set_path(&pt->grabber, grabPath)
+		|| mcr_Grabber_set_enabled(&pt->grabber, true)) {
 		grab_context_free(&pt);
 		return mcr_err;
 	}
+	pt->auto_grab = autoGrab;
+	if ((err = context_add(ctx, pt))) {
+		grab_context_free(&pt);
+		mset_error_return(err);
+	}
+	return 0;
+}
+
+/* Start reading an opened grab context with the least busy reactor.
+ * On error the context is not added, and not freed.
+ * \pre mutex locked
+ * \post mutex locked
+ */
+static int context_add(struct mcr_context *ctx, _grab_context *pt)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	struct mcr_Reactor *reactorPt = NULL;
+	struct epoll_event ev = { 0 };
+	uint64_t wake = 1;
+	size_t i;
+	for (i = 0; i < MCR_REACTOR_MAX; i++) {
+		if (nPt->reactors[i].epoll_fd != -1 && (!reactorPt
+												|| nPt->reactors[i].grab_count < reactorPt->grab_count)) {
+			reactorPt = nPt->reactors + i;
+		}
+	}
+	if (!reactorPt)
+		mset_error_return(EPERM);
 	if (mcr_Array_add(&nPt->grab_contexts, &pt, 1, true)) {
 		/* Not able to add reference */
 		mcr_Array_remove(&nPt->grab_contexts, &pt);
-		grab_context_free(&pt);
 		return mcr_err;
-	} else if (mcr_thrd(intercept_start,
-						pt)) {
-		/* Not able to start thread */
+	}
+	/* Ready to read before the reactor can read it */
+	pt->reactor = reactorPt;
+	set_dispatch(pt);
+	mcr_Grabber_set_coalesce(&pt->grabber, nPt->coalesce_usec,
+							 nPt->coalesce_frames);
+	pt->output = nPt->output;
+	state_read(pt);
+	/* Only the reactor thread submits to its io_uring. */
+	if (mcr_Ring_is_open(&reactorPt->ring)) {
+		if (mcr_Array_push(&reactorPt->added, &pt)) {
+			pt->reactor = NULL;
+			mcr_Array_remove(&nPt->grab_contexts, &pt);
+			return mcr_err;
+		}
+		if (write(reactorPt->wake_fd, &wake, sizeof(wake)) < 0)
+			dmsg;
+		++reactorPt->grab_count;
+		return 0;
+	}
+	if (pt->file) {
+		if (mcr_Array_push(&reactorPt->files, &pt)) {
+			pt->reactor = NULL;
+			mcr_Array_remove(&nPt->grab_contexts, &pt);
+			return mcr_err;
+		}
+		if (write(reactorPt->wake_fd, &wake, sizeof(wake)) < 0)
+			dmsg;
+		++reactorPt->grab_count;
+		return 0;
+	}
+	ev.events = EPOLLIN;
+	ev.data.ptr = pt;
+	if (epoll_ctl(reactorPt->epoll_fd, EPOLL_CTL_ADD, pt->grabber.fd,
+				  &ev) < 0) {
+		mcr_errno(EINTR);
+		pt->reactor = NULL;
 		mcr_Array_remove(&nPt->grab_contexts, &pt);
-		grab_context_free(&pt);
 		return mcr_err;
 	}
+	++reactorPt->grab_count;
 	return 0;
 }
 
-static inline int abspos(int evPos)
-{
-	switch (evPos) {
-	case ABS_X:
-		return MCR_X;
-	case ABS_Y:
-		return MCR_Y;
-	case ABS_Z:
-		return MCR_Z;
-	}
-	return MCR_DIMENSION_CNT;
-}
-
-static inline int relpos(int evPos)
+/* \pre mutex locked */
+static _grab_context *find_context(struct mcr_intercept_platform *nPt,
+								   const char *grabPath)
 {
-	switch (evPos) {
-	case REL_X:
-	case REL_HWHEEL:
-		return MCR_X;
-	case REL_Y:
-	case REL_WHEEL:
-		return MCR_Y;
-	case REL_Z:
-	case REL_DIAL:
-		return MCR_Z;
+	_grab_context **ptArr = MCR_ARR_FIRST(nPt->grab_contexts);
+	size_t i = nPt->grab_contexts.used;
+	while (i--) {
+		if (!mcr_String_compare(&ptArr[i]->grabber.path.array, &grabPath))
+			return ptArr[i];
 	}
-	return MCR_DIMENSION_CNT;
-}
-
-static inline void abs_set_current(struct mcr_MoveCursor *abs,
-								   bool hasPosArray[])
-{
-	if (!(hasPosArray)[MCR_X])
-		abs->pos[MCR_X] = mcr_cursor[MCR_X];
-	if (!(hasPosArray)[MCR_Y])
-		abs->pos[MCR_Y] = mcr_cursor[MCR_Y];
-	if (!(hasPosArray)[MCR_Z])
-		abs->pos[MCR_Z] = mcr_cursor[MCR_Z];
+	return NULL;
 }
 
-/* Note: Excess time setting up and releasing is ok. Please try to limit
- * time-consumption during grabbing and callbacks. */
-/* \pre Thread args is heap-allocated _grab_context. It is assumed to
- * already have a path.
+/* Stop reading a grabber.  The reactor may still be reading it, so the
+ * reactor closes and frees it between reads.
+ * \pre mutex locked
+ * \post mutex locked
  */
-static int intercept_start(void *threadArgs)
+static void remove_context(_grab_context *gcPt)
 {
-	/* Free in thread when done with it */
-	_grab_context *gcPt = threadArgs;
 	struct mcr_intercept_platform *nPt = gcPt->ctx->intercept.platform;
-	struct mcr_Grabber *grabPt = &gcPt->grabber;
-	int thrdErr = thrd_success, mtxErr = thrd_success;
-	struct timespec delay;
-	dassert(threadArgs);
-	delay.tv_sec = 0;
-	/* 10 milli */
-	delay.tv_nsec = 1000 * 1000 * 10;
-	/*! \todo Enable grabber before thread.
-	 * 1. Create grab from path.
-	 * 2. Enable (Current step)
-	 * 3. Use grabber
-	 * 4. Always free grabber before end of thread
-	 */
-	mtxErr = mtx_lock(&nPt->lock);
-	if (mcr_Grabber_set_enabled(grabPt, true)) {
-		mcr_Array_remove(&nPt->grab_contexts, &gcPt);
+	struct mcr_Reactor *reactorPt = gcPt->reactor;
+	uint64_t wake = 1;
+	if (gcPt->removed)
+		return;
+	gcPt->removed = true;
+	mcr_Array_remove(&nPt->grab_contexts, &gcPt);
+	if (!reactorPt || reactorPt->epoll_fd == -1) {
 		grab_context_free(&gcPt);
-		if (mtxErr == thrd_success)
-			mtx_unlock(&nPt->lock);
-		return thrd_error;
+		return;
 	}
-	/* Give a delay between grabs before unlocking. */
-	thrd_sleep(&delay, NULL);
-	if (mtxErr == thrd_success)
-		mtx_unlock(&nPt->lock);
-	/* Will return an error if not enabled. */
-	thrdErr = read_grabber_loop(gcPt->ctx, grabPt);
-	mtxErr = mtx_lock(&nPt->lock);
-	mcr_Grabber_set_enabled(grabPt, false);
-	mcr_Array_remove(&nPt->grab_contexts, &gcPt);
-	grab_context_free(&gcPt);
-	if (mtxErr == thrd_success)
-		mtx_unlock(&nPt->lock);
-	if (thrdErr) {
-		if (!mcr_err) {
-			mset_error(mcr_thrd_errno(thrdErr));
-		}
-		return thrdErr;
+	if (gcPt->grabber.fd != -1 && !gcPt->file)
+		epoll_ctl(reactorPt->epoll_fd, EPOLL_CTL_DEL, gcPt->grabber.fd, NULL);
+	--reactorPt->grab_count;
+	if (mcr_Array_push(&reactorPt->garbage, &gcPt)) {
+		/* Leak rather than free something in use */
+		dmsg;
+		return;
 	}
-	return mcr_err ? thrd_error : thrd_success;
+	if (write(reactorPt->wake_fd, &wake, sizeof(wake)) < 0)
+		dmsg;
 }
 
-static int read_grabber_loop(struct mcr_context *ctx,
-							 struct mcr_Grabber *grabPt)
+static bool reactors_running(struct mcr_intercept_platform *nPt)
 {
-	/* For abs and rel, keep memory of having such event type
-	 * at least once. */
-#define DISP_WRITEMEM(signal) \
-if (mcr_dispatch(ctx, &(signal)) && blocking && writegen) { \
-	writegen = false; \
-}
-#define DISP_WRITEMEM_ABS(signal) \
-if (mcr_dispatch(ctx, &(signal))) { \
-	if (blocking && writeabs) \
-		writeabs = false; \
-} else if (blocking && !writeabs) { \
-	writeabs = true; \
+	size_t i;
+	for (i = 0; i < MCR_REACTOR_MAX; i++) {
+		if (nPt->reactors[i].epoll_fd != -1)
+			return true;
+	}
+	return false;
 }
-	struct input_event events[MCR_GRAB_SET_LENGTH];
-	struct input_event *curVent, *end;
-	/* Always assume writing to the generic device.  Start writing
-	   to abs and rel only if those events happen at least once. */
-	int rdb;
-	int i, pos;
-	/* Write generic whenever not blocked, write abs only when available */
-	bool writegen = true, writeabs = false, blocking = grabPt->blocking;
-	bool bAbs[MCR_DIMENSION_CNT] = { 0 };
-	int *echoFound = NULL;
-	struct mcr_Key key = { 0 };
-	struct mcr_HidEcho echo = { 0 };
-	struct mcr_MoveCursor abs = { 0 }, rel = {
-		0
-	};
-	struct mcr_Scroll scr = { 0 };
-	struct mcr_Signal keysig, echosig, abssig, relsig, scrsig;
-	struct pollfd fd = { 0 };
-	dassert(grabPt);
-	mcr_Signal_init(&keysig);
-	mcr_Signal_init(&echosig);
-	mcr_Signal_init(&abssig);
-	mcr_Signal_init(&relsig);
-	mcr_Signal_init(&scrsig);
-	mcr_Instance_set_all(&keysig, mcr_iKey(ctx), &key, NULL);
-	mcr_Instance_set_all(&echosig, mcr_iHidEcho(ctx), &echo, NULL);
-	mcr_Instance_set_all(&abssig, mcr_iMoveCursor(ctx), &abs, NULL);
-	mcr_Instance_set_all(&relsig, mcr_iMoveCursor(ctx), &rel, NULL);
-	mcr_Instance_set_all(&scrsig, mcr_iScroll(ctx), &scr, NULL);
-	keysig.is_dispatch = true;
-	echosig.is_dispatch = true;
-	abssig.is_dispatch = true;
-	relsig.is_dispatch = true;
-	scrsig.is_dispatch = true;
-	rel.is_justify = true;
-	fd.events = POLLIN | POLLPRI | POLLRDNORM | POLLRDBAND;
-	fd.fd = grabPt->fd;
-	/* Disable point 1 */
-	while (grabPt->fd != -1) {
-		/* Disable point 2. */
-		i = poll(&fd, 1, MCR_POLL_TIMEOUT);
-		/* Do not err on closed events */
-		if (grabPt->fd == -1)
-			return thrd_success;
-		/* Error or no data in 10 seconds, try again. */
-		if (!i || i < 0)
+
+/* \pre mutex locked
+ * \post mutex locked
+ */
+static int start_reactors(struct mcr_context *ctx)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	struct mcr_Reactor *reactorPt;
+	struct epoll_event ev = { 0 };
+	size_t i;
+	int thrdErr;
+	dassert(nPt->reactor_count && nPt->reactor_count <= MCR_REACTOR_MAX);
+	for (i = 0; i < nPt->reactor_count; i++) {
+		reactorPt = nPt->reactors + i;
+		if (reactorPt->epoll_fd != -1)
 			continue;
-		/* Disable point 3, but assume readable from poll above.
-		 * If rdb < input_event size then we are returning an error. */
-		rdb = read(fd.fd, events, sizeof(events));
-		/* Do not err on closed events */
-		if (grabPt->fd == -1)
-			return thrd_success;
-		if (rdb < (int) sizeof(struct input_event)) {
-			mcr_errno(0);
-			if (!mcr_err || mcr_err == EINTR)
-				return thrd_success;
-			return thrd_error;
-		}
-		curVent = events;
-		end = (struct input_event *)(((char *)events) + rdb);
-		while (curVent < end) {
-			switch (curVent->type) {
-			/* Handle KEY */
-			case EV_KEY:
-				if (key.key) {
-					echoFound =
-						MCR_MAP_ELEMENT(mcr_keyToEcho
-										[key.apply], &key.key);
-					if (echoFound) {
-						echoFound =
-							MCR_MAP_VALUEOF
-							(mcr_keyToEcho
-							 [key.apply],
-							 echoFound);
-						echo.echo = *echoFound;
-						DISP_WRITEMEM(echosig);
-						/* No need to reset echo,
-						 * which depends on EV_KEY */
-					}
-					DISP_WRITEMEM(keysig);
-					key.key = curVent->code;
-					key.apply =
-						curVent->value ? MCR_SET :
-						MCR_UNSET;
-				} else {
-					key.key = curVent->code;
-					key.apply =
-						curVent->value ? MCR_SET :
-						MCR_UNSET;
-				}
+		reactorPt->stopping = false;
+		reactorPt->grab_count = 0;
+		if ((reactorPt->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+			mcr_errno(EINTR);
+			return mcr_err;
+		}
+		if ((reactorPt->wake_fd = eventfd(0,
+										  EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+			mcr_errno(EINTR);
+			close(reactorPt->epoll_fd);
+			reactorPt->epoll_fd = -1;
+			return mcr_err;
+		}
+		/* Wake has no grab context */
+		ev.events = EPOLLIN;
+		ev.data.ptr = NULL;
+		if (nPt->ring_enabled && ring_open(reactorPt))
+			dmsg;
+		if (epoll_ctl(reactorPt->epoll_fd, EPOLL_CTL_ADD, reactorPt->wake_fd,
+					  &ev) < 0) {
+			mcr_errno(EINTR);
+		} else if ((thrdErr = thrd_create(&reactorPt->thread, reactor_loop,
+										  reactorPt)) != thrd_success) {
+			mset_error(mcr_thrd_errno(thrdErr));
+		} else {
+			continue;
+		}
+		ring_close(reactorPt);
+		close(reactorPt->wake_fd);
+		close(reactorPt->epoll_fd);
+		reactorPt->wake_fd = reactorPt->epoll_fd = -1;
+		return mcr_err;
+	}
+	return 0;
+}
+
+/* \pre mutex not locked, reactor threads may need it to finish
+ * \post mutex not locked
+ */
+static void stop_reactors(struct mcr_context *ctx)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	struct mcr_Reactor *reactorPt;
+	uint64_t wake = 1;
+	size_t i;
+	int thrdErr;
+	for (i = 0; i < MCR_REACTOR_MAX; i++) {
+		reactorPt = nPt->reactors + i;
+		if (reactorPt->epoll_fd == -1)
+			continue;
+		reactorPt->stopping = true;
+		if (write(reactorPt->wake_fd, &wake, sizeof(wake)) < 0)
+			dmsg;
+		/* Reactors do not disable intercept, but do not wait on self
+		 * in case a dispatch receiver does. */
+		if (thrd_equal(thrd_current(), reactorPt->thread)) {
+			thrd_detach(reactorPt->thread);
+		} else if (thrd_join(reactorPt->thread, NULL) != thrd_success) {
+			dmsg;
+		}
+	}
+	thrdErr = mtx_lock(&nPt->lock);
+	watch_stop(ctx);
+	for (i = 0; i < MCR_REACTOR_MAX; i++) {
+		reactorPt = nPt->reactors + i;
+		if (reactorPt->epoll_fd == -1)
+			continue;
+		reactor_collect(reactorPt);
+		/* Added contexts are freed with all others. */
+		reactorPt->added.used = 0;
+		reactorPt->files.used = 0;
+		ring_close(reactorPt);
+		close(reactorPt->wake_fd);
+		close(reactorPt->epoll_fd);
+		reactorPt->wake_fd = reactorPt->epoll_fd = -1;
+		reactorPt->grab_count = 0;
+	}
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
+}
+
+/* Free removed grab contexts.  Contexts still read by io_uring are
+ * cancelled, and freed after the read is finished.
+ * \pre mutex locked
+ * \post mutex locked
+ */
+static void reactor_collect(struct mcr_Reactor *reactorPt)
+{
+	_grab_context **ptArr = MCR_ARR_FIRST(reactorPt->garbage);
+	size_t i = reactorPt->garbage.used;
+	while (i--) {
+		if (ptArr[i]->ring_busy) {
+			ring_cancel(reactorPt, ptArr[i]);
+			continue;
+		}
+		mcr_Array_remove(&reactorPt->pending, ptArr + i);
+		mcr_Array_remove(&reactorPt->added, ptArr + i);
+		mcr_Array_remove(&reactorPt->files, ptArr + i);
+		grab_context_free(ptArr + i);
+		mcr_Array_remove_index(&reactorPt->garbage, i, 1);
+	}
+}
+
+/* Note: Excess time setting up and releasing is ok. Please try to limit
+ * time-consumption during grabbing and callbacks. */
+/* One thread reads all grabbers of this reactor. */
+static int reactor_loop(void *threadArgs)
+{
+	struct mcr_Reactor *reactorPt = threadArgs;
+	struct mcr_context *ctx = reactorPt->ctx;
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	struct epoll_event events[MCR_REACTOR_EVENTS];
+	int count, thrdErr, timeout = MCR_POLL_TIMEOUT;
+	bool files = false;
+	dassert(threadArgs);
+	/* Failure is not fatal, continue with default scheduling. */
+	if (mcr_ThreadOptions_isset(&ctx->intercept.thread_options)) {
+		mcr_atomic_store(&ctx->intercept.thread_options_error,
+						 (size_t)(mcr_thrd_set_options(&ctx->intercept.thread_options) ?
+								  mcr_read_err() : 0));
+	}
+	if (mcr_Ring_is_open(&reactorPt->ring))
+		return ring_loop(reactorPt);
+	while (!reactorPt->stopping) {
+		/* Regular files are always readable, do not wait. */
+		count = epoll_wait(reactorPt->epoll_fd, events, MCR_REACTOR_EVENTS,
+						   files ? 0 : timeout);
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+			mcr_errno(EINTR);
+			break;
+		}
+		reactor_ready(reactorPt, events, count);
+		files = reactor_files(reactorPt);
+		if (reactorPt->garbage.used) {
+			thrdErr = mtx_lock(&nPt->lock);
+			reactor_collect(reactorPt);
+			if (thrdErr == thrd_success)
+				mtx_unlock(&nPt->lock);
+		}
+		/* Wait only until the next coalesced motion is due. */
+		if (reactor_flush(reactorPt, &timeout))
+			dmsg;
+	}
+	return mcr_err ? thrd_error : thrd_success;
+}
+
+/* Read the wake, watcher, and grabbers read with epoll. */
+static void reactor_ready(struct mcr_Reactor *reactorPt,
+						  struct epoll_event *events, int count)
+{
+	struct mcr_intercept_platform *nPt = reactorPt->ctx->intercept.platform;
+	_grab_context *gcPt;
+	uint64_t wake;
+	int i, thrdErr;
+	for (i = 0; i < count && !reactorPt->stopping; i++) {
+		gcPt = events[i].data.ptr;
+		if (!gcPt) {
+			if (read(reactorPt->wake_fd, &wake, sizeof(wake)) < 0)
+				dmsg;
+			/* Start reading grabbers added to io_uring */
+			if (reactorPt->added.used) {
+				thrdErr = mtx_lock(&nPt->lock);
+				ring_added(reactorPt);
+				if (thrdErr == thrd_success)
+					mtx_unlock(&nPt->lock);
+			}
+			continue;
+		}
+		if (events[i].data.ptr == &nPt->watch_fd) {
+			thrdErr = mtx_lock(&nPt->lock);
+			watch_read(reactorPt->ctx);
+			if (thrdErr == thrd_success)
+				mtx_unlock(&nPt->lock);
+			continue;
+		}
+		/* Removed after this wait, do not read again. */
+		if (gcPt->removed)
+			continue;
+		/* Error is most likely a removed device, only this
+		 * grabber is removed. */
+		if (read_grabber(gcPt)) {
+			thrdErr = mtx_lock(&nPt->lock);
+			remove_context(gcPt);
+			if (thrdErr == thrd_success)
+				mtx_unlock(&nPt->lock);
+		}
+	}
+}
+
+/* Read replays of regular files, the same as readable grabbers.  Files
+ * beyond MCR_REACTOR_EVENTS are read after others are finished.
+ * \return True if any files are being read */
+static bool reactor_files(struct mcr_Reactor *reactorPt)
+{
+	struct mcr_intercept_platform *nPt = reactorPt->ctx->intercept.platform;
+	_grab_context *files[MCR_REACTOR_EVENTS];
+	size_t i, count;
+	int thrdErr = mtx_lock(&nPt->lock);
+	count = reactorPt->files.used;
+	if (count > MCR_REACTOR_EVENTS)
+		count = MCR_REACTOR_EVENTS;
+	if (count)
+		memcpy(files, reactorPt->files.array, count * sizeof(_grab_context *));
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
+	/* Only this reactor frees removed contexts, after reading. */
+	for (i = 0; i < count && !reactorPt->stopping; i++) {
+		if (!files[i]->removed && read_grabber(files[i])) {
+			thrdErr = mtx_lock(&nPt->lock);
+			remove_context(files[i]);
+			if (thrdErr == thrd_success)
+				mtx_unlock(&nPt->lock);
+		}
+	}
+	return count != 0;
+}
+
+/* Use io_uring for a reactor.  If not able to, the reactor uses epoll.
+ * \pre mutex locked, reactor not running
+ * \post mutex locked
+ */
+static int ring_open(struct mcr_Reactor *reactorPt)
+{
+	if (mcr_Ring_open(&reactorPt->ring, MCR_RING_ENTRIES))
+		return mcr_err;
+	reactorPt->ring_writes = calloc(MCR_RING_WRITES,
+									sizeof(struct mcr_RingWrite));
+	if (!reactorPt->ring_writes) {
+		mcr_Ring_close(&reactorPt->ring);
+		mset_error_return(ENOMEM);
+	}
+	reactorPt->ring_reads = 0;
+	reactorPt->ring_last_write = NULL;
+	return 0;
+}
+
+static void ring_close(struct mcr_Reactor *reactorPt)
+{
+	mcr_Ring_close(&reactorPt->ring);
+	free(reactorPt->ring_writes);
+	reactorPt->ring_writes = NULL;
+	reactorPt->ring_reads = 0;
+	reactorPt->ring_last_write = NULL;
+}
+
+/* Submitted writes can no longer be linked. */
+static int ring_submit(struct mcr_Reactor *reactorPt, unsigned int waitCount,
+					   int timeoutMsec)
+{
+	reactorPt->ring_last_write = NULL;
+	return mcr_Ring_submit(&reactorPt->ring, waitCount, timeoutMsec);
+}
+
+/* Submission entry, submitting what is prepared if full.  A link is
+ * to the next entry, so writes after this entry are not linked to the
+ * last write. */
+static struct io_uring_sqe *ring_sqe(struct mcr_Reactor *reactorPt)
+{
+	struct io_uring_sqe *sqePt = mcr_Ring_sqe(&reactorPt->ring);
+	if (!sqePt && !ring_submit(reactorPt, 0, 0))
+		sqePt = mcr_Ring_sqe(&reactorPt->ring);
+	if (!sqePt)
+		mset_error(EBUSY);
+	reactorPt->ring_last_write = NULL;
+	return sqePt;
+}
+
+/* Read a grabber, or poll until readable. */
+static int ring_arm(struct mcr_Reactor *reactorPt, _grab_context *gcPt,
+					int tag)
+{
+	struct io_uring_sqe *sqePt = ring_sqe(reactorPt);
+	if (!sqePt)
+		return mcr_err;
+	sqePt->fd = gcPt->grabber.fd;
+	if (tag == RING_POLL) {
+		sqePt->opcode = IORING_OP_POLL_ADD;
+		sqePt->poll32_events = POLLIN;
+	} else {
+		sqePt->opcode = IORING_OP_READ;
+		sqePt->addr = (uintptr_t)gcPt->ring_buffer;
+		sqePt->len = sizeof(gcPt->ring_buffer);
+		/* Current file position, replays may be regular files */
+		sqePt->off = (uint64_t) - 1;
+	}
+	gcPt->ring_data = sqePt->user_data = RING_DATA(gcPt, tag);
+	gcPt->ring_busy = true;
+	gcPt->ring_canceled = false;
+	++reactorPt->ring_reads;
+	return 0;
+}
+
+static void ring_cancel(struct mcr_Reactor *reactorPt, _grab_context *gcPt)
+{
+	struct io_uring_sqe *sqePt;
+	if (!gcPt->ring_busy || gcPt->ring_canceled)
+		return;
+	/* Cancel completion has no user data */
+	if ((sqePt = ring_sqe(reactorPt))) {
+		sqePt->opcode = IORING_OP_ASYNC_CANCEL;
+		sqePt->addr = gcPt->ring_data;
+		gcPt->ring_canceled = true;
+	}
+}
+
+/* \pre mutex locked
+ * \post mutex locked
+ */
+static void ring_added(struct mcr_Reactor *reactorPt)
+{
+	_grab_context **ptArr = MCR_ARR_FIRST(reactorPt->added);
+	size_t i;
+	/* Poll first, the same as epoll, in case a file without data is at
+	 * its end. */
+	for (i = 0; i < reactorPt->added.used; i++) {
+		if (!ptArr[i]->removed && ring_arm(reactorPt, ptArr[i], RING_POLL)) {
+			dmsg;
+			remove_context(ptArr[i]);
+		}
+	}
+	reactorPt->added.used = 0;
+}
+
+/* A grabber read or poll is finished, read again unless removed. */
+static void ring_complete(struct mcr_Reactor *reactorPt, _grab_context *gcPt,
+						  int tag, int res)
+{
+	struct mcr_intercept_platform *nPt = reactorPt->ctx->intercept.platform;
+	int thrdErr, err = 0;
+	gcPt->ring_busy = false;
+	--reactorPt->ring_reads;
+	if (gcPt->removed)
+		return;
+	/* Interrupted or cancelled by a linked request, read again */
+	if (tag == RING_READ && res != -EINTR && res != -ECANCELED) {
+		/* Non-blocking files are not polled by io_uring in some
+		 * kernel versions. */
+		if (res == -EAGAIN) {
+			tag = RING_POLL;
+		} else {
+			if (res < 0)
+				errno = -res;
+			err = grabber_events(gcPt, gcPt->ring_buffer, res);
+			tag = RING_READ;
+		}
+	} else {
+		tag = RING_READ;
+	}
+	/* A receiver may remove while dispatching. */
+	if (!err && !gcPt->removed)
+		err = ring_arm(reactorPt, gcPt, tag);
+	if (err) {
+		thrdErr = mtx_lock(&nPt->lock);
+		remove_context(gcPt);
+		if (thrdErr == thrd_success)
+			mtx_unlock(&nPt->lock);
+	}
+}
+
+/* One io_uring submit and wait for all reads and passthrough writes.
+ * The wake and watcher are still read with epoll, polled by io_uring.
+ */
+static int ring_loop(struct mcr_Reactor *reactorPt)
+{
+	struct mcr_intercept_platform *nPt = reactorPt->ctx->intercept.platform;
+	struct epoll_event events[MCR_REACTOR_EVENTS];
+	struct io_uring_sqe *sqePt;
+	struct io_uring_cqe *cqePt;
+	struct mcr_RingWrite *writePt;
+	_grab_context *gcPt;
+	uint64_t data;
+	bool epollArmed = false;
+	int res, count, thrdErr, timeout = MCR_POLL_TIMEOUT;
+	while (!reactorPt->stopping) {
+		if (!epollArmed && (sqePt = ring_sqe(reactorPt))) {
+			sqePt->opcode = IORING_OP_POLL_ADD;
+			sqePt->fd = reactorPt->epoll_fd;
+			sqePt->poll32_events = POLLIN;
+			sqePt->user_data = RING_DATA(reactorPt, RING_EPOLL);
+			epollArmed = true;
+		}
+		if (ring_submit(reactorPt, 1, timeout))
+			break;
+		while ((cqePt = mcr_Ring_cqe(&reactorPt->ring))) {
+			data = cqePt->user_data;
+			res = cqePt->res;
+			mcr_Ring_seen(&reactorPt->ring);
+			switch (RING_TAG(data)) {
+			case RING_EPOLL:
+				epollArmed = false;
+				count = epoll_wait(reactorPt->epoll_fd, events,
+								   MCR_REACTOR_EVENTS, 0);
+				if (count > 0)
+					reactor_ready(reactorPt, events, count);
 				break;
-			/* Handle ABS */
-			case EV_ABS:
-				pos = abspos(curVent->code);
-				if (bAbs[pos]) {
-					abs_set_current(&abs, bAbs);
-					DISP_WRITEMEM_ABS(abssig);
-					MCR_DIMENSIONS_ZERO(bAbs);
-				}
-				abs.pos[pos] = curVent->value;
-				bAbs[pos] = true;
+			case RING_WRITE:
+				writePt = RING_POINTER(data);
+				writePt->busy = false;
+				if (res < 0)
+					dmsg;
 				break;
-			case EV_REL:
-				pos = relpos(curVent->code);
-				switch (curVent->code) {
-				case REL_X:
-				case REL_Y:
-				case REL_Z:
-					if (rel.pos[pos]) {
-						DISP_WRITEMEM(relsig);
-						MCR_DIMENSIONS_ZERO(rel.pos);
-					}
-					rel.pos[pos] = curVent->value;
-					break;
-				default:
-					/* Currently assuming scroll if not relative movement. */
-					if (scr.dm[pos]) {
-						DISP_WRITEMEM(scrsig);
-						MCR_DIMENSIONS_ZERO(scr.dm);
-					}
-					scr.dm[pos] = curVent->value;
-					break;
-				}
+			default:
+				/* Cancel completions have no grab context */
+				if ((gcPt = RING_POINTER(data)))
+					ring_complete(reactorPt, gcPt, RING_TAG(data), res);
 				break;
 			}
-			++curVent;
-		}
-		/* Call final event, it was not called yet. */
-		if (key.key) {
-			echoFound =
-				MCR_MAP_ELEMENT(mcr_keyToEcho
-								[key.apply], &key.key);
-			if (echoFound) {
-				echoFound =
-					MCR_MAP_VALUEOF(mcr_keyToEcho
-									[key.apply], echoFound);
-				echo.echo = *echoFound;
-				if (mcr_dispatch(ctx, &echosig) && blocking && writegen)
-					writegen = false;
+		}
+		if (reactorPt->garbage.used) {
+			thrdErr = mtx_lock(&nPt->lock);
+			reactor_collect(reactorPt);
+			if (thrdErr == thrd_success)
+				mtx_unlock(&nPt->lock);
+		}
+		if (reactor_flush(reactorPt, &timeout))
+			dmsg;
+	}
+	ring_drain(reactorPt);
+	return mcr_err ? thrd_error : thrd_success;
+}
+
+/* Cancel all reads of a stopping reactor and wait for them to finish,
+ * so grab contexts may be freed. */
+static void ring_drain(struct mcr_Reactor *reactorPt)
+{
+	struct mcr_intercept_platform *nPt = reactorPt->ctx->intercept.platform;
+	_grab_context **ptArr;
+	struct io_uring_cqe *cqePt;
+	_grab_context *gcPt;
+	uint64_t data;
+	size_t i;
+	int tries, thrdErr = mtx_lock(&nPt->lock);
+	ptArr = MCR_ARR_FIRST(nPt->grab_contexts);
+	for (i = nPt->grab_contexts.used; i--;) {
+		if (ptArr[i]->reactor == reactorPt)
+			ring_cancel(reactorPt, ptArr[i]);
+	}
+	ptArr = MCR_ARR_FIRST(reactorPt->garbage);
+	for (i = reactorPt->garbage.used; i--;) {
+		ring_cancel(reactorPt, ptArr[i]);
+	}
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
+	/* 10 milliseconds at a time, cancelled reads finish immediately */
+	for (tries = 0; reactorPt->ring_reads && tries < 100; tries++) {
+		if (ring_submit(reactorPt, 1, 10))
+			break;
+		while ((cqePt = mcr_Ring_cqe(&reactorPt->ring))) {
+			data = cqePt->user_data;
+			mcr_Ring_seen(&reactorPt->ring);
+			if (RING_TAG(data) == RING_WRITE) {
+				((struct mcr_RingWrite *)RING_POINTER(data))->busy = false;
+			} else if (RING_TAG(data) != RING_EPOLL
+					   && (gcPt = RING_POINTER(data))) {
+				gcPt->ring_busy = false;
+				--reactorPt->ring_reads;
 			}
-			DISP_WRITEMEM(keysig);
-			key.key = 0;
-			key.apply = MCR_BOTH;
-		}
-		if (bAbs[MCR_X] || bAbs[MCR_Y] || bAbs[MCR_Z]) {
-			abs_set_current(&abs, bAbs);
-			DISP_WRITEMEM_ABS(abssig);
-			MCR_DIMENSIONS_ZERO(bAbs);
-		}
-		for (i = MCR_DIMENSION_CNT; i--;) {
-			if (rel.pos[i]) {
-				DISP_WRITEMEM(relsig);
-				MCR_DIMENSIONS_ZERO(rel.pos);
-				break;
+		}
+	}
+	if (reactorPt->ring_reads)
+		dmsg;
+}
+
+/* Copy events not removed, and write with the next submit.
+ * \return False if not able to, and events should be written directly
+ */
+static bool ring_write(struct mcr_Reactor *reactorPt, int fd,
+					   const struct input_event *events, int count, const bool *dropArr)
+{
+	struct mcr_RingWrite *writePt = NULL;
+	struct io_uring_sqe *sqePt, *lastPt = reactorPt->ring_last_write;
+	int i, writeCount = 0;
+	for (i = 0; i < MCR_RING_WRITES; i++) {
+		if (!reactorPt->ring_writes[i].busy) {
+			writePt = reactorPt->ring_writes + i;
+			break;
+		}
+	}
+	/* Direct writes are after all writes already prepared. */
+	if (!writePt) {
+		if (ring_submit(reactorPt, 0, 0))
+			dmsg;
+		return false;
+	}
+	/* Full submits the last write, and it can no longer be linked. */
+	if (!(sqePt = mcr_Ring_sqe(&reactorPt->ring))) {
+		if (ring_submit(reactorPt, 0, 0)
+			|| !(sqePt = mcr_Ring_sqe(&reactorPt->ring))) {
+			mset_error(EBUSY);
+			return false;
+		}
+		lastPt = NULL;
+	}
+	for (i = 0; i < count; i++) {
+		if (!dropArr[i])
+			writePt->events[writeCount++] = events[i];
+	}
+	sqePt->opcode = IORING_OP_WRITE;
+	sqePt->fd = fd;
+	sqePt->addr = (uintptr_t)writePt->events;
+	sqePt->len = writeCount * sizeof(struct input_event);
+	sqePt->off = (uint64_t) - 1;
+	sqePt->user_data = RING_DATA(writePt, RING_WRITE);
+	/* Consecutive writes only start after earlier ones are finished.
+	 * Only the entry just before is linked, a link to any other request
+	 * would cancel it if this write fails. */
+	if (lastPt)
+		lastPt->flags |= IOSQE_IO_LINK;
+	reactorPt->ring_last_write = sqePt;
+	writePt->busy = true;
+	return true;
+}
+
+/* Watch the event directory with the first reactor, and grab all
+ * present devices.
+ * \pre mutex locked
+ * \post mutex locked
+ */
+static int watch_start(struct mcr_context *ctx)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	struct mcr_Reactor *reactorPt = NULL;
+	struct epoll_event ev = { 0 };
+	const char *dirPath = MCR_STR(MCR_EVENT_PATH);
+	char path[PATH_MAX];
+	struct dirent *entry;
+	DIR *dirPt;
+	size_t i;
+	if (!nPt->watch_enabled || nPt->watch_fd != -1)
+		return 0;
+	for (i = 0; i < MCR_REACTOR_MAX && !reactorPt; i++) {
+		if (nPt->reactors[i].epoll_fd != -1)
+			reactorPt = nPt->reactors + i;
+	}
+	/* Started with reactors */
+	if (!reactorPt)
+		return 0;
+	if ((nPt->watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) == -1) {
+		mcr_errno(EINTR);
+		return mcr_err;
+	}
+	/* Permissions are usually set after creating */
+	ev.events = EPOLLIN;
+	ev.data.ptr = &nPt->watch_fd;
+	if (inotify_add_watch(nPt->watch_fd, dirPath, IN_CREATE | IN_ATTRIB) == -1
+		|| epoll_ctl(reactorPt->epoll_fd, EPOLL_CTL_ADD, nPt->watch_fd,
+					 &ev) < 0) {
+		mcr_errno(ENOENT);
+		close(nPt->watch_fd);
+		nPt->watch_fd = -1;
+		return mcr_err;
+	}
+	if ((dirPt = opendir(dirPath))) {
+		while ((entry = readdir(dirPt))) {
+			if (!strncmp(entry->d_name, "event", 5)) {
+				snprintf(path, sizeof(path), "%s/%s", dirPath, entry->d_name);
+				watch_grab(ctx, path);
 			}
 		}
-		for (i = MCR_DIMENSION_CNT; i--;) {
-			if (scr.dm[i]) {
-				DISP_WRITEMEM(scrsig);
-				MCR_DIMENSIONS_ZERO(scr.dm);
-				break;
+		closedir(dirPt);
+	}
+	return 0;
+}
+
+/* Reactors are stopped, or the watcher is removed from epoll first.
+ * \pre mutex locked
+ * \post mutex locked
+ */
+static void watch_stop(struct mcr_context *ctx)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	size_t i;
+	if (nPt->watch_fd == -1)
+		return;
+	for (i = 0; i < MCR_REACTOR_MAX; i++) {
+		if (nPt->reactors[i].epoll_fd != -1) {
+			epoll_ctl(nPt->reactors[i].epoll_fd, EPOLL_CTL_DEL, nPt->watch_fd,
+					  NULL);
+		}
+	}
+	close(nPt->watch_fd);
+	nPt->watch_fd = -1;
+}
+
+/* \pre mutex locked
+ * \post mutex locked
+ */
+static void watch_read(struct mcr_context *ctx)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	const char *dirPath = MCR_STR(MCR_EVENT_PATH);
+	char buffer[sizeof(struct inotify_event) + NAME_MAX + 1]
+	__attribute__((aligned(__alignof__(struct inotify_event))));
+	char path[PATH_MAX];
+	const struct inotify_event *evPt;
+	ssize_t len;
+	char *itPt;
+	/* Stopped after this wait */
+	if (nPt->watch_fd == -1)
+		return;
+	while ((len = read(nPt->watch_fd, buffer, sizeof(buffer))) > 0) {
+		for (itPt = buffer; itPt < buffer + len;
+			 itPt += sizeof(struct inotify_event) + evPt->len) {
+			evPt = (const struct inotify_event *)itPt;
+			if (evPt->len && !strncmp(evPt->name, "event", 5)) {
+				snprintf(path, sizeof(path), "%s/%s", dirPath, evPt->name);
+				watch_grab(ctx, path);
 			}
 		}
-		/* Non-grab does not write to device */
-		if (blocking && writegen) {
-			if (write(mcr_genDev.fd, events, rdb) < 0) {
-				/// \todo Is non-error ok with thrd error or success?
-				mcr_errno(0);
-				/* EINTR is disabled during read. */
-				if (!mcr_err || mcr_err == EINTR)
-					return thrd_success;
-				return thrd_error;
+	}
+}
+
+/* \pre mutex locked
+ * \post mutex locked
+ */
+static void watch_grab(struct mcr_context *ctx, const char *grabPath)
+{
+	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
+	if (find_context(nPt, grabPath)
+		|| !filter_match(ctx, &nPt->watch_filter, grabPath))
+		return;
+	if (grab_impl(ctx, grabPath, true))
+		dmsg;
+}
+
+/* Also false for devices that cannot be read yet, or are Libmacro
+ * devices. */
+static bool filter_match(struct mcr_context *ctx,
+						 const struct mcr_GrabFilter *filterPt, const char *grabPath)
+{
+	struct mcr_Grabber grabber;
+	const char *name;
+	bool ret = false;
+	/* Not blocking, only to read capabilities */
+	mcr_Grabber_init(&grabber);
+	if (!mcr_Grabber_set_path(&grabber, grabPath)
+		&& !mcr_Grabber_set_enabled(&grabber, true)) {
+		name = grabber.capabilities.name;
+		ret = MCR_EVENTBIT_ISSET(grabber.capabilities.ev_bits, EV_SYN)
+			  && !mcr_output_is_device_name(ctx, name)
+			  && mcr_Grabber_match(&grabber, filterPt);
+	}
+	mcr_Grabber_deinit(&grabber);
+	return ret;
+}
+
+/* \return 0 to keep reading, otherwise \ref reterr to remove the grabber */
+static int read_grabber(_grab_context *gcPt)
+{
+	struct input_event events[MCR_GRAB_SET_LENGTH];
+	int rdb = read(gcPt->grabber.fd, events, sizeof(events));
+	if (rdb < 0 && (errno == EAGAIN || errno == EINTR))
+		return 0;
+	return grabber_events(gcPt, events, rdb);
+}
+
+/* \param rdb Bytes read, or negative with errno set
+ * \return 0 to keep reading, otherwise \ref reterr to remove the grabber
+ */
+static int grabber_events(_grab_context *gcPt, struct input_event *events,
+						  int rdb)
+{
+	int i, count;
+	/* If rdb < input_event size then we are returning an error. */
+	if (rdb < (int) sizeof(struct input_event)) {
+		mcr_errno(ENODEV);
+		return mcr_err;
+	}
+	count = rdb / (int)sizeof(struct input_event);
+	/* Capture is not required to keep reading. */
+	if (gcPt->capture_fd != -1
+		&& write(gcPt->capture_fd, events,
+				 count * sizeof(struct input_event)) < 0) {
+		dmsg;
+	}
+	for (i = 0; i < count; i++) {
+		if (frame_add(gcPt, events + i))
+			return mcr_err;
+	}
+	return 0;
+}
+
+/* Frames may be split between reads.  A frame is dispatched at
+ * SYN_REPORT, or early if it does not fit. */
+static int frame_add(_grab_context *gcPt, const struct input_event *evPt)
+{
+	struct _dispatch_state *dsPt = &gcPt->disp;
+	bool isReport = evPt->type == EV_SYN && evPt->code == SYN_REPORT;
+	int count;
+	if (dsPt->frame_dropped) {
+		if (!isReport)
+			return 0;
+		dsPt->frame_dropped = false;
+		return state_resync(gcPt);
+	}
+	/* The incomplete frame is not valid */
+	if (evPt->type == EV_SYN && evPt->code == SYN_DROPPED) {
+		dsPt->frame_count = 0;
+		dsPt->frame_dropped = true;
+		return 0;
+	}
+	dsPt->frame[dsPt->frame_count++] = *evPt;
+	if (isReport || dsPt->frame_count == MCR_GRAB_SET_LENGTH) {
+		count = dsPt->frame_count;
+		dsPt->frame_count = 0;
+		if (coalesce_frame(gcPt, dsPt->frame, count))
+			return 0;
+		/* Coalesced motion is before this frame */
+		if (dsPt->coalesce_count && coalesce_flush(gcPt))
+			return mcr_err;
+		return dispatch_frame(gcPt, dsPt->frame, count,
+							  &dsPt->frame[count - 1].time);
+	}
+	return 0;
+}
+
+static inline long long elapsed_usec(const struct timespec *startPt,
+									 const struct timespec *endPt)
+{
+	return (endPt->tv_sec - startPt->tv_sec) * 1000000LL +
+		   (endPt->tv_nsec - startPt->tv_nsec) / 1000;
+}
+
+static inline unsigned int coalesce_window(struct mcr_Grabber *grabPt)
+{
+	return grabPt->coalesce_usec ? grabPt->coalesce_usec : MCR_COALESCE_USEC;
+}
+
+/* Add a frame of only relative motion and scroll to coalesced sums.
+ * \return true if the frame was coalesced, and should not be dispatched
+ */
+static bool coalesce_frame(_grab_context *gcPt, struct input_event *events,
+						   int count)
+{
+	struct _dispatch_state *dsPt = &gcPt->disp;
+	struct timespec now;
+	int i;
+	if (!mcr_Grabber_is_coalescing(&gcPt->grabber))
+		return false;
+	/* Never across other events, or partial frames */
+	if (events[count - 1].type != EV_SYN)
+		return false;
+	for (i = 0; i < count; i++) {
+		if (events[i].type == EV_REL) {
+			if (events[i].code >= REL_CNT)
+				return false;
+		} else if (events[i].type != EV_SYN && events[i].type != EV_MSC) {
+			return false;
+		}
+	}
+	for (i = 0; i < count; i++) {
+		if (events[i].type == EV_REL)
+			dsPt->coalesce_sums[events[i].code] += events[i].value;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (!dsPt->coalesce_count++) {
+		dsPt->coalesce_start = now;
+		dsPt->coalesce_time = events[count - 1].time;
+		if (mcr_Array_push(&gcPt->reactor->pending, &gcPt)) {
+			/* Not able to flush later */
+			dmsg;
+			coalesce_flush(gcPt);
+			return true;
+		}
+	}
+	if ((gcPt->grabber.coalesce_frames &&
+		 dsPt->coalesce_count >= gcPt->grabber.coalesce_frames)
+		|| elapsed_usec(&dsPt->coalesce_start,
+						&now) >= coalesce_window(&gcPt->grabber)) {
+		if (coalesce_flush(gcPt))
+			dmsg;
+	}
+	return true;
+}
+
+/* Dispatch coalesced sums as one frame */
+static int coalesce_flush(_grab_context *gcPt)
+{
+	struct _dispatch_state *dsPt = &gcPt->disp;
+	struct input_event events[REL_CNT + 1];
+	int code, count = 0;
+	if (!dsPt->coalesce_count)
+		return 0;
+	memset(events, 0, sizeof(events));
+	for (code = 0; code < REL_CNT; code++) {
+		if (dsPt->coalesce_sums[code]) {
+			events[count].type = EV_REL;
+			events[count].code = code;
+			events[count++].value = dsPt->coalesce_sums[code];
+		}
+	}
+	memset(dsPt->coalesce_sums, 0, sizeof(dsPt->coalesce_sums));
+	dsPt->coalesce_count = 0;
+	mcr_Array_remove(&gcPt->reactor->pending, &gcPt);
+	if (!count)
+		return 0;
+	/* SYN_REPORT is 0 */
+	events[count++].type = EV_SYN;
+	/* Oldest time of all coalesced */
+	return dispatch_frame(gcPt, events, count, &dsPt->coalesce_time);
+}
+
+/* Flush coalesced motion that is due.
+ * \param timeoutPt Set to milliseconds until the next is due
+ */
+static int reactor_flush(struct mcr_Reactor *reactorPt, int *timeoutPt)
+{
+	_grab_context **ptArr;
+	struct timespec now;
+	long long remaining;
+	size_t i;
+	int err = 0;
+	*timeoutPt = MCR_POLL_TIMEOUT;
+	if (!reactorPt->pending.used)
+		return 0;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ptArr = MCR_ARR_FIRST(reactorPt->pending);
+	/* Flushing removes from pending */
+	for (i = reactorPt->pending.used; i--;) {
+		remaining = coalesce_window(&ptArr[i]->grabber) -
+					elapsed_usec(&ptArr[i]->disp.coalesce_start, &now);
+		if (remaining <= 0 || ptArr[i]->removed) {
+			if (coalesce_flush(ptArr[i]))
+				err = mcr_err;
+		} else if ((remaining + 999) / 1000 < *timeoutPt) {
+			*timeoutPt = (int)((remaining + 999) / 1000);
+		}
+	}
+	return err;
+}
+
+/* Current key and abs state of the device, without dispatching */
+static void state_read(_grab_context *gcPt)
+{
+	struct _dispatch_state *dsPt = &gcPt->disp;
+	struct input_absinfo info;
+	int pos;
+	if (ioctl(gcPt->grabber.fd, EVIOCGKEY(sizeof(dsPt->key_bits)),
+			  dsPt->key_bits) < 0) {
+		memset(dsPt->key_bits, 0, sizeof(dsPt->key_bits));
+	}
+	mods_update(gcPt->ctx, dsPt);
+	for (pos = MCR_DIMENSION_CNT; pos--;) {
+		if (ioctl(gcPt->grabber.fd, EVIOCGABS(ABS_X + pos), &info) >= 0)
+			dsPt->abs_values[pos] = info.value;
+	}
+}
+
+/* Dispatch the difference of device state and the last known state
+ * as frames of generated events. */
+static int state_resync(_grab_context *gcPt)
+{
+	struct _dispatch_state *dsPt = &gcPt->disp;
+	struct input_event events[MCR_GRAB_SET_LENGTH];
+	char keyBits[sizeof(dsPt->key_bits)];
+	struct input_absinfo info;
+	int count = 0, code, pos;
+	bool isSet;
+	memset(events, 0, sizeof(events));
+	if (ioctl(gcPt->grabber.fd, EVIOCGKEY(sizeof(keyBits)), keyBits) >= 0) {
+		for (code = 0; code < KEY_CNT; code++) {
+			isSet = keyBits[MCR_EVENTINDEX(code)] & MCR_EVENTBIT(code);
+			if (isSet == !!(dsPt->key_bits[MCR_EVENTINDEX(code)] &
+							MCR_EVENTBIT(code)))
+				continue;
+			/* Leave room for SYN_REPORT */
+			if (count == MCR_GRAB_SET_LENGTH - 1) {
+				events[count++].type = EV_SYN;
+				if (dispatch_frame(gcPt, events, count, NULL))
+					return mcr_err;
+				memset(events, 0, sizeof(events));
+				count = 0;
 			}
-		} else {
-			writegen = true;
+			events[count].type = EV_KEY;
+			events[count].code = code;
+			events[count++].value = isSet;
 		}
-		/* Non-grab does not write to device */
-		if (blocking && writeabs) {
-			if (write(mcr_absDev.fd, events, rdb) < 0) {
-				mcr_errno(0);
-				/* EINTR is disabled during read. */
-				if (!mcr_err || mcr_err == EINTR)
-					return thrd_success;
-				return thrd_error;
+	}
+	for (pos = 0; pos < MCR_DIMENSION_CNT; pos++) {
+		if (ioctl(gcPt->grabber.fd, EVIOCGABS(ABS_X + pos), &info) >= 0
+			&& info.value != dsPt->abs_values[pos]) {
+			if (count == MCR_GRAB_SET_LENGTH - 1) {
+				events[count++].type = EV_SYN;
+				if (dispatch_frame(gcPt, events, count, NULL))
+					return mcr_err;
+				memset(events, 0, sizeof(events));
+				count = 0;
 			}
+			events[count].type = EV_ABS;
+			events[count].code = ABS_X + pos;
+			events[count++].value = info.value;
 		}
 	}
-	return thrd_success;
-#undef DISP_WRITEMEM
-#undef DISP_WRITEMEM_ABS
+	if (!count)
+		return 0;
+	/* SYN_REPORT is 0 */
+	events[count++].type = EV_SYN;
+	return dispatch_frame(gcPt, events, count, NULL);
 }
 
-static unsigned int modify_eventbits(struct mcr_context *ctx,
-									 unsigned int *modBuffer, size_t modBufferSize, char *keybitValues)
+static void dispatch_state_init(struct mcr_context *ctx,
+								struct _dispatch_state *dsPt)
 {
-	int curKey;
-	unsigned int modValOut = 0;
-	size_t i;
-	if (!modBuffer || !modBufferSize)
+	mcr_Signal_init(&dsPt->keysig);
+	mcr_Signal_init(&dsPt->echosig);
+	mcr_Signal_init(&dsPt->abssig);
+	mcr_Signal_init(&dsPt->relsig);
+	mcr_Signal_init(&dsPt->scrsig);
+	mcr_Instance_set_all(&dsPt->keysig, mcr_iKey(ctx), &dsPt->key, NULL);
+	mcr_Instance_set_all(&dsPt->echosig, mcr_iHidEcho(ctx), &dsPt->echo, NULL);
+	mcr_Instance_set_all(&dsPt->abssig, mcr_iMoveCursor(ctx), &dsPt->abs,
+						 NULL);
+	mcr_Instance_set_all(&dsPt->relsig, mcr_iMoveCursor(ctx), &dsPt->rel,
+						 NULL);
+	mcr_Instance_set_all(&dsPt->scrsig, mcr_iScroll(ctx), &dsPt->scr, NULL);
+	dsPt->keysig.is_dispatch = true;
+	dsPt->echosig.is_dispatch = true;
+	dsPt->abssig.is_dispatch = true;
+	dsPt->relsig.is_dispatch = true;
+	dsPt->scrsig.is_dispatch = true;
+	dsPt->rel.is_justify = true;
+}
+
+static inline int abspos(int evPos)
+{
+	switch (evPos) {
+	case ABS_X:
+		return MCR_X;
+	case ABS_Y:
+		return MCR_Y;
+	case ABS_Z:
+		return MCR_Z;
+	}
+	return MCR_DIMENSION_CNT;
+}
+
+static inline int relpos(int evPos)
+{
+	switch (evPos) {
+	case REL_X:
+	case REL_HWHEEL:
+		return MCR_X;
+	case REL_Y:
+	case REL_WHEEL:
+		return MCR_Y;
+	case REL_Z:
+	case REL_DIAL:
+		return MCR_Z;
+	}
+	return MCR_DIMENSION_CNT;
+}
+
+static inline void abs_set_current(struct mcr_context *ctx,
+								   struct mcr_MoveCursor *abs, bool hasPosArray[])
+{
+	mcr_SpacePosition cursor;
+	mcr_cursor_position(ctx, cursor);
+	if (!(hasPosArray)[MCR_X])
+		abs->pos[MCR_X] = cursor[MCR_X];
+	if (!(hasPosArray)[MCR_Y])
+		abs->pos[MCR_Y] = cursor[MCR_Y];
+	if (!(hasPosArray)[MCR_Z])
+		abs->pos[MCR_Z] = cursor[MCR_Z];
+}
+
+/* Mark events of a blocked signal to not be written. */
+static inline void drop_events(bool *dropArr, const int *indexArr,
+							   size_t count)
+{
+	while (count--) {
+		if (indexArr[count] != -1)
+			dropArr[indexArr[count]] = true;
+	}
+}
+
+/* Write all events not dropped with one writev.
+ * \return \ref reterr
+ */
+static int write_events(struct mcr_Reactor *reactorPt, int fd,
+						struct input_event *events, int count, const bool *dropArr)
+{
+	struct iovec iov[MCR_GRAB_SET_LENGTH];
+	int i, iovCount = 0;
+	if (reactorPt && mcr_Ring_is_open(&reactorPt->ring)
+		&& ring_write(reactorPt, fd, events, count, dropArr)) {
+		return 0;
+	}
+	for (i = 0; i < count; i++) {
+		if (dropArr[i])
+			continue;
+		/* Continue the previous run, or start a new one */
+		if (iovCount && (char *)iov[iovCount - 1].iov_base +
+			iov[iovCount - 1].iov_len == (char *)(events + i)) {
+			iov[iovCount - 1].iov_len += sizeof(struct input_event);
+		} else {
+			iov[iovCount].iov_base = events + i;
+			iov[iovCount++].iov_len = sizeof(struct input_event);
+		}
+	}
+	if (iovCount && writev(fd, iov, iovCount) < 0) {
+		mcr_errno(0);
+		/* Interrupted write only loses this set. */
+		if (mcr_err && mcr_err != EINTR)
+			return mcr_err;
+	}
+	return 0;
+}
+
+/* Decoding one frame of events */
+struct _frame_decode {
+	struct mcr_context *ctx;
+	/* Passthrough is written with the reactor io_uring if it has one. */
+	struct mcr_Reactor *reactor;
+	/* Output of the grabber */
+	unsigned int output;
+	struct _dispatch_state *dsPt;
+	bool blocking;
+	/* Apply movement to the tracked cursor position */
+	bool track_cursor;
+	bool dropArr[MCR_GRAB_SET_LENGTH];
+	/* Index of events making the current signals, -1 if none */
+	int keyIndex;
+	int absIndex[MCR_DIMENSION_CNT];
+	int relIndex[MCR_DIMENSION_CNT];
+	int scrIndex[MCR_DIMENSION_CNT];
+};
+
+/* Dispatch, and if blocking remove events of the blocked signal. */
+#define DISP_FILTER(fdPt, signal, indexArr, count) \
+if (mcr_dispatch((fdPt)->ctx, &(signal)) && (fdPt)->blocking) { \
+	drop_events((fdPt)->dropArr, indexArr, count); \
+}
+
+static inline void frame_decode_init(struct _frame_decode *fdPt,
+									 _grab_context *gcPt)
+{
+	int i;
+	fdPt->ctx = gcPt->ctx;
+	fdPt->reactor = gcPt->reactor;
+	fdPt->output = gcPt->output;
+	fdPt->dsPt = &gcPt->disp;
+	fdPt->blocking = gcPt->grabber.blocking;
+	fdPt->track_cursor = ((struct mcr_intercept_platform *)
+						  gcPt->ctx->intercept.platform)->track_cursor;
+	memset(fdPt->dropArr, 0, sizeof(fdPt->dropArr));
+	fdPt->keyIndex = -1;
+	for (i = MCR_DIMENSION_CNT; i--;) {
+		fdPt->absIndex[i] = fdPt->relIndex[i] = fdPt->scrIndex[i] = -1;
+	}
+}
+
+/* Dispatch the pending key, with echo if mapped. */
+static inline void key_flush(struct _frame_decode *fdPt)
+{
+	struct _dispatch_state *dsPt = fdPt->dsPt;
+	struct mcr_Key *keyPt = &dsPt->key;
+	size_t echoCode = mcr_Key_echo(fdPt->ctx->standard.platform,
+								   keyPt->key, keyPt->apply);
+	if (echoCode != MCR_ECHO_ANY) {
+		dsPt->echo.echo = echoCode;
+		DISP_FILTER(fdPt, dsPt->echosig, &fdPt->keyIndex, 1);
+		/* No need to reset echo, which depends on EV_KEY */
+	}
+	DISP_FILTER(fdPt, dsPt->keysig, &fdPt->keyIndex, 1);
+}
+
+static inline void key_event(struct _frame_decode *fdPt,
+							 const struct input_event *evPt, int index)
+{
+	struct _dispatch_state *dsPt = fdPt->dsPt;
+	if (dsPt->key.key)
+		key_flush(fdPt);
+	dsPt->key.key = evPt->code;
+	dsPt->key.apply = evPt->value ? MCR_SET : MCR_UNSET;
+	fdPt->keyIndex = index;
+	if (evPt->code < KEY_CNT
+		&& MCR_EVENTBIT_ISSET(dsPt->key_bits, evPt->code) != !!evPt->value) {
+		if (evPt->value) {
+			dsPt->key_bits[MCR_EVENTINDEX(evPt->code)] |=
+				MCR_EVENTBIT(evPt->code);
+		} else {
+			dsPt->key_bits[MCR_EVENTINDEX(evPt->code)] &=
+				~MCR_EVENTBIT(evPt->code);
+		}
+		/* Only modifier keys change modifiers */
+		if (mcr_Key_modifier(fdPt->ctx, evPt->code) != MCR_MF_NONE)
+			mods_update(fdPt->ctx, dsPt);
+	}
+}
+
+/* Call final event, it was not called yet. */
+static inline void key_finish(struct _frame_decode *fdPt)
+{
+	struct mcr_Key *keyPt = &fdPt->dsPt->key;
+	if (keyPt->key) {
+		key_flush(fdPt);
+		keyPt->key = 0;
+		keyPt->apply = MCR_BOTH;
+	}
+}
+
+/* Apply movement to the tracked cursor if it was not blocked.
+ * Movement is copied before dispatch, in case receivers modify it. */
+static inline void cursor_track(struct _frame_decode *fdPt,
+								const struct mcr_MoveCursor *mcPt, const int indexArr[])
+{
+	int i;
+	for (i = MCR_DIMENSION_CNT; i--;) {
+		if (indexArr[i] != -1 && fdPt->dropArr[indexArr[i]])
+			return;
+	}
+	mcr_cursor_apply(fdPt->ctx, mcPt);
+}
+
+static inline void abs_flush(struct _frame_decode *fdPt)
+{
+	struct _dispatch_state *dsPt = fdPt->dsPt;
+	struct mcr_MoveCursor moved;
+	abs_set_current(fdPt->ctx, &dsPt->abs, dsPt->bAbs);
+	moved = dsPt->abs;
+	DISP_FILTER(fdPt, dsPt->abssig, fdPt->absIndex, MCR_DIMENSION_CNT);
+	if (fdPt->track_cursor)
+		cursor_track(fdPt, &moved, fdPt->absIndex);
+	MCR_DIMENSIONS_ZERO(dsPt->bAbs);
+	fdPt->absIndex[MCR_X] = fdPt->absIndex[MCR_Y] =
+								fdPt->absIndex[MCR_Z] = -1;
+}
+
+static inline void abs_event(struct _frame_decode *fdPt,
+							 const struct input_event *evPt, int index)
+{
+	struct _dispatch_state *dsPt = fdPt->dsPt;
+	int pos = abspos(evPt->code);
+	/* Unknown axes are not signals, only written */
+	if (pos == MCR_DIMENSION_CNT)
+		return;
+	if (dsPt->bAbs[pos])
+		abs_flush(fdPt);
+	dsPt->abs.pos[pos] = evPt->value;
+	dsPt->abs_values[pos] = evPt->value;
+	dsPt->bAbs[pos] = true;
+	fdPt->absIndex[pos] = index;
+}
+
+static inline void abs_finish(struct _frame_decode *fdPt)
+{
+	bool *bAbs = fdPt->dsPt->bAbs;
+	if (bAbs[MCR_X] || bAbs[MCR_Y] || bAbs[MCR_Z])
+		abs_flush(fdPt);
+}
+
+static inline void rel_flush(struct _frame_decode *fdPt)
+{
+	struct _dispatch_state *dsPt = fdPt->dsPt;
+	struct mcr_MoveCursor moved = dsPt->rel;
+	DISP_FILTER(fdPt, dsPt->relsig, fdPt->relIndex, MCR_DIMENSION_CNT);
+	if (fdPt->track_cursor)
+		cursor_track(fdPt, &moved, fdPt->relIndex);
+	MCR_DIMENSIONS_ZERO(dsPt->rel.pos);
+	fdPt->relIndex[MCR_X] = fdPt->relIndex[MCR_Y] =
+								fdPt->relIndex[MCR_Z] = -1;
+}
+
+static inline void scr_flush(struct _frame_decode *fdPt)
+{
+	struct _dispatch_state *dsPt = fdPt->dsPt;
+	DISP_FILTER(fdPt, dsPt->scrsig, fdPt->scrIndex, MCR_DIMENSION_CNT);
+	MCR_DIMENSIONS_ZERO(dsPt->scr.dm);
+	fdPt->scrIndex[MCR_X] = fdPt->scrIndex[MCR_Y] =
+								fdPt->scrIndex[MCR_Z] = -1;
+}
+
+static inline void rel_event(struct _frame_decode *fdPt,
+							 const struct input_event *evPt, int index)
+{
+	struct _dispatch_state *dsPt = fdPt->dsPt;
+	int pos = relpos(evPt->code);
+	if (pos == MCR_DIMENSION_CNT)
+		return;
+	switch (evPt->code) {
+	case REL_X:
+	case REL_Y:
+	case REL_Z:
+		if (dsPt->rel.pos[pos])
+			rel_flush(fdPt);
+		dsPt->rel.pos[pos] = evPt->value;
+		fdPt->relIndex[pos] = index;
+		break;
+	default:
+		/* Currently assuming scroll if not relative movement. */
+		if (dsPt->scr.dm[pos])
+			scr_flush(fdPt);
+		dsPt->scr.dm[pos] = evPt->value;
+		fdPt->scrIndex[pos] = index;
+		break;
+	}
+}
+
+static inline void rel_finish(struct _frame_decode *fdPt)
+{
+	struct _dispatch_state *dsPt = fdPt->dsPt;
+	int i;
+	for (i = MCR_DIMENSION_CNT; i--;) {
+		if (dsPt->rel.pos[i]) {
+			rel_flush(fdPt);
+			break;
+		}
+	}
+	for (i = MCR_DIMENSION_CNT; i--;) {
+		if (dsPt->scr.dm[i]) {
+			scr_flush(fdPt);
+			break;
+		}
+	}
+}
+#undef DISP_FILTER
+
+/* Events not dropped are sent as one buffer with the device lock, so a
+ * frame is not split by other writes to the device, and is not written
+ * while the device is recreated.  Devices are not written with io_uring,
+ * which could write to a closed device fd. */
+static int device_write_events(struct _frame_decode *fdPt,
+							   struct mcr_Device *devPt, struct input_event *events, int count)
+{
+	struct input_event kept[MCR_GRAB_SET_LENGTH];
+	int i, keptCount = 0;
+	for (i = 0; i < count; i++) {
+		if (!fdPt->dropArr[i])
+			kept[keptCount++] = events[i];
+	}
+	return keptCount ? mcr_Device_send(devPt, kept, keptCount) : 0;
+}
+
+/* If blocking, only events of blocked signals are removed, and all
+ * others are written to the generic devices. */
+static int frame_write(struct _frame_decode *fdPt,
+					   struct input_event *events, int count)
+{
+	bool writegen = false, writeabs = false;
+	int i;
+	int sinkFd;
+	struct mcr_OutputDevice *outPt;
+	/* Non-grab does not write to device */
+	if (!fdPt->blocking)
+		return 0;
+	sinkFd = ((struct mcr_intercept_platform *)
+			  fdPt->ctx->intercept.platform)->passthrough_fd;
+	/* Only synchronization left is not written. */
+	for (i = 0; i < count; i++) {
+		if (!fdPt->dropArr[i] && events[i].type != EV_SYN) {
+			writegen = true;
+			if (events[i].type == EV_ABS)
+				writeabs = true;
+		}
+	}
+	if (sinkFd != -1) {
+		return writegen ? write_events(fdPt->reactor, sinkFd, events,
+									   count, fdPt->dropArr) : 0;
+	}
+	if (!writegen)
 		return 0;
-	/* For each modifier, find the modifier of that key, and check
-	 * if key is set in the key bit value set. */
-	for (i = modBufferSize; i--;) {
-		curKey = mcr_Key_modifier_key(ctx, modBuffer[i]);
-		if (curKey != MCR_KEY_ANY
-			&& (keybitValues[MCR_EVENTINDEX(curKey)] &
-				MCR_EVENTBIT(curKey))) {
-			modValOut |= modBuffer[i];
+	if (!(outPt = mcr_output_device(fdPt->ctx, fdPt->output)))
+		outPt = mcr_output_device(fdPt->ctx, 0);
+	if (device_write_events(fdPt, outPt->gen, events, count))
+		return mcr_err;
+	if (writeabs && device_write_events(fdPt, outPt->abs, events, count))
+		return mcr_err;
+	return 0;
+}
+
+/* Decode loops by device class, see mcr_GrabberClass.  Event types a
+ * class does not have are only written. */
+static int dispatch_generic(_grab_context *gcPt, struct input_event *events,
+							int count)
+{
+	struct _frame_decode decode;
+	int i;
+	frame_decode_init(&decode, gcPt);
+	for (i = 0; i < count; i++) {
+		switch (events[i].type) {
+		case EV_KEY:
+			key_event(&decode, events + i, i);
+			break;
+		case EV_ABS:
+			abs_event(&decode, events + i, i);
+			break;
+		case EV_REL:
+			rel_event(&decode, events + i, i);
+			break;
 		}
 	}
-	return modValOut;
+	key_finish(&decode);
+	abs_finish(&decode);
+	rel_finish(&decode);
+	return frame_write(&decode, events, count);
+}
+
+static int dispatch_keyboard(_grab_context *gcPt, struct input_event *events,
+							 int count)
+{
+	struct _frame_decode decode;
+	int i;
+	frame_decode_init(&decode, gcPt);
+	for (i = 0; i < count; i++) {
+		if (events[i].type == EV_KEY)
+			key_event(&decode, events + i, i);
+	}
+	key_finish(&decode);
+	return frame_write(&decode, events, count);
+}
+
+static int dispatch_pointer(_grab_context *gcPt, struct input_event *events,
+							int count)
+{
+	struct _frame_decode decode;
+	int i;
+	frame_decode_init(&decode, gcPt);
+	for (i = 0; i < count; i++) {
+		if (events[i].type == EV_REL)
+			rel_event(&decode, events + i, i);
+		else if (events[i].type == EV_KEY)
+			key_event(&decode, events + i, i);
+	}
+	key_finish(&decode);
+	rel_finish(&decode);
+	return frame_write(&decode, events, count);
 }
 
-static unsigned int max_modifier_val()
+static int dispatch_tablet(_grab_context *gcPt, struct input_event *events,
+						   int count)
 {
-	unsigned int val = KEY_LEFTALT;
-	val = KEY_RIGHTALT > val ? KEY_RIGHTALT : val;
-	val = KEY_OPTION > val ? KEY_OPTION : val;
-	val = KEY_COMPOSE > val ? KEY_COMPOSE : val;
-	val = KEY_LEFTCTRL > val ? KEY_LEFTCTRL : val;
-	val = KEY_RIGHTCTRL > val ? KEY_RIGHTCTRL : val;
-	val = KEY_FN > val ? KEY_FN : val;
-	val = KEY_FRONT > val ? KEY_FRONT : val;
-	val = KEY_LEFTSHIFT > val ? KEY_LEFTSHIFT : val;
-	val = KEY_RIGHTSHIFT > val ? KEY_RIGHTSHIFT : val;
-	val = KEY_LEFTMETA > val ? KEY_LEFTMETA : val;
-	val = KEY_RIGHTMETA > val ? KEY_RIGHTMETA : val;
-	return val;
+	struct _frame_decode decode;
+	int i;
+	frame_decode_init(&decode, gcPt);
+	for (i = 0; i < count; i++) {
+		if (events[i].type == EV_ABS)
+			abs_event(&decode, events + i, i);
+		else if (events[i].type == EV_KEY)
+			key_event(&decode, events + i, i);
+	}
+	key_finish(&decode);
+	abs_finish(&decode);
+	return frame_write(&decode, events, count);
+}
+
+static inline size_t elapsed_since(const struct timespec *endPt,
+								   const struct timeval *startPt)
+{
+	long long usec = (endPt->tv_sec - startPt->tv_sec) * 1000000LL +
+					 endPt->tv_nsec / 1000 - startPt->tv_usec;
+	return usec > 0 ? (size_t)usec : 0;
+}
+
+/* Dispatch a frame with the time of its events.
+ * \param timePt \ref opt Event time, or null for generated events
+ */
+static int dispatch_frame(_grab_context *gcPt, struct input_event *events,
+						  int count, const struct timeval *timePt)
+{
+	struct mcr_intercept *icPt = &gcPt->ctx->intercept;
+	struct timespec start, end;
+	bool measure = timePt && icPt->latency_enabled;
+	int err;
+	if (timePt) {
+		_eventTime = *timePt;
+		_hasEventTime = true;
+	}
+	if (measure) {
+		clock_gettime(gcPt->grabber.clock_id, &start);
+		mcr_LatencyHistogram_add(&icPt->dispatch_latency,
+								 elapsed_since(&start, timePt));
+	}
+	err = gcPt->dispatch(gcPt, events, count);
+	if (measure) {
+		clock_gettime(gcPt->grabber.clock_id, &end);
+		mcr_LatencyHistogram_add(&icPt->write_latency,
+								 (size_t)elapsed_usec(&start, &end));
+	}
+	_hasEventTime = false;
+	return err;
+}
+
+static void set_dispatch(_grab_context *gcPt)
+{
+	switch (mcr_Grabber_class(&gcPt->grabber)) {
+	case MCR_GRABBER_KEYBOARD:
+		gcPt->dispatch = dispatch_keyboard;
+		break;
+	case MCR_GRABBER_POINTER:
+		gcPt->dispatch = dispatch_pointer;
+		break;
+	case MCR_GRABBER_TABLET:
+		gcPt->dispatch = dispatch_tablet;
+		break;
+	default:
+		gcPt->dispatch = dispatch_generic;
+		break;
+	}
 }
 
 /*! \pre Mutex not locked */
@@ -661,29 +2271,20 @@ static unsigned int max_modifier_val()
 static int clear_grabbers(struct mcr_context *ctx)
 {
 	struct mcr_intercept_platform *nPt = ctx->intercept.platform;
-	/* Disable all, wait for all batch operation. */
-	int timeout = 50;	// Total 10 sec
-	struct mcr_NoOp delay = { 0 };
+	_grab_context **ptArr;
+	size_t i;
 	int thrdErr;
-	delay.msec = 200;
-	/// \todo thread destroy on timeout.
-	while (nPt->grab_contexts.used && timeout--) {
-		/* Disable all */
-		thrdErr = mtx_lock(&nPt->lock);
-		MCR_ARR_FOR_EACH(nPt->grab_contexts, grab_context_disable);
-		if (thrdErr == thrd_success)
-			mtx_unlock(&nPt->lock);
-		/* While unlocked and paused, threads will remove themselves */
-		mcr_NoOp_send_data(&delay);
-	}
-	/* Impatient free-all, unconditional end for timed out waiting */
-	if (nPt->grab_contexts.used) {
-		thrdErr = mtx_lock(&nPt->lock);
-		MCR_ARR_FOR_EACH(nPt->grab_contexts, grab_context_disable);
-		MCR_ARR_FOR_EACH(nPt->grab_contexts, grab_context_free);
-		nPt->grab_contexts.used = 0;
-		if (thrdErr == thrd_success)
-			mtx_unlock(&nPt->lock);
+	/* No reads after reactors are stopped, and all removed contexts
+	 * are already freed. */
+	stop_reactors(ctx);
+	thrdErr = mtx_lock(&nPt->lock);
+	ptArr = MCR_ARR_FIRST(nPt->grab_contexts);
+	i = nPt->grab_contexts.used;
+	while (i--) {
+		grab_context_free(ptArr + i);
 	}
+	nPt->grab_contexts.used = 0;
+	if (thrdErr == thrd_success)
+		mtx_unlock(&nPt->lock);
 	return 0;
 }
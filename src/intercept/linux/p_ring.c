@@ -0,0 +1,198 @@
+/* Libmacro - A multi-platform, extendable macro and hotkey C library
+  Copyright (C) 2013 Jonathan Pelletier, New Paradigm Software
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "mcr/intercept/linux/p_ring.h"
+#include "mcr/intercept/intercept.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#define ring_load(uintPt) __atomic_load_n(uintPt, __ATOMIC_ACQUIRE)
+#define ring_store(uintPt, value) \
+__atomic_store_n(uintPt, value, __ATOMIC_RELEASE)
+
+static void *ring_mmap(int fd, size_t size, off_t offset);
+static int ring_map(struct mcr_Ring *ringPt,
+					const struct io_uring_params *paramsPt);
+
+int mcr_Ring_init(void *ringPt)
+{
+	struct mcr_Ring *localPt = ringPt;
+	if (localPt) {
+		memset(localPt, 0, sizeof(struct mcr_Ring));
+		localPt->fd = -1;
+	}
+	return 0;
+}
+
+int mcr_Ring_deinit(void *ringPt)
+{
+	if (ringPt)
+		mcr_Ring_close(ringPt);
+	return 0;
+}
+
+int mcr_Ring_open(struct mcr_Ring *ringPt, unsigned int entries)
+{
+	struct io_uring_params params;
+	dassert(ringPt);
+	if (mcr_Ring_is_open(ringPt))
+		return 0;
+#ifdef __NR_io_uring_setup
+	memset(&params, 0, sizeof(params));
+	if ((ringPt->fd = syscall(__NR_io_uring_setup, entries, &params)) < 0) {
+		ringPt->fd = -1;
+		mcr_errno(ENOSYS);
+		return mcr_err;
+	}
+	/* Waiting with a timeout requires extended arguments. */
+	if (!(params.features & IORING_FEAT_EXT_ARG)) {
+		mcr_Ring_close(ringPt);
+		mset_error_return(ENOSYS);
+	}
+	if (ring_map(ringPt, &params)) {
+		mcr_Ring_close(ringPt);
+		return mcr_err;
+	}
+	return 0;
+#else
+	UNUSED(entries);
+	UNUSED(params);
+	mset_error_return(ENOSYS);
+#endif
+}
+
+void mcr_Ring_close(struct mcr_Ring *ringPt)
+{
+	dassert(ringPt);
+	if (ringPt->sqes)
+		munmap(ringPt->sqes, ringPt->sqes_size);
+	if (ringPt->cq_map && ringPt->cq_map != ringPt->sq_map)
+		munmap(ringPt->cq_map, ringPt->cq_map_size);
+	if (ringPt->sq_map)
+		munmap(ringPt->sq_map, ringPt->sq_map_size);
+	if (ringPt->fd != -1)
+		close(ringPt->fd);
+	mcr_Ring_init(ringPt);
+}
+
+struct io_uring_sqe *mcr_Ring_sqe(struct mcr_Ring *ringPt)
+{
+	/* Only this thread writes the tail. */
+	unsigned int tail = *ringPt->sq_tail + ringPt->sq_pending;
+	struct io_uring_sqe *sqePt;
+	if (tail - ring_load(ringPt->sq_head) >= ringPt->sq_entries)
+		return NULL;
+	sqePt = ringPt->sqes + (tail & *ringPt->sq_mask);
+	memset(sqePt, 0, sizeof(struct io_uring_sqe));
+	ringPt->sq_array[tail & *ringPt->sq_mask] = tail & *ringPt->sq_mask;
+	++ringPt->sq_pending;
+	return sqePt;
+}
+
+int mcr_Ring_submit(struct mcr_Ring *ringPt, unsigned int waitCount,
+					int timeoutMsec)
+{
+	struct io_uring_getevents_arg arg;
+	struct __kernel_timespec timeout;
+	unsigned int flags = 0, submitCount = ringPt->sq_pending;
+	int ret;
+	ring_store(ringPt->sq_tail, *ringPt->sq_tail + submitCount);
+	ringPt->sq_pending = 0;
+	memset(&arg, 0, sizeof(arg));
+	if (waitCount) {
+		flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+		if (timeoutMsec >= 0) {
+			timeout.tv_sec = timeoutMsec / 1000;
+			timeout.tv_nsec = (timeoutMsec % 1000) * 1000000LL;
+			arg.ts = (uintptr_t)&timeout;
+		}
+	}
+	ret = syscall(__NR_io_uring_enter, ringPt->fd, submitCount, waitCount,
+				  flags, waitCount ? &arg : NULL, waitCount ? sizeof(arg) : 0);
+	if (ret < 0 && errno != ETIME && errno != EINTR) {
+		mcr_errno(EINTR);
+		return mcr_err;
+	}
+	return 0;
+}
+
+struct io_uring_cqe *mcr_Ring_cqe(struct mcr_Ring *ringPt)
+{
+	unsigned int head = *ringPt->cq_head;
+	if (head == ring_load(ringPt->cq_tail))
+		return NULL;
+	return ringPt->cqes + (head & *ringPt->cq_mask);
+}
+
+void mcr_Ring_seen(struct mcr_Ring *ringPt)
+{
+	ring_store(ringPt->cq_head, *ringPt->cq_head + 1);
+}
+
+static void *ring_mmap(int fd, size_t size, off_t offset)
+{
+	void *map = mmap(NULL, size, PROT_READ | PROT_WRITE,
+					 MAP_SHARED | MAP_POPULATE, fd, offset);
+	return map == MAP_FAILED ? NULL : map;
+}
+
+/* Mapped memory is unmapped by mcr_Ring_close. */
+static int ring_map(struct mcr_Ring *ringPt,
+					const struct io_uring_params *paramsPt)
+{
+	char *sqMap, *cqMap;
+	bool singleMap = paramsPt->features & IORING_FEAT_SINGLE_MMAP;
+	ringPt->sq_map_size = paramsPt->sq_off.array +
+						  paramsPt->sq_entries * sizeof(unsigned int);
+	ringPt->cq_map_size = paramsPt->cq_off.cqes +
+						  paramsPt->cq_entries * sizeof(struct io_uring_cqe);
+	if (singleMap) {
+		if (ringPt->cq_map_size > ringPt->sq_map_size)
+			ringPt->sq_map_size = ringPt->cq_map_size;
+		ringPt->cq_map_size = ringPt->sq_map_size;
+	}
+	ringPt->sqes_size = paramsPt->sq_entries * sizeof(struct io_uring_sqe);
+	if (!(ringPt->sq_map = ring_mmap(ringPt->fd, ringPt->sq_map_size,
+									 IORING_OFF_SQ_RING))) {
+		mcr_errno(ENOMEM);
+		return mcr_err;
+	}
+	ringPt->cq_map = singleMap ? ringPt->sq_map : ring_mmap(ringPt->fd,
+					 ringPt->cq_map_size, IORING_OFF_CQ_RING);
+	ringPt->sqes = ring_mmap(ringPt->fd, ringPt->sqes_size, IORING_OFF_SQES);
+	if (!ringPt->cq_map || !ringPt->sqes) {
+		mcr_errno(ENOMEM);
+		return mcr_err;
+	}
+	sqMap = ringPt->sq_map;
+	cqMap = ringPt->cq_map;
+	ringPt->sq_head = (unsigned int *)(sqMap + paramsPt->sq_off.head);
+	ringPt->sq_tail = (unsigned int *)(sqMap + paramsPt->sq_off.tail);
+	ringPt->sq_mask = (unsigned int *)(sqMap + paramsPt->sq_off.ring_mask);
+	ringPt->sq_array = (unsigned int *)(sqMap + paramsPt->sq_off.array);
+	ringPt->sq_entries = paramsPt->sq_entries;
+	ringPt->cq_head = (unsigned int *)(cqMap + paramsPt->cq_off.head);
+	ringPt->cq_tail = (unsigned int *)(cqMap + paramsPt->cq_off.tail);
+	ringPt->cq_mask = (unsigned int *)(cqMap + paramsPt->cq_off.ring_mask);
+	ringPt->cqes = (struct io_uring_cqe *)(cqMap + paramsPt->cq_off.cqes);
+	return 0;
+}
@@ -0,0 +1,159 @@
+/* Libmacro - A multi-platform, extendable macro and hotkey C library
+  Copyright (C) 2013 Jonathan Pelletier, New Paradigm Software
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "mcr/intercept/linux/p_trace.h"
+#include "mcr/intercept/intercept.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static int write_all(int fd, const void *buffer, size_t size);
+/* \return Bytes read, less than size only at the end of file */
+static ssize_t read_all(int fd, void *buffer, size_t size);
+static int replay_frame(int outFd, struct input_event *events, int count,
+						const struct timeval *prevPt, bool realTime);
+
+int mcr_Trace_write_header(int fd,
+						   const struct mcr_GrabberCapabilities *capsPt, int clockId)
+{
+	struct mcr_TraceHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MCR_TRACE_MAGIC, sizeof(header.magic));
+	header.version = MCR_TRACE_VERSION;
+	header.event_size = sizeof(struct input_event);
+	header.clock_id = clockId;
+	if (capsPt)
+		header.capabilities = *capsPt;
+	return write_all(fd, &header, sizeof(header));
+}
+
+int mcr_Trace_read_header(int fd, struct mcr_TraceHeader *headerPt)
+{
+	ssize_t rdb;
+	dassert(headerPt);
+	if ((rdb = read_all(fd, headerPt, sizeof(struct mcr_TraceHeader))) < 0)
+		return mcr_err;
+	if (rdb != sizeof(struct mcr_TraceHeader)
+		|| memcmp(headerPt->magic, MCR_TRACE_MAGIC, sizeof(headerPt->magic))
+		|| headerPt->version != MCR_TRACE_VERSION
+		|| headerPt->event_size != sizeof(struct input_event)) {
+		mset_error_return(EPROTO);
+	}
+	/* Never trust names to be terminated */
+	headerPt->capabilities.name[sizeof(headerPt->capabilities.name) - 1] =
+		'\0';
+	return 0;
+}
+
+int mcr_Trace_replay(int traceFd, int outFd, bool realTime)
+{
+	struct mcr_TraceHeader header;
+	struct input_event events[MCR_GRAB_SET_LENGTH];
+	/* Capture time of the previous frame, none yet */
+	struct timeval prev = { 0 };
+	struct timeval frameTime;
+	ssize_t rdb;
+	int count = 0;
+	if (mcr_Trace_read_header(traceFd, &header))
+		return mcr_err;
+	header.clock_id = CLOCK_MONOTONIC;
+	if (write_all(outFd, &header, sizeof(header)))
+		return mcr_err;
+	while ((rdb = read_all(traceFd, events + count,
+						   sizeof(struct input_event))) == sizeof(struct input_event)) {
+		/* Frames are written whole, the same as evdev reads */
+		if (++count == MCR_GRAB_SET_LENGTH
+			|| (events[count - 1].type == EV_SYN
+				&& events[count - 1].code == SYN_REPORT)) {
+			frameTime = events[count - 1].time;
+			if (replay_frame(outFd, events, count, &prev, realTime))
+				return mcr_err;
+			prev = frameTime;
+			count = 0;
+		}
+	}
+	if (rdb < 0)
+		return mcr_err;
+	/* Trailing events of an incomplete frame */
+	if (count && replay_frame(outFd, events, count, &prev, realTime))
+		return mcr_err;
+	return 0;
+}
+
+static int write_all(int fd, const void *buffer, size_t size)
+{
+	const char *bytes = buffer;
+	ssize_t wrb;
+	while (size) {
+		if ((wrb = write(fd, bytes, size)) < 0) {
+			if (errno == EINTR)
+				continue;
+			mcr_errno(EIO);
+			return mcr_err;
+		}
+		bytes += wrb;
+		size -= wrb;
+	}
+	return 0;
+}
+
+static ssize_t read_all(int fd, void *buffer, size_t size)
+{
+	char *bytes = buffer;
+	ssize_t rdb, total = 0;
+	while ((size_t)total < size) {
+		if ((rdb = read(fd, bytes + total, size - total)) < 0) {
+			if (errno == EINTR)
+				continue;
+			mcr_errno(EIO);
+			return -1;
+		}
+		if (!rdb)
+			break;
+		total += rdb;
+	}
+	return total;
+}
+
+/* Wait the captured time since the previous frame, then write the frame
+ * stamped with the current time. */
+static int replay_frame(int outFd, struct input_event *events, int count,
+						const struct timeval *prevPt, bool realTime)
+{
+	const struct timeval *timePt = &events[count - 1].time;
+	struct timespec delay, now;
+	long long usec;
+	int i;
+	if (realTime && (prevPt->tv_sec || prevPt->tv_usec)) {
+		usec = (timePt->tv_sec - prevPt->tv_sec) * 1000000LL
+			   + (timePt->tv_usec - prevPt->tv_usec);
+		if (usec > 0) {
+			delay.tv_sec = usec / 1000000;
+			delay.tv_nsec = (usec % 1000000) * 1000;
+			thrd_sleep(&delay, NULL);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	for (i = 0; i < count; i++) {
+		events[i].time.tv_sec = now.tv_sec;
+		events[i].time.tv_usec = now.tv_nsec / 1000;
+	}
+	return write_all(outFd, events, count * sizeof(struct input_event));
+}
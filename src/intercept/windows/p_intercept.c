@@ -95,6 +95,13 @@ int mcr_intercept_set_enabled(struct mcr_context *ctx, bool enable)
 	return 0;
 }
 
+bool mcr_intercept_event_time(struct timespec *timePt)
+{
+	/* Hook times are not propagated */
+	UNUSED(timePt);
+	return false;
+}
+
 unsigned int mcr_intercept_modifiers(struct mcr_context *ctx)
 {
 	unsigned int values = 0;
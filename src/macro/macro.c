@@ -32,14 +32,9 @@
 		mcrPt->thread_max = 1; \
 	} \
 }
-#define dequeue(mcrPt, interruptorVal) { \
-	mcrPt->interruptor = interruptorVal; \
-	mcrPt->queued = 0; \
-}
-#define isrunning(mcrPt) (mcrPt->thread_count)
 #define isenabled(mcrPt) mcr_Macro_is_enabled(mcrPt)
-#define nonzero(val) if(val < 1) { val = 1; }
-#define nonneg(val) if(val < 0) { val = 0; }
+/* Able to continue sending signals, or paused and will continue. */
+#define iscontinue(interruptorVal) (interruptorVal < MCR_INTERRUPT)
 #define reenable(mcrPt) mcrPt->interruptor = MCR_CONTINUE
 #define ss signal_set
 #define thrd_conv_err(thrdErr) { \
@@ -54,6 +49,19 @@ if (mcr_Macro_disable_confirmed(mcrPt)) \
 
 #define disreenable(mcrPt) if (enableMem) { reenable(mcrPt); }
 
+#ifdef _MSC_VER
+	#define thread_local_macro __declspec(thread)
+#elif defined(__GNUC__)
+	#define thread_local_macro __thread
+#else
+	#define thread_local_macro _Thread_local
+#endif
+
+/* Thread slot of the macro executing in the current thread. */
+static thread_local_macro struct mcr_MacroThread *_currentThread = NULL;
+/* Notified of interruptor changes, see mcr_Macro_set_interrupt_listener */
+static void (*_interruptListener)(struct mcr_Macro *) = NULL;
+
 static const struct mcr_Interface _MCR_MACRO_IFACE = {
 	.id = (size_t)-1,
 	.copy = mcr_Macro_copy,
@@ -63,28 +71,52 @@ static const struct mcr_Interface _MCR_MACRO_IFACE = {
 };
 
 static int thread_macro(void *);
-static int thread_wait_reset(void *);
-/* Will attempt to gently detach all threads, but force termination
- * if timed out. */
+/* Set interruptor and wait for all other threads to exit.  No timeout is
+ * required, all threads are woken from waiting and cancel before sending
+ * the next signal. */
 static int clear_threads(struct mcr_Macro *mcrPt, enum mcr_Interrupt clearType,
 						 bool stickyInterrupt);
-
-/* Specifically \ref MCR_INTERRUPT_ALL, wait for all threads to finish, and
- * reset to \ref MCR_CONTINUE. */
-static int resetthread(struct mcr_Macro *mcrPt)
-{
-	dequeue(mcrPt, MCR_INTERRUPT_ALL);
-	thrd_yield();
-	/* Oh? It seems we are already reset. Boop. */
-	if (!isrunning(mcrPt)) {
-		reenable(mcrPt);
-		return 0;
+/* \pre Macro locked
+ * Join all threads that have finished. */
+static void join_finished(struct mcr_Macro *mcrPt);
+/* \pre Macro locked
+ * Start one thread in an available slot. */
+static int start_thread(struct mcr_Macro *mcrPt);
+
+/* \pre Macro locked
+ * Start a thread if one is available, otherwise queue or coalesce
+ * according to queue_policy. */
+static void queue_trigger(struct mcr_Macro *mcrPt)
+{
+	/* Pending items not yet taken by a thread */
+	unsigned int pending;
+	/* Any value greater than MCR_THREAD_MAX will be ignored. */
+	if (mcrPt->thread_count < MCR_THREAD_MAX
+		&& (unsigned)mcrPt->thread_count < mcrPt->thread_max) {
+		++mcrPt->queued;
+		if (start_thread(mcrPt)) {
+			--mcrPt->queued;
+			dmsg;
+		}
+		return;
 	}
-	if (mcr_thrd(thread_wait_reset, mcrPt)) {
-		dmsg;
-		return mcr_err;
+	/* Newly started threads may not have taken their item yet. */
+	pending = mcrPt->queued;
+	switch (mcrPt->queue_policy) {
+	case MCR_QUEUE_MERGE:
+		if (!pending) {
+			++mcrPt->queued;
+			return;
+		}
+		break;
+	case MCR_QUEUE_LIMIT:
+		if (pending < mcrPt->queue_max) {
+			++mcrPt->queued;
+			return;
+		}
+		break;
 	}
-	return 0;
+	++mcrPt->stats.coalesced;
 }
 
 const struct mcr_Interface *mcr_Macro_interface()
@@ -105,6 +137,11 @@ int mcr_Macro_init(void *mcrPt)
 		thrd_conv_err(thrdErr);
 		return thrdErr;
 	}
+	if ((thrdErr = mtx_init(&localPt->lock, mtx_plain)) != thrd_success) {
+		cnd_destroy(&localPt->thread_count_cnd);
+		thrd_conv_err(thrdErr);
+		return thrdErr;
+	}
 	mcr_Array_init(&localPt->ss);
 	localPt->ss.element_size = sizeof(struct mcr_Signal);
 	return 0;
@@ -121,6 +158,7 @@ int mcr_Macro_deinit(void *mcrPt)
 	MCR_ARR_FOR_EACH(localPt->ss, mcr_Signal_deinit);
 	mcr_Array_deinit(&localPt->ss);
 	cnd_destroy(&localPt->thread_count_cnd);
+	mtx_destroy(&localPt->lock);
 	return 0;
 }
 
@@ -151,29 +189,121 @@ int mcr_Macro_copy(void *dstPt, const void *srcPt)
 	dPt->sticky = sPt->sticky;
 	dPt->thread_max = sPt->thread_max;
 	bind_max_thread(dPt);
+	dPt->queue_policy = sPt->queue_policy;
+	dPt->queue_max = sPt->queue_max;
+	dPt->thread_options = sPt->thread_options;
+	dPt->output = sPt->output;
 	if (mcr_Macro_set_signals(dPt, (void *)sPt->ss.array, sPt->ss.used))
 		return mcr_err;
 	return mcr_Macro_set_enabled(dPt, isenabled(sPt));
 }
 
+int mcr_Macro_set_queue_policy(struct mcr_Macro *mcrPt,
+							   enum mcr_MacroQueuePolicy policy, unsigned int queueMax)
+{
+	int thrdErr;
+	dassert(mcrPt);
+	if (policy < MCR_QUEUE_DROP || policy > MCR_QUEUE_LIMIT)
+		mset_error_return(EINVAL);
+	if ((thrdErr = mtx_lock(&mcrPt->lock)) != thrd_success) {
+		thrd_conv_err(thrdErr);
+		return thrdErr;
+	}
+	mcrPt->queue_policy = policy;
+	mcrPt->queue_max = queueMax;
+	mtx_unlock(&mcrPt->lock);
+	return 0;
+}
+
+int mcr_Macro_stats(struct mcr_Macro *mcrPt, struct mcr_MacroStats *statsOut)
+{
+	int thrdErr;
+	dassert(mcrPt);
+	dassert(statsOut);
+	if ((thrdErr = mtx_lock(&mcrPt->lock)) != thrd_success) {
+		thrd_conv_err(thrdErr);
+		return thrdErr;
+	}
+	*statsOut = mcrPt->stats;
+	mtx_unlock(&mcrPt->lock);
+	return 0;
+}
+
+int mcr_Macro_reset_stats(struct mcr_Macro *mcrPt)
+{
+	int thrdErr;
+	dassert(mcrPt);
+	if ((thrdErr = mtx_lock(&mcrPt->lock)) != thrd_success) {
+		thrd_conv_err(thrdErr);
+		return thrdErr;
+	}
+	memset(&mcrPt->stats, 0, sizeof(mcrPt->stats));
+	mtx_unlock(&mcrPt->lock);
+	return 0;
+}
+
+int mcr_Macro_set_thread_options(struct mcr_Macro *mcrPt,
+								 const struct mcr_ThreadOptions *optionsPt)
+{
+	int thrdErr;
+	dassert(mcrPt);
+	if ((thrdErr = mtx_lock(&mcrPt->lock)) != thrd_success) {
+		thrd_conv_err(thrdErr);
+		return thrdErr;
+	}
+	if (optionsPt) {
+		mcrPt->thread_options = *optionsPt;
+	} else {
+		memset(&mcrPt->thread_options, 0, sizeof(mcrPt->thread_options));
+	}
+	mcrPt->thread_options_error = 0;
+	mtx_unlock(&mcrPt->lock);
+	return 0;
+}
+
+int mcr_Macro_thread_options_error(struct mcr_Macro *mcrPt)
+{
+	int err;
+	dassert(mcrPt);
+	if (mtx_lock(&mcrPt->lock) != thrd_success)
+		return mcrPt->thread_options_error;
+	err = mcrPt->thread_options_error;
+	mtx_unlock(&mcrPt->lock);
+	return err;
+}
+
 int mcr_Macro_interrupt(struct mcr_Macro *mcrPt,
 						enum mcr_Interrupt interruptType)
 {
-	enum mcr_Interrupt prev = mcrPt->interruptor;
+	enum mcr_Interrupt prev;
+	int thrdErr;
 	dassert(mcrPt);
 	/// \todo Out of range enum type
 	if (interruptType < 0 || interruptType > MCR_DISABLE) {
 		fprintf(stderr, "Invalid " MCR_STR(enum mcr_Interrupt) "\n");
 		mset_error_return(EINVAL);
 	}
+	if ((thrdErr = mtx_lock(&mcrPt->lock)) != thrd_success) {
+		thrd_conv_err(thrdErr);
+		return thrdErr;
+	}
+	prev = mcrPt->interruptor;
 	/* Enable or disable, just make it happen
-	 * If interrupting, macro will be reenabled from the reset thread */
-	if (prev != interruptType)
+	 * If interrupting all, macro will be reenabled by the last thread */
+	if (prev != interruptType) {
 		mcrPt->interruptor = interruptType;
-
-	/* Wait for all to finish, then reenable. */
-	if (interruptType == MCR_INTERRUPT_ALL && prev != MCR_INTERRUPT_ALL)
-		return resetthread(mcrPt);
+		if (interruptType == MCR_INTERRUPT_ALL) {
+			mcrPt->queued = 0;
+			/* Nobody is running to reset MCR_INTERRUPT_ALL. */
+			if (!mcrPt->thread_count)
+				reenable(mcrPt);
+		}
+		/* Wake all waiting threads, and notify of interruptor changes. */
+		cnd_broadcast(&mcrPt->thread_count_cnd);
+		if (_interruptListener)
+			_interruptListener(mcrPt);
+	}
+	mtx_unlock(&mcrPt->lock);
 
 	/* Pausing while already paused? Somebody has concurrency issues. */
 #ifdef MCR_DEBUG
@@ -316,21 +446,90 @@ int mcr_Macro_set_enabled(struct mcr_Macro *mcrPt, bool enable)
 
 int mcr_Macro_disable_confirmed(struct mcr_Macro *mcrPt)
 {
-//	if (!isenabled(mcrPt) && !isrunning(mcrPt))
-//		return 0;
 	return clear_threads(mcrPt, MCR_DISABLE, true);
 }
 
+struct mcr_Macro *mcr_Macro_current()
+{
+	return _currentThread ? _currentThread->macro : NULL;
+}
+
+void mcr_Macro_set_current(struct mcr_MacroThread *threadPt)
+{
+	_currentThread = threadPt;
+}
+
+void mcr_Macro_set_interrupt_listener(void (*listener)(struct mcr_Macro *))
+{
+	_interruptListener = listener;
+}
+
+int mcr_Macro_sleep(const struct timespec *duration)
+{
+	struct mcr_MacroThread *threadPt = _currentThread;
+	struct mcr_Macro *mcrPt;
+	struct timespec deadline;
+	int thrdErr = thrd_success;
+	dassert(duration);
+	if (!threadPt) {
+		thrd_sleep(duration, NULL);
+		return 0;
+	}
+	mcrPt = threadPt->macro;
+	/* cnd_timedwait is an absolute time, TIME_UTC */
+	timespec_get(&deadline, TIME_UTC);
+	deadline.tv_sec += duration->tv_sec + duration->tv_nsec / 1000000000;
+	deadline.tv_nsec += duration->tv_nsec % 1000000000;
+	if (deadline.tv_nsec >= 1000000000) {
+		++deadline.tv_sec;
+		deadline.tv_nsec -= 1000000000;
+	}
+	if ((thrdErr = mtx_lock(&mcrPt->lock)) != thrd_success) {
+		thrd_conv_err(thrdErr);
+		return thrdErr;
+	}
+	while (iscontinue(mcrPt->interruptor) && thrdErr == thrd_success)
+		thrdErr = cnd_timedwait(&mcrPt->thread_count_cnd, &mcrPt->lock, &deadline);
+	/* Only one thread will consume the interrupt. */
+	if (mcrPt->interruptor == MCR_INTERRUPT) {
+		reenable(mcrPt);
+		threadPt->interrupted = true;
+		cnd_broadcast(&mcrPt->thread_count_cnd);
+	}
+	mtx_unlock(&mcrPt->lock);
+	if (thrdErr != thrd_success && thrdErr != thrd_timedout) {
+		thrd_conv_err(thrdErr);
+		return thrdErr;
+	}
+	return 0;
+}
+
+bool mcr_Macro_is_interrupted(void)
+{
+	struct mcr_MacroThread *threadPt = _currentThread;
+	return threadPt && (threadPt->interrupted
+						|| !iscontinue(threadPt->macro->interruptor));
+}
+
 int mcr_Macro_send(struct mcr_Macro *mcrPt)
 {
 	struct mcr_Signal *sigPt = (void *)mcrPt->ss.array, *end;
 	struct mcr_context *ctx = mcrPt->ctx;
+	unsigned int route = 0;
 	end = sigPt + mcrPt->ss.used;
+	if (mcrPt->output)
+		route = mcr_output_set_thread_route(mcrPt->output);
+	/* Signals between delays are written together. */
+	mcr_output_begin(false);
 	while (mcrPt->interruptor == MCR_CONTINUE && sigPt < end) {
 		if (sigPt->isignal && mcr_send(ctx, sigPt))
 			break;
 		++sigPt;
 	}
+	if (mcr_output_end())
+		dmsg;
+	if (mcrPt->output)
+		mcr_output_set_thread_route(route);
 	return mcr_err;
 }
 
@@ -374,9 +573,6 @@ bool mcr_Macro_receive(void *mcrPt, struct mcr_Signal * sigPt,
 {
 	struct mcr_Macro *localPt = mcrPt;
 	dassert(localPt);
-	/* Fairly safe optimization to avoid dereferencing.  Concurrency may cause
-	 * an extra thread, so check thread_count again in thread function. */
-	int count = localPt->thread_count;
 	UNUSED(sigPt);
 	UNUSED(mods);
 
@@ -384,24 +580,29 @@ bool mcr_Macro_receive(void *mcrPt, struct mcr_Signal * sigPt,
 	switch (localPt->interruptor) {
 	case MCR_CONTINUE:
 	case MCR_PAUSE:
-		/* There was a concurrency blip, but we can correct it. */
-		if (count < 0) {
-			localPt->thread_count = count = 0;
-			cnd_broadcast(&localPt->thread_count_cnd);
-		}
-		/* Double-check thread_max valid after normal thread_count check.
-		 * Any value greater than MCR_THREAD_MAX will be ignored. */
-		if (count < MCR_THREAD_MAX && (unsigned)count < localPt->thread_max) {
-			/// \todo Possible unused threads if only one queued item.
-			if (++localPt->queued == 0) {
-				dmsg;
-			} else if (mcr_thrd(thread_macro, localPt)) {
-				dexit;
-			}
+		if (mtx_lock(&localPt->lock) != thrd_success) {
+			dmsg;
+			break;
 		}
+		/* Release threads that have already completed. */
+		join_finished(localPt);
+		++localPt->stats.triggers;
+		queue_trigger(localPt);
+		mtx_unlock(&localPt->lock);
 		break;
 	case MCR_INTERRUPT:
-		localPt->interruptor = MCR_CONTINUE;
+		if (mtx_lock(&localPt->lock) != thrd_success) {
+			dmsg;
+			break;
+		}
+		/* A running thread will consume the interrupt.  Otherwise this
+		 * trigger is interrupted instead. */
+		if (localPt->interruptor == MCR_INTERRUPT && !localPt->thread_count) {
+			localPt->interruptor = MCR_CONTINUE;
+			cnd_broadcast(&localPt->thread_count_cnd);
+		}
+		mtx_unlock(&localPt->lock);
+		break;
 	case MCR_INTERRUPT_ALL:
 	case MCR_DISABLE:
 		break;
@@ -416,105 +617,190 @@ bool mcr_Macro_trigger(void *trigPt, struct mcr_Signal * sigPt,
 	return mcr_Macro_receive(((struct mcr_Trigger *)trigPt)->actor, sigPt, mods);
 }
 
+/* Cancellation point while paused.  Any change of interruptor wakes the
+ * wait, so resuming does not wait for the maximum pause. */
 static void pause_macro(struct mcr_Macro *mcrPt)
 {
-	unsigned int pauseIter = MCR_MAX_PAUSE_COUNT;
-	struct timespec pauseDelay = { .tv_sec = 1 };
-	while (mcrPt->interruptor == MCR_PAUSE && pauseIter--) {
-		thrd_sleep(&pauseDelay, NULL);
+	struct timespec deadline;
+	int thrdErr = thrd_success;
+	if (mcrPt->interruptor != MCR_PAUSE)
+		return;
+	/* Do not hold buffered events while paused. */
+	if (mcr_output_flush())
+		dmsg;
+	timespec_get(&deadline, TIME_UTC);
+	deadline.tv_sec += MCR_MAX_PAUSE_COUNT;
+	if (mtx_lock(&mcrPt->lock) != thrd_success) {
+		dmsg;
+		return;
 	}
+	while (mcrPt->interruptor == MCR_PAUSE && thrdErr == thrd_success)
+		thrdErr = cnd_timedwait(&mcrPt->thread_count_cnd, &mcrPt->lock, &deadline);
 	/* Max pause reached */
-	if (!pauseIter && mcrPt->interruptor == MCR_PAUSE)
-		mcrPt->interruptor = MCR_CONTINUE;
+	if (mcrPt->interruptor == MCR_PAUSE) {
+		reenable(mcrPt);
+		cnd_broadcast(&mcrPt->thread_count_cnd);
+	}
+	mtx_unlock(&mcrPt->lock);
 }
 
-static int thread_macro(void *data)
+/* \pre Macro locked
+ * \post Macro locked
+ * Consume one interrupt, if this thread has not already consumed one while
+ * sleeping. */
+static bool consume_interrupt(struct mcr_MacroThread *threadPt)
 {
-#define canPause(mcrPt) if (mcrPt->interruptor == MCR_PAUSE) pause_macro(mcrPt);
-#define isContinue(interruptor) (interruptor < MCR_INTERRUPT_ALL)
-#define onErr ddo(mcrPt->interruptor = MCR_DISABLE;)
-#define onExit(mcrPt) { \
-	--mcrPt->thread_count; \
-	nonneg(mcrPt->thread_count); \
-	cnd_broadcast(&mcrPt->thread_count_cnd); \
+	struct mcr_Macro *mcrPt = threadPt->macro;
+	if (threadPt->interrupted) {
+		threadPt->interrupted = false;
+		return true;
+	}
+	if (mcrPt->interruptor == MCR_INTERRUPT) {
+		reenable(mcrPt);
+		cnd_broadcast(&mcrPt->thread_count_cnd);
+		return true;
+	}
+	return false;
 }
 
-	struct mcr_Macro *mcrPt = data;
+static int thread_macro(void *data)
+{
+	struct mcr_MacroThread *threadPt = data;
+	struct mcr_Macro *mcrPt;
 	struct mcr_Signal *sigArr, *sigPt, *end;
-	struct mcr_context *ctx = mcrPt->ctx;
+	struct mcr_context *ctx;
+	unsigned int output, route = 0;
+	struct mcr_ThreadOptions options;
+	int optionsErr;
+	bool interrupted;
 	dassert(data);
-	/* Abort! */
-	if (!isContinue(mcrPt->interruptor))
-		return thrd_success;
-
-	++mcrPt->thread_count;
-	/* Immediate disable check to avoid destroyed macro reference. */
-	if (!isContinue(mcrPt->interruptor)) {
-		onExit(mcrPt);
-		return thrd_success;
+	mcrPt = threadPt->macro;
+	ctx = mcrPt->ctx;
+	_currentThread = threadPt;
+	if (mtx_lock(&mcrPt->lock) != thrd_success) {
+		/* Cannot account for ourselves, but still finish. */
+		dmsg;
+		_currentThread = NULL;
+		return thrd_error;
+	}
+	/* Scheduling and memory locking may be slow, and are applied without
+	 * blocking triggers and interrupts. */
+	if (mcr_ThreadOptions_isset(&mcrPt->thread_options)) {
+		options = mcrPt->thread_options;
+		mtx_unlock(&mcrPt->lock);
+		/* Failure is not fatal, continue with default scheduling. */
+		optionsErr = mcr_thrd_set_options(&options) ? mcr_read_err() : 0;
+		if (mtx_lock(&mcrPt->lock) != thrd_success) {
+			dmsg;
+			_currentThread = NULL;
+			return thrd_error;
+		}
+		mcrPt->thread_options_error = optionsErr;
 	}
-	cnd_broadcast(&mcrPt->thread_count_cnd);
-	/* thread_count is in the clear. */
-	/* Signal set changes disable the macro, so the set should be valid for
-	 * the entire loop. */
-	sigArr = (void *)mcrPt->ss.array;
-	end = sigArr + mcrPt->ss.used;
-	/* No signal set is grounds for immediate dismissal. */
-	if (sigArr == end) {
-		mcrPt->queued = 0;
-		onExit(mcrPt);
-		return thrd_success;
-	}
-	canPause(mcrPt);
 	/* Loop only while triggers queued, or last thread is sticky. */
-	while ((isContinue(mcrPt->interruptor) && mcrPt->queued) ||
-		   (mcrPt->sticky && mcrPt->thread_count == 1)) {
+	while (iscontinue(mcrPt->interruptor)) {
 		/* Reduce from queue or we are definitely sticky. */
-		if (mcrPt->queued && --mcrPt->queued == 0) {
-			/* Queued overdraw.  All that read below zero enter critical
-			 * section to reset queue (and exit before running signal set). */
-			if (mtx_lock(&ctx->macro.critical_section) == thrd_success) {
-				mcrPt->queued = 0; // ensure
-				mtx_unlock(&ctx->macro.critical_section);
-			}
+		if (mcrPt->queued) {
+			--mcrPt->queued;
+		} else if (!mcrPt->sticky || mcrPt->thread_count != 1) {
+			break;
+		}
+		/* Signal set changes disable the macro and wait for us, so the set
+		 * is valid for the entire loop. */
+		sigArr = (void *)mcrPt->ss.array;
+		end = sigArr + mcrPt->ss.used;
+		/* No signal set is grounds for immediate dismissal. */
+		if (sigArr == end) {
+			mcrPt->queued = 0;
 			break;
 		}
-		for (sigPt = sigArr; isContinue(mcrPt->interruptor) && sigPt < end;
-			 sigPt++) {
-			if (mcrPt->interruptor == MCR_INTERRUPT) {
-				/* Critical section to ensure only one thread is interrupted. */
-				if (mtx_lock(&ctx->macro.critical_section) == thrd_success) {
-					if (mcrPt->interruptor == MCR_INTERRUPT) {
-						mcrPt->interruptor = MCR_CONTINUE;
-						mtx_unlock(&ctx->macro.critical_section);
-						break;
-					}
-					mtx_unlock(&ctx->macro.critical_section);
-				}
+		++mcrPt->stats.executions;
+		output = mcrPt->output;
+		mtx_unlock(&mcrPt->lock);
+		interrupted = false;
+		if (output)
+			route = mcr_output_set_thread_route(output);
+		/* Signals between delays are written together. */
+		mcr_output_begin(false);
+		/* Cancellation point between each signal */
+		for (sigPt = sigArr; sigPt < end; sigPt++) {
+			if (mcrPt->interruptor == MCR_PAUSE)
+				pause_macro(mcrPt);
+			if (!iscontinue(mcrPt->interruptor)
+				|| mcrPt->interruptor == MCR_INTERRUPT
+				|| threadPt->interrupted) {
+				interrupted = true;
+				break;
 			}
-			if (sigPt->isignal && mcr_send(ctx, sigPt))
-				onErr;
-			/* Hmm.  Maybe not pause during this loop. */
+			/* Only debugging stops at an error, and waiting threads are
+			 * woken with the interrupt. */
+			if (sigPt->isignal && mcr_send(ctx, sigPt)) {
+				dmsg;
+				ddo(mcr_Macro_interrupt(mcrPt, MCR_DISABLE);)
+			}
+		}
+		if (mcr_output_end())
+			dmsg;
+		if (output)
+			mcr_output_set_thread_route(route);
+		if (mtx_lock(&mcrPt->lock) != thrd_success) {
+			dmsg;
+			_currentThread = NULL;
+			return thrd_error;
 		}
-		canPause(mcrPt);
+		/* Only one thread is interrupted, and that thread will continue
+		 * with the next queued item. */
+		if (interrupted)
+			consume_interrupt(threadPt);
 	}
-	onExit(mcrPt);
-	return mcr_err ? thrd_error : 0;
-#undef canPause
-#undef isContinue
-#undef onErr
-#undef onExit
+	if (threadPt->interrupted)
+		consume_interrupt(threadPt);
+	--mcrPt->thread_count;
+	threadPt->state = MCR_THREAD_FINISHED;
+	/* Last thread to finish will reset interrupting all. */
+	if (mcrPt->interruptor == MCR_INTERRUPT_ALL && !mcrPt->thread_count)
+		reenable(mcrPt);
+	cnd_broadcast(&mcrPt->thread_count_cnd);
+	mtx_unlock(&mcrPt->lock);
+	_currentThread = NULL;
+	return mcr_err ? thrd_error : thrd_success;
 }
 
-static int thread_wait_reset(void *data)
+static void join_finished(struct mcr_Macro *mcrPt)
 {
-	dassert(data);
-	struct mcr_Macro *mcrPt = data;
-	/* Interrupt, but break if interrupt changes. */
-	clear_threads(mcrPt, MCR_INTERRUPT_ALL, false);
-	if (mcrPt->interruptor == MCR_INTERRUPT_ALL)
-		mcrPt->interruptor = MCR_CONTINUE;
-	return thrd_success;
+	struct mcr_MacroThread *threadPt = mcrPt->threads;
+	int i;
+	for (i = 0; i < MCR_THREAD_MAX; i++, threadPt++) {
+		if (threadPt->state == MCR_THREAD_FINISHED) {
+			/* Thread will exit immediately after finishing. */
+			thrd_join(threadPt->thread, NULL);
+			threadPt->state = MCR_THREAD_IDLE;
+		}
+	}
+}
+
+static int start_thread(struct mcr_Macro *mcrPt)
+{
+	struct mcr_MacroThread *threadPt = mcrPt->threads;
+	int i, thrdErr;
+	for (i = 0; i < MCR_THREAD_MAX; i++, threadPt++) {
+		if (threadPt->state == MCR_THREAD_IDLE)
+			break;
+	}
+	if (i == MCR_THREAD_MAX)
+		mset_error_return(EBUSY);
+	threadPt->macro = mcrPt;
+	threadPt->interrupted = false;
+	threadPt->state = MCR_THREAD_RUNNING;
+	/* Thread cannot exit until we unlock. */
+	if ((thrdErr = thrd_create(&threadPt->thread, thread_macro,
+							   threadPt)) != thrd_success) {
+		threadPt->state = MCR_THREAD_IDLE;
+		thrd_conv_err(thrdErr);
+		return thrdErr;
+	}
+	++mcrPt->thread_count;
+	return 0;
 }
 
 /* clearType should not be MCR_CONTINUE or MCR_PAUSE.
@@ -522,47 +808,36 @@ static int thread_wait_reset(void *data)
 static int clear_threads(struct mcr_Macro *mcrPt, enum mcr_Interrupt clearType,
 						 bool stickyInterrupt)
 {
-	/// \todo Do not rely on a timeout to say no threads exist
-	/* If timed out then we probably have a long-running signal.
-	 * As long as pthread_exit is not called, then the C runtime
-	 * will also exit other threads. In this case valgrind will report
-	 * thread is still using resources. */
-	struct timespec cndTimeout = {
-		MCR_MACRO_JOIN_TIMEOUT, 0
-	};
-	int thrdErr;
-	mtx_t lock;
-	dequeue(mcrPt, clearType);
-	thrd_yield();
-	/* No threads are running, and we just set the interruptor. */
-	if (!isrunning(mcrPt))
-		return 0;
-	thrdErr = mtx_init(&lock, mtx_plain);
-	if (thrdErr == thrd_success && (thrdErr = mtx_lock(&lock)) != thrd_success)
-		mtx_destroy(&lock);
+	/* Do not wait for ourselves. */
+	int selfCount = _currentThread && _currentThread->macro == mcrPt ? 1 : 0;
+	int thrdErr = mtx_lock(&mcrPt->lock);
 	if (thrdErr != thrd_success) {
 		thrd_conv_err(thrdErr);
 		return thrdErr;
 	}
-	/* When timed out there may be a long-running signal(e.g. NoOp) */
-	while (mcrPt->thread_count && thrdErr != thrd_timedout) {
-		dequeue(mcrPt, clearType);
-		/* Wait to be notified, or time out to destroy. */
-		thrdErr = cnd_timedwait(&mcrPt->thread_count_cnd, &lock, &cndTimeout);
+	mcrPt->interruptor = clearType;
+	mcrPt->queued = 0;
+	/* Wake all sleeping and paused threads. */
+	cnd_broadcast(&mcrPt->thread_count_cnd);
+	if (_interruptListener)
+		_interruptListener(mcrPt);
+	while (mcrPt->thread_count > selfCount) {
 		/* Changed interrupt. Exit only if not sticking our interrupt. */
-		if (!stickyInterrupt && mcrPt->interruptor != clearType) {
-			thrdErr = thrd_success;
-			break;
+		if (mcrPt->interruptor != clearType) {
+			if (!stickyInterrupt)
+				break;
+			mcrPt->interruptor = clearType;
+		}
+		if ((thrdErr = cnd_wait(&mcrPt->thread_count_cnd,
+								&mcrPt->lock)) != thrd_success) {
+			mtx_unlock(&mcrPt->lock);
+			thrd_conv_err(thrdErr);
+			return thrdErr;
 		}
 	}
-	/* If timed out, we lose control over threads. */
-	if (thrdErr) {
-		thrd_conv_err(thrdErr);
-		mcrPt->thread_count = 0;
-		cnd_broadcast(&mcrPt->thread_count_cnd);
-	}
-	mtx_destroy(&lock);
-	return thrdErr;
+	join_finished(mcrPt);
+	mtx_unlock(&mcrPt->lock);
+	return 0;
 }
 
 int mcr_macro_initialize(struct mcr_context *ctx)
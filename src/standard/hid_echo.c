@@ -23,7 +23,8 @@
 int mcr_HidEcho_send(struct mcr_Signal *signalPt)
 {
 	struct mcr_HidEcho *echoPt = mcr_HidEcho_data(signalPt);
-	return echoPt ? mcr_HidEcho_send_data(echoPt) : 0;
+	return echoPt ? mcr_HidEcho_send_data(
+			   signalPt->isignal->interface.context, echoPt) : 0;
 }
 
 size_t mcr_HidEcho_name_echo(struct mcr_context * ctx, const char *eventName)
@@ -42,7 +42,8 @@ int mcr_Key_send(struct mcr_Signal *sigPt)
 {
 	dassert(sigPt);
 	struct mcr_Key *keyPt = mcr_Key_data(sigPt);
-	return keyPt ? mcr_Key_send_data(keyPt) : 0;
+	return keyPt ? mcr_Key_send_data(
+			   sigPt->isignal->interface.context, keyPt) : 0;
 }
 
 int mcr_Key_name_key(struct mcr_context *ctx, const char *keyName)
@@ -16,33 +16,113 @@
   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
-#include "mcr/standard/linux/p_device.h"
-#include "mcr/standard/standard.h"
+#include "mcr/standard/linux/p_standard.h"
+#include "mcr/libmacro.h"
 
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <linux/joystick.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 
-MCR_API struct mcr_Device mcr_genDev;
-MCR_API struct mcr_Device mcr_absDev;
-
 const MCR_API struct input_event mcr_syncer = {
 	.type = EV_SYN,
 	.code = SYN_REPORT
 };
 
-MCR_API __s32 mcr_abs_resolution = MCR_ABS_RESOLUTION;
+/* Paths are the same for all contexts. */
+static char _uinputPath[PATH_MAX] = MCR_STR(MCR_UINPUT_PATH);
+static char _eventPath[PATH_MAX] = MCR_STR(MCR_EVENT_PATH);
+static __thread unsigned int _threadRoute;
+
+/* Outputs below the count are initialized before the count is stored. */
+#define output_count_load(platformPt) \
+__atomic_load_n(&(platformPt)->output_count, __ATOMIC_ACQUIRE)
+
+/* Allocation of an added output */
+struct _output {
+	struct mcr_OutputDevice output;
+	struct mcr_Device gen;
+	struct mcr_Device abs;
+};
+
+/* Events sent by one thread, not yet written */
+struct _output_buffer {
+	/* Nested mcr_output_begin, 0 if writing immediately */
+	unsigned int depth;
+	/* Depth of the mcr_output_begin merging frames, 0 if not merging */
+	unsigned int merge_depth;
+	/* Device of all buffered events */
+	struct mcr_Device *device;
+	struct input_event events[MCR_OUTPUT_LENGTH];
+	size_t count;
+	/* First event after the last SYN_REPORT kept */
+	size_t frame_start;
+};
+static __thread struct _output_buffer _output;
+
+/* Bit of a code in its byte of a bit array */
+#define BITMASK(code) (1 << ((code) % 8))
+
+/* UI_SET_*BIT types in order of writing, evbits first */
+static const struct _bit_type {
+	int set_bit;
+	size_t offset;
+	int count;
+} _bitTypes[] = {
+	{ UI_SET_EVBIT, offsetof(struct mcr_DeviceCapabilities, ev), EV_CNT },
+	{ UI_SET_KEYBIT, offsetof(struct mcr_DeviceCapabilities, key), KEY_CNT },
+	{ UI_SET_RELBIT, offsetof(struct mcr_DeviceCapabilities, rel), REL_CNT },
+	{ UI_SET_ABSBIT, offsetof(struct mcr_DeviceCapabilities, abs), ABS_CNT },
+	{ UI_SET_MSCBIT, offsetof(struct mcr_DeviceCapabilities, msc), MSC_CNT },
+	{ UI_SET_LEDBIT, offsetof(struct mcr_DeviceCapabilities, led), LED_CNT },
+	{ UI_SET_SNDBIT, offsetof(struct mcr_DeviceCapabilities, snd), SND_CNT },
+	{ UI_SET_FFBIT, offsetof(struct mcr_DeviceCapabilities, ff), FF_CNT },
+	{ UI_SET_SWBIT, offsetof(struct mcr_DeviceCapabilities, sw), SW_CNT },
+	{
+		UI_SET_PROPBIT, offsetof(struct mcr_DeviceCapabilities, prop),
+		INPUT_PROP_CNT
+	}
+};
+
+/* Generic device: all keys except KEY_RESERVED, relative, misc, and
+ * sound. Does not handle abs, sw, led, ff, ff_status */
+static const struct mcr_DeviceCapabilities _genProfile = {
+	.ev = {
+		[0] = BITMASK(EV_SYN) | BITMASK(EV_KEY) | BITMASK(EV_REL) |
+		BITMASK(EV_MSC),
+		[EV_SND / 8] = BITMASK(EV_SND) | BITMASK(EV_REP)
+	},
+	.key = { [0] = 0xFE, [1 ... MCR_DEVICE_BYTES(KEY_CNT) - 1] = 0xFF },
+	.rel = { [0 ... MCR_DEVICE_BYTES(REL_CNT) - 1] = 0xFF },
+	.msc = { [0 ... MCR_DEVICE_BYTES(MSC_CNT) - 1] = 0xFF },
+	.snd = { [0 ... MCR_DEVICE_BYTES(SND_CNT) - 1] = 0xFF },
+	/* On-screen pointer and mapped directly to screen coordinates */
+	.prop = {
+		[0] = BITMASK(INPUT_PROP_POINTER) | BITMASK(INPUT_PROP_DIRECT)
+	}
+};
 
-static mcr_String _uinputPath;
-static mcr_String _eventPath;
-static mtx_t _deviceLock;
+/* Absolute device: ABS_X through ABS_MISC */
+static const struct mcr_DeviceCapabilities _absProfile = {
+	.ev = { [0] = BITMASK(EV_SYN) | BITMASK(EV_KEY) | BITMASK(EV_ABS) },
+	/* Not used, but required to be set up correctly */
+	.key = { [BTN_LEFT / 8] = BITMASK(BTN_LEFT) },
+	.abs = {
+		[0 ... ABS_MISC / 8 - 1] = 0xFF,
+		[ABS_MISC / 8] = (BITMASK(ABS_MISC) << 1) - 1
+	},
+	.prop = {
+		[0] = BITMASK(INPUT_PROP_POINTER) | BITMASK(INPUT_PROP_DIRECT)
+	}
+};
 
-/* Open uinput ( devPt->fd ) and write device to it. */
+/* Open uinput ( devPt->fd ). */
 static int device_open(struct mcr_Device *devPt);
 /* Open event device ( devPt->eventFd ). */
 static int device_open_event(struct mcr_Device *devPt);
@@ -50,77 +130,105 @@ static int device_open_event(struct mcr_Device *devPt);
 static int device_close(struct mcr_Device *devPt);
 /* Close devPt->eventFd. */
 static int device_close_event(struct mcr_Device *devPt);
-/* Open event device ( devPt->eventFd ) from current working directory. */
-static int device_open_event_wd(struct mcr_Device *devPt);
+/* Name of the event node created for devPt->fd, from sysfs. */
+static int device_event_name(struct mcr_Device *devPt, char *nameBuffer,
+							 size_t bufferSize);
+/* Open event device ( devPt->eventFd ) by scanning the event directory. */
+static int device_open_event_scan(struct mcr_Device *devPt, int dirFd);
 /* Verify devPt->eventFd is correct for given device. */
 static bool device_is_event_me(struct mcr_Device *devPt,
 							   char *nameBuffer, bool isJoy);
-/* Write event to device for all values in bits. */
-static int device_write_bits(struct mcr_Device *devPt, int event,
-							 struct mcr_Array *bits);
-/* Write all UI_SET_EVBIT values for given device. */
-static int device_write_evbit(struct mcr_Device *devPt);
-/* Write all non-UI_SET_EVBIT values for given device. */
-static int device_write_non_evbit(struct mcr_Device *devPt);
+/* Bit type of a UI_SET_*BIT, or null if unknown. */
+static const struct _bit_type *bit_type(int setBit);
+/* Write all set values of one bit type to device. */
+static int device_write_bits(struct mcr_Device *devPt,
+							 const struct _bit_type *typePt);
+/* Write name, id, and absolute axes to device after all bits. */
+static int device_setup(struct mcr_Device *devPt);
 /* Write UI_DEV_CREATE after writing all evbits to device. */
 static int device_create(struct mcr_Device *devPt);
 
-static int genDevice_init();
-static int absDevice_init();
+static int device_enable(struct mcr_Device *devPt, bool enable);
+static int device_write(struct mcr_Device *devPt,
+						const struct input_event *events, size_t count);
+static inline bool device_is_writable(const struct mcr_Device *devPt);
+static void sink_write(struct mcr_DeviceSink *sinkPt,
+					   const struct input_event *events, size_t count);
+static int sink_set(struct mcr_DeviceSink *sinkPt, int type,
+					size_t capacity);
+static void output_append(const struct input_event *events, size_t count);
+static inline bool is_report(const struct input_event *evPt);
+
+static int device_profile(struct mcr_Device *devPt, const char *name,
+						  const struct mcr_DeviceCapabilities *profilePt);
+static int output_init(struct mcr_standard_platform *platformPt,
+					   struct mcr_Device *genPt, struct mcr_Device *absPt,
+					   unsigned int output);
+static void output_create(struct mcr_standard_platform *platformPt,
+						  struct mcr_OutputDevice *outPt);
+static void output_free(struct mcr_OutputDevice *outPt);
+static int set_path(char *buffer, const char *path);
 
-static int init_IntArray(void *data)
+int mcr_Device_set_uinput_path(const char *path)
 {
-	if (data) {
-		mcr_Array_init(data);
-		((struct mcr_Array *)data)->element_size = sizeof(int);
-	}
-	return 0;
+	return set_path(_uinputPath, path);
 }
 
-/* Initialize and deinit array of integers */
-static const struct mcr_Interface _iIntArray = {
-	.data_size = sizeof(struct mcr_Array),
-	.init = init_IntArray,
-	.deinit = mcr_Array_deinit
-};
+int mcr_Device_set_event_path(const char *directoryPath)
+{
+	return set_path(_eventPath, directoryPath);
+}
 
-int mcr_Device_set_uinput_path(const char *path)
+struct mcr_Device *mcr_Device_gen(struct mcr_context *ctx)
 {
-	if (!path || path[0] == '\0')
-		return ENODEV;
-	return mcr_String_replace(&_uinputPath, path);
+	return &((struct mcr_standard_platform *)ctx->standard.platform)->gen_dev;
 }
 
-int mcr_Device_set_event_path(const char *directoryPath)
+struct mcr_Device *mcr_Device_abs(struct mcr_context *ctx)
 {
-	if (!directoryPath || directoryPath[0] == '\0')
-		return ENODEV;
-	return mcr_String_replace(&_eventPath, directoryPath);
+	return &((struct mcr_standard_platform *)ctx->standard.platform)->abs_dev;
 }
 
-int mcr_Device_set_absolute_resolution(__s32 resolution)
+__s32 mcr_Device_absolute_resolution(struct mcr_context *ctx)
 {
-	bool wasEnabled = mcr_absDev.enabled;
-	mcr_abs_resolution = resolution;
-	mcr_Device_deinit(&mcr_absDev);
-	if (absDevice_init())
-		return mcr_err;
-	if (wasEnabled)
-		return mcr_Device_enable(&mcr_absDev, true);
+	return ((struct mcr_standard_platform *)
+			ctx->standard.platform)->abs_resolution;
+}
+
+int mcr_Device_set_absolute_resolution(struct mcr_context *ctx,
+									   __s32 resolution)
+{
+	struct mcr_standard_platform *platformPt = ctx->standard.platform;
+	struct mcr_Device *absPt;
+	unsigned int i;
+	int j;
+	/* Not recreating devices with the same axis ranges */
+	if (platformPt->abs_resolution == resolution)
+		return 0;
+	platformPt->abs_resolution = resolution;
+	for (i = 0; i < output_count_load(platformPt); i++) {
+		absPt = platformPt->outputs[i]->abs;
+		for (j = 0; j <= ABS_MISC; j++) {
+			absPt->device.absmax[j] = resolution;
+		}
+		if (absPt->enabled && mcr_Device_enable(absPt, true))
+			return mcr_err;
+	}
 	return 0;
 }
 
 int mcr_Device_init(void *dataPt)
 {
 	struct mcr_Device *localPt = dataPt;
+	int mtxErr;
 	if (localPt) {
 		memset(dataPt, 0, sizeof(struct mcr_Device));
 		localPt->fd = -1;
 		localPt->event_fd = -1;
-		mcr_Map_init(&localPt->type_value_map);
-		mcr_Map_set_all(&localPt->type_value_map, sizeof(int),
-						sizeof(struct mcr_Array), mcr_int_compare, NULL,
-						&_iIntArray);
+		if ((mtxErr = mtx_init(&localPt->lock, mtx_plain)) != thrd_success) {
+			mtxErr = mcr_thrd_errno(mtxErr);
+			mset_error_return(mtxErr);
+		}
 	}
 	return 0;
 }
@@ -130,23 +238,31 @@ int mcr_Device_deinit(void *dataPt)
 	struct mcr_Device *devPt = dataPt;
 	if (devPt) {
 		mcr_Device_enable(devPt, false);
-		mcr_Map_deinit(&devPt->type_value_map);
-		mcr_Device_init(devPt);
+		free(devPt->sink.ring);
+		devPt->sink.ring = NULL;
+		mtx_destroy(&devPt->lock);
 	}
 	return 0;
 }
 
-static inline int mtx_unlock_error(int mtxError)
+int mcr_Device_enable(struct mcr_Device *devPt, bool enable)
 {
-	if (mtxError == thrd_success)
-		mtx_unlock(&_deviceLock);
+	int mtxErr;
+	dassert(devPt);
+	/* Writing is not possible while fd changes. */
+	if ((mtxErr = mtx_lock(&devPt->lock)) != thrd_success) {
+		mtxErr = mcr_thrd_errno(mtxErr);
+		mset_error_return(mtxErr);
+	}
+	mcr_err = 0;
+	device_enable(devPt, enable);
+	mtx_unlock(&devPt->lock);
 	return mcr_err;
 }
 
-int mcr_Device_enable(struct mcr_Device *devPt, bool enable)
+static int device_enable(struct mcr_Device *devPt, bool enable)
 {
-	int mtxErr = thrd_success;
-	dassert(devPt);
+	size_t i;
 	devPt->enabled = false;
 	if (device_close_event(devPt))
 		return mcr_err;
@@ -160,35 +276,27 @@ int mcr_Device_enable(struct mcr_Device *devPt, bool enable)
 	 * Must have at least 1 UI_SET_EVBIT. */
 	if (!mcr_Device_has_evbit(devPt))
 		mset_error_return(EPERM);
-	if ((mtxErr = mtx_lock(&_deviceLock)) != thrd_success) {
-		mtxErr = mcr_thrd_errno(mtxErr);
-		mset_error_return(mtxErr);
-	}
-	mcr_err = 0;
 	/* Start by opening. */
 	if (device_open(devPt))
-		return mtx_unlock_error(mtxErr);
-	/* Force evbit satisfaction. */
-	if (device_write_evbit(devPt))
-		return mtx_unlock_error(mtxErr);
-	/* Then write all other bits. Ensured at least one mapping pair. */
-	if (device_write_non_evbit(devPt))
-		return mtx_unlock_error(mtxErr);
-	if (device_create(devPt))
-		return mtx_unlock_error(mtxErr);
+		return mcr_err;
+	/* Evbits first, then all other bits. */
+	for (i = 0; i < arrlen(_bitTypes); i++) {
+		if (device_write_bits(devPt, _bitTypes + i))
+			return mcr_err;
+	}
+	if (device_setup(devPt) || device_create(devPt))
+		return mcr_err;
 	/* Created and ready. valid true is all good, false means some */
 	/* non-UI_SET_EVBIT did not work. */
 	devPt->enabled = true;
 	device_open_event(devPt);
-	if (mtxErr == thrd_success)
-		mtx_unlock(&_deviceLock);
 	return mcr_err;
 }
 
-int mcr_Device_enable_all(bool enable)
+int mcr_Device_enable_all(struct mcr_context *ctx, bool enable)
 {
-	if (mcr_Device_enable(&mcr_genDev, enable) ||
-		mcr_Device_enable(&mcr_absDev, enable))
+	if (mcr_Device_enable(mcr_Device_gen(ctx), enable) ||
+		mcr_Device_enable(mcr_Device_abs(ctx), enable))
 		return mcr_err;
 	return 0;
 }
@@ -196,32 +304,478 @@ int mcr_Device_enable_all(bool enable)
 int mcr_Device_set_bits(struct mcr_Device *devPt, int bitType, int *bits,
 						size_t bitLen)
 {
-	struct mcr_Array *element =
-		mcr_Map_element_ensured(&devPt->type_value_map,
-								&bitType);
-	if (element)
-		element = mcr_Map_valueof(&devPt->type_value_map, element);
+	const struct _bit_type *typePt = bit_type(bitType);
+	unsigned char *bitArr;
+	size_t i;
+	dassert(devPt);
+	dassert(bits || !bitLen);
+	if (!typePt)
+		mset_error_return(EINVAL);
+	for (i = 0; i < bitLen; i++) {
+		if (bits[i] < 0 || bits[i] >= typePt->count)
+			mset_error_return(EINVAL);
+	}
+	bitArr = (unsigned char *)&devPt->capabilities + typePt->offset;
+	memset(bitArr, 0, MCR_DEVICE_BYTES(typePt->count));
+	for (i = 0; i < bitLen; i++) {
+		bitArr[bits[i] / 8] |= BITMASK(bits[i]);
+	}
+	return 0;
+}
+
+int mcr_Device_set_bit_range(struct mcr_Device *devPt, int bitType,
+							 int first, int count, bool enable)
+{
+	const struct _bit_type *typePt = bit_type(bitType);
+	unsigned char *bitArr;
+	int i;
 	dassert(devPt);
-	dassert(bits);
-	dassert(bitLen != (size_t) ~ 0);
-	return element ? mcr_Array_replace(element, bits, bitLen) : mcr_err;
+	if (!typePt || first < 0 || count < 0
+		|| count > typePt->count - first) {
+		mset_error_return(EINVAL);
+	}
+	bitArr = (unsigned char *)&devPt->capabilities + typePt->offset;
+	for (i = first; i < first + count; i++) {
+		if (enable)
+			bitArr[i / 8] |= BITMASK(i);
+		else
+			bitArr[i / 8] &= ~BITMASK(i);
+	}
+	return 0;
 }
 
-struct mcr_Array *mcr_Device_bits(struct mcr_Device *devPt, int bitType)
+bool mcr_Device_has_bit(struct mcr_Device *devPt, int bitType, int value)
 {
-	void *ret = MCR_MAP_ELEMENT(devPt->type_value_map, &bitType);
+	const struct _bit_type *typePt = bit_type(bitType);
 	dassert(devPt);
-	return MCR_MAP_VALUEOF(devPt->type_value_map, ret);
+	if (!typePt || value < 0 || value >= typePt->count)
+		return false;
+	return MCR_DEVICE_ISSET((unsigned char *)&devPt->capabilities +
+							typePt->offset, value);
 }
 
 bool mcr_Device_has_evbit(struct mcr_Device * devPt)
 {
-	int evbit = UI_SET_EVBIT;
-	struct mcr_Array *evbit_arr = MCR_MAP_ELEMENT(devPt->type_value_map,
-								  &evbit);
+	size_t i;
 	dassert(devPt);
-	evbit_arr = MCR_MAP_VALUEOF(devPt->type_value_map, evbit_arr);
-	return evbit_arr && evbit_arr->used;
+	for (i = 0; i < sizeof(devPt->capabilities.ev); i++) {
+		if (devPt->capabilities.ev[i])
+			return true;
+	}
+	return false;
+}
+
+int mcr_Device_set_flush_policy(struct mcr_Device *devPt, int policy)
+{
+	dassert(devPt);
+	if (policy < MCR_FLUSH_BATCHED || policy > MCR_FLUSH_IMMEDIATE)
+		mset_error_return(EINVAL);
+	/* Nothing buffered is written with a different policy. */
+	if (_output.device == devPt && mcr_output_flush())
+		return mcr_err;
+	devPt->flush_policy = policy;
+	return 0;
+}
+
+int mcr_Device_set_synchronous(struct mcr_Device *devPt, bool synchronous)
+{
+	dassert(devPt);
+	if (devPt->synchronous == synchronous)
+		return 0;
+	devPt->synchronous = synchronous;
+	return devPt->enabled ? mcr_Device_enable(devPt, true) : 0;
+}
+
+int mcr_Device_set_sink(struct mcr_Device *devPt, int type, size_t capacity)
+{
+	int mtxErr, err;
+	dassert(devPt);
+	if (type < MCR_SINK_UINPUT || type > MCR_SINK_RING
+		|| (type == MCR_SINK_RING && !capacity)) {
+		mset_error_return(EINVAL);
+	}
+	/* Nothing buffered is written to a different sink. */
+	if (_output.device == devPt && mcr_output_flush())
+		return mcr_err;
+	if ((mtxErr = mtx_lock(&devPt->lock)) != thrd_success) {
+		mtxErr = mcr_thrd_errno(mtxErr);
+		mset_error_return(mtxErr);
+	}
+	err = sink_set(&devPt->sink, type, capacity);
+	mtx_unlock(&devPt->lock);
+	if (err)
+		mset_error_return(err);
+	return 0;
+}
+
+void mcr_Device_sink_counts(struct mcr_Device *devPt,
+							struct mcr_SinkCounts *countsPt)
+{
+	dassert(devPt);
+	dassert(countsPt);
+	if (mtx_lock(&devPt->lock) != thrd_success) {
+		memset(countsPt, 0, sizeof(struct mcr_SinkCounts));
+		return;
+	}
+	*countsPt = devPt->sink.counts;
+	mtx_unlock(&devPt->lock);
+}
+
+size_t mcr_Device_sink_read(struct mcr_Device *devPt,
+							struct input_event *buffer, size_t count)
+{
+	struct mcr_DeviceSink *sinkPt;
+	size_t i;
+	dassert(devPt);
+	dassert(buffer);
+	sinkPt = &devPt->sink;
+	if (mtx_lock(&devPt->lock) != thrd_success)
+		return 0;
+	if (!sinkPt->ring) {
+		mtx_unlock(&devPt->lock);
+		return 0;
+	}
+	/* Skip events that have been overwritten */
+	if (sinkPt->head - sinkPt->tail > sinkPt->capacity)
+		sinkPt->tail = sinkPt->head - sinkPt->capacity;
+	for (i = 0; i < count && sinkPt->tail != sinkPt->head; i++) {
+		buffer[i] = sinkPt->ring[sinkPt->tail++ % sinkPt->capacity];
+	}
+	mtx_unlock(&devPt->lock);
+	return i;
+}
+
+void mcr_Device_sink_reset(struct mcr_Device *devPt)
+{
+	dassert(devPt);
+	if (mtx_lock(&devPt->lock) != thrd_success)
+		return;
+	memset(&devPt->sink.counts, 0, sizeof(struct mcr_SinkCounts));
+	devPt->sink.head = devPt->sink.tail = 0;
+	mtx_unlock(&devPt->lock);
+}
+
+int mcr_output_set_sink(struct mcr_context *ctx, int type, size_t capacity)
+{
+	struct mcr_standard_platform *platformPt = ctx->standard.platform;
+	unsigned int i;
+	int mtxErr;
+	if (type < MCR_SINK_UINPUT || type > MCR_SINK_RING
+		|| (type == MCR_SINK_RING && !capacity)) {
+		mset_error_return(EINVAL);
+	}
+	if ((mtxErr = mtx_lock(&platformPt->lock)) != thrd_success) {
+		mtxErr = mcr_thrd_errno(mtxErr);
+		mset_error_return(mtxErr);
+	}
+	platformPt->sink_type = type;
+	platformPt->sink_capacity = capacity;
+	mcr_err = 0;
+	for (i = 0; i < platformPt->output_count; i++) {
+		if (mcr_Device_set_sink(platformPt->outputs[i]->gen, type, capacity)
+			|| mcr_Device_set_sink(platformPt->outputs[i]->abs, type,
+								   capacity)) {
+			break;
+		}
+	}
+	mtx_unlock(&platformPt->lock);
+	return mcr_err;
+}
+
+int mcr_Device_send(struct mcr_Device *devPt,
+					const struct input_event *events, size_t count)
+{
+	dassert(devPt);
+	dassert(events);
+	if (!device_is_writable(devPt))
+		return 0;
+	if (!_output.depth || count > MCR_OUTPUT_LENGTH
+		|| devPt->flush_policy == MCR_FLUSH_IMMEDIATE) {
+		if (_output.count && mcr_output_flush())
+			return mcr_err;
+		return device_write(devPt, events, count);
+	}
+	/* Keep order between devices */
+	if (_output.device != devPt
+		|| _output.count + count > MCR_OUTPUT_LENGTH) {
+		if (mcr_output_flush())
+			return mcr_err;
+		_output.device = devPt;
+	}
+	output_append(events, count);
+	if (devPt->flush_policy == MCR_FLUSH_FRAME && count
+		&& is_report(events + count - 1)) {
+		return mcr_output_flush();
+	}
+	return 0;
+}
+
+void mcr_output_begin(bool mergeFrames)
+{
+	++_output.depth;
+	if (mergeFrames && !_output.merge_depth)
+		_output.merge_depth = _output.depth;
+}
+
+int mcr_output_flush(void)
+{
+	struct mcr_Device *devPt = _output.device;
+	size_t count = _output.count;
+	_output.count = _output.frame_start = 0;
+	_output.device = NULL;
+	/* Disabled since buffering, discard */
+	if (!count || !devPt || !device_is_writable(devPt))
+		return 0;
+	return device_write(devPt, _output.events, count);
+}
+
+int mcr_output_end(void)
+{
+	if (!_output.depth)
+		return 0;
+	if (_output.merge_depth == _output.depth)
+		_output.merge_depth = 0;
+	if (--_output.depth)
+		return 0;
+	return mcr_output_flush();
+}
+
+bool mcr_output_is_buffering(void)
+{
+	return _output.depth;
+}
+
+static int device_write(struct mcr_Device *devPt,
+						const struct input_event *events, size_t count)
+{
+	int mtxErr = mtx_lock(&devPt->lock);
+	int err = 0;
+	if (mtxErr != thrd_success) {
+		mtxErr = mcr_thrd_errno(mtxErr);
+		mset_error_return(mtxErr);
+	}
+	if (devPt->sink.type != MCR_SINK_UINPUT) {
+		sink_write(&devPt->sink, events, count);
+	} else if (devPt->fd != -1
+			   && write(devPt->fd, events,
+						count * sizeof(struct input_event)) == -1) {
+		/* Disabled while waiting is discarded */
+		mcr_errno(EINTR);
+		err = mcr_err;
+	}
+	mtx_unlock(&devPt->lock);
+	return err;
+}
+
+static inline bool device_is_writable(const struct mcr_Device *devPt)
+{
+	return devPt->fd != -1 || devPt->sink.type != MCR_SINK_UINPUT;
+}
+
+/* \pre Device locked */
+static void sink_write(struct mcr_DeviceSink *sinkPt,
+					   const struct input_event *events, size_t count)
+{
+	size_t i;
+	if (sinkPt->type == MCR_SINK_NULL)
+		return;
+	++sinkPt->counts.writes;
+	sinkPt->counts.bytes += count * sizeof(struct input_event);
+	for (i = 0; i < count; i++) {
+		if (events[i].type < EV_CNT)
+			++sinkPt->counts.types[events[i].type];
+	}
+	if (sinkPt->type != MCR_SINK_RING)
+		return;
+	/* Only the last capacity events are kept */
+	i = count > sinkPt->capacity ? count - sinkPt->capacity : 0;
+	sinkPt->head += i;
+	for (; i < count; i++) {
+		sinkPt->ring[sinkPt->head++ % sinkPt->capacity] = events[i];
+	}
+}
+
+/* \pre Device locked
+ * \return error code */
+static int sink_set(struct mcr_DeviceSink *sinkPt, int type,
+					size_t capacity)
+{
+	struct input_event *ring = NULL;
+	if (type == MCR_SINK_RING && !(ring = malloc(capacity * sizeof(
+									   struct input_event)))) {
+		return ENOMEM;
+	}
+	free(sinkPt->ring);
+	memset(sinkPt, 0, sizeof(struct mcr_DeviceSink));
+	sinkPt->type = type;
+	sinkPt->ring = ring;
+	sinkPt->capacity = ring ? capacity : 0;
+	return 0;
+}
+
+int mcr_output_add(struct mcr_context *ctx, unsigned int *outputPt)
+{
+	struct mcr_standard_platform *platformPt = ctx->standard.platform;
+	unsigned int output;
+	struct _output *pt;
+	int mtxErr;
+	dassert(outputPt);
+	if ((mtxErr = mtx_lock(&platformPt->lock)) != thrd_success) {
+		mtxErr = mcr_thrd_errno(mtxErr);
+		mset_error_return(mtxErr);
+	}
+	mcr_err = 0;
+	output = platformPt->output_count;
+	if (output == MCR_OUTPUT_MAX) {
+		mtx_unlock(&platformPt->lock);
+		mset_error_return(ENOSPC);
+	}
+	if (!(pt = malloc(sizeof(struct _output)))) {
+		mtx_unlock(&platformPt->lock);
+		mset_error_return(ENOMEM);
+	}
+	pt->output.gen = &pt->gen;
+	pt->output.abs = &pt->abs;
+	pt->output.created = false;
+	if (output_init(platformPt, &pt->gen, &pt->abs, output)) {
+		free(pt);
+		mtx_unlock(&platformPt->lock);
+		return mcr_err;
+	}
+	/* Readers only see outputs below the count. */
+	platformPt->outputs[output] = &pt->output;
+	__atomic_store_n(&platformPt->output_count, output + 1,
+					 __ATOMIC_RELEASE);
+	*outputPt = output;
+	mtx_unlock(&platformPt->lock);
+	return 0;
+}
+
+unsigned int mcr_output_count(struct mcr_context *ctx)
+{
+	return output_count_load((struct mcr_standard_platform *)
+							 ctx->standard.platform);
+}
+
+int mcr_output_set_signal_route(struct mcr_context *ctx,
+								struct mcr_ISignal *isigPt, unsigned int output)
+{
+	struct mcr_standard *standardPt = &ctx->standard;
+	struct mcr_standard_platform *platformPt = standardPt->platform;
+	int signalType;
+	dassert(isigPt);
+	if (isigPt == &standardPt->ihid_echo) {
+		signalType = MCR_OUTPUT_HID_ECHO;
+	} else if (isigPt == &standardPt->ikey) {
+		signalType = MCR_OUTPUT_KEY;
+	} else if (isigPt == &standardPt->imove_cursor) {
+		signalType = MCR_OUTPUT_MOVE_CURSOR;
+	} else if (isigPt == &standardPt->iscroll) {
+		signalType = MCR_OUTPUT_SCROLL;
+	} else {
+		mset_error_return(EINVAL);
+	}
+	if (output >= output_count_load(platformPt))
+		mset_error_return(ENOENT);
+	platformPt->signal_routes[signalType] = output;
+	return 0;
+}
+
+unsigned int mcr_output_set_thread_route(unsigned int output)
+{
+	unsigned int previous = _threadRoute;
+	_threadRoute = output;
+	return previous;
+}
+
+struct mcr_OutputDevice *mcr_output_device(struct mcr_context *ctx,
+		unsigned int output)
+{
+	struct mcr_standard_platform *platformPt = ctx->standard.platform;
+	struct mcr_OutputDevice *outPt;
+	if (output >= output_count_load(platformPt))
+		return NULL;
+	outPt = platformPt->outputs[output];
+	if (!outPt->created)
+		output_create(platformPt, outPt);
+	return outPt;
+}
+
+struct mcr_OutputDevice *mcr_output_routed(struct mcr_context *ctx,
+		int signalType)
+{
+	struct mcr_standard_platform *platformPt = ctx->standard.platform;
+	unsigned int output;
+	struct mcr_OutputDevice *outPt;
+	dassert(signalType >= 0 && signalType < MCR_OUTPUT_SIGNAL_CNT);
+	output = _threadRoute ? _threadRoute :
+			 platformPt->signal_routes[signalType];
+	if (!output || !(outPt = mcr_output_device(ctx, output)))
+		return &platformPt->default_output;
+	return outPt;
+}
+
+bool mcr_output_is_device_name(struct mcr_context *ctx, const char *name)
+{
+	struct mcr_standard_platform *platformPt = ctx->standard.platform;
+	struct mcr_OutputDevice *outPt;
+	unsigned int i;
+	dassert(name);
+	for (i = 0; i < output_count_load(platformPt); i++) {
+		outPt = platformPt->outputs[i];
+		if (!strncmp(name, outPt->gen->device.name, UINPUT_MAX_NAME_SIZE)
+			|| !strncmp(name, outPt->abs->device.name,
+						UINPUT_MAX_NAME_SIZE)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline bool is_report(const struct input_event *evPt)
+{
+	return evPt->type == EV_SYN && evPt->code == SYN_REPORT;
+}
+
+/* Merging would lose a key or absolute state in the current frame. */
+static bool output_conflicts(const struct input_event *events, size_t count)
+{
+	size_t i, j;
+	for (i = 0; i < count; i++) {
+		if (events[i].type != EV_KEY && events[i].type != EV_ABS)
+			continue;
+		for (j = _output.frame_start; j < _output.count; j++) {
+			if (_output.events[j].type == events[i].type
+				&& _output.events[j].code == events[i].code) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+static void output_append(const struct input_event *events, size_t count)
+{
+	size_t i;
+	if (!count)
+		return;
+	/* Remove the previous synchronization, continuing its frame */
+	if (_output.count && is_report(_output.events + _output.count - 1)) {
+		if (_output.merge_depth && !output_conflicts(events, count))
+			--_output.count;
+		else
+			_output.frame_start = _output.count;
+	}
+	memcpy(_output.events + _output.count, events,
+		   count * sizeof(struct input_event));
+	/* The last frame is ended by the last synchronization. */
+	for (i = count - 1; i-- > 0;) {
+		if (is_report(events + i)) {
+			_output.frame_start = _output.count + i + 1;
+			break;
+		}
+	}
+	_output.count += count;
 }
 
 static int device_open(struct mcr_Device *devPt)
@@ -230,53 +784,38 @@ static int device_open(struct mcr_Device *devPt)
 	/* Close in case previously opened. */
 	if (device_close(devPt))
 		return mcr_err;
-	devPt->fd = open(_uinputPath.array, O_WRONLY | O_SYNC);
+	devPt->fd = open(_uinputPath,
+					 devPt->synchronous ? O_WRONLY | O_SYNC : O_WRONLY);
 	if (devPt->fd == -1) {
 		mcr_errno(EINTR);
 		return mcr_err;
 	}
-	if (write(devPt->fd, &devPt->device, sizeof(devPt->device)) !=
-		sizeof(devPt->device)) {
-		mcr_errno(EINTR);
-		device_close(devPt);
-		return mcr_err;
-	}
 	return 0;
 }
 
 static int device_open_event(struct mcr_Device *devPt)
 {
-	long int size;
-	char *wd;
-	char *ptr;
+	char name[NAME_MAX + 1];
+	int dirFd;
 	dassert(devPt);
 	if (device_close_event(devPt))
 		return mcr_err;
-	size = pathconf(".", _PC_PATH_MAX);
-	if (size == -1) {
+	/* Relative to the event directory, not the working directory */
+	dirFd = open(_eventPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dirFd == -1) {
 		mcr_errno(EINTR);
 		return mcr_err;
 	}
-	wd = malloc(size);
-	if (!wd) {
-		mset_error_return(ENOMEM);
-	}
 	mcr_err = 0;
-	/* Get the current working directory to return to later. */
-	ptr = getcwd(wd, size);
-	UNUSED(ptr);
-	if (chdir(_eventPath.array) == -1) {
-		mcr_errno(EINTR);
-		free(wd);
-		return mcr_err;
-	}
-
-	if (device_open_event_wd(devPt) || chdir(wd) == -1) {
-		mcr_errno(EINTR);
-		free(wd);
-		return mcr_err;
+	if (device_event_name(devPt, name, sizeof(name))) {
+		/* No sysfs or UI_GET_SYSNAME, find by device name */
+		device_open_event_scan(devPt, dirFd);
+	} else {
+		devPt->event_fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC);
+		if (devPt->event_fd == -1)
+			mcr_errno(EINTR);
 	}
-	free(wd);
+	close(dirFd);
 	return mcr_err;
 }
 
@@ -309,16 +848,48 @@ static int device_close_event(struct mcr_Device *devPt)
 	return 0;
 }
 
-static int device_open_event_wd(struct mcr_Device *devPt)
+static int device_event_name(struct mcr_Device *devPt, char *nameBuffer,
+							 size_t bufferSize)
 {
-	DIR *dirp = opendir(".");
+	char sysname[NAME_MAX + 1];
+	char path[PATH_MAX];
+	DIR *dirp;
+	struct dirent *entry;
+	dassert(devPt);
+	if (ioctl(devPt->fd, UI_GET_SYSNAME(sizeof(sysname)), sysname) < 0)
+		return errno;
+	sysname[sizeof(sysname) - 1] = '\0';
+	if (snprintf(path, sizeof(path), "%s/%s",
+				 MCR_STR(MCR_SYSFS_INPUT_PATH), sysname) >= (int)sizeof(path))
+		return ENAMETOOLONG;
+	if (!(dirp = opendir(path)))
+		return errno;
+	/* The input device directory has exactly one evdev handler. */
+	while ((entry = readdir(dirp))) {
+		if (!strncmp(entry->d_name, "event", 5)) {
+			snprintf(nameBuffer, bufferSize, "%s", entry->d_name);
+			closedir(dirp);
+			return 0;
+		}
+	}
+	closedir(dirp);
+	return ENOENT;
+}
+
+static int device_open_event_scan(struct mcr_Device *devPt, int dirFd)
+{
+	DIR *dirp;
 	struct dirent *entry;
 	bool isdev;
 	char dev_name[UINPUT_MAX_NAME_SIZE];
 	struct stat s;
+	int scanFd = dup(dirFd);
 	dassert(devPt);
-	if (dirp == NULL) {
+	/* closedir will close the duplicate */
+	if (scanFd == -1 || !(dirp = fdopendir(scanFd))) {
 		mcr_errno(EINTR);
+		if (scanFd != -1)
+			close(scanFd);
 		return mcr_err;
 	}
 	mcr_err = 0;
@@ -328,14 +899,15 @@ static int device_open_event_wd(struct mcr_Device *devPt)
 	while ((entry = readdir(dirp))) {
 		/* Ignore files without access, and do not fail with lack
 		 * of permissions */
-		if (!access(entry->d_name, R_OK)) {
-			if (stat(entry->d_name, &s) < 0) {
+		if (!faccessat(dirFd, entry->d_name, R_OK, 0)) {
+			if (fstatat(dirFd, entry->d_name, &s, 0) < 0) {
 				mset_error(errno);
 				continue;
 			}
 			/* Our uinput devices are always char devices. */
 			if (S_ISCHR(s.st_mode)) {
-				devPt->event_fd = open(entry->d_name, O_RDONLY);
+				devPt->event_fd = openat(dirFd, entry->d_name,
+										 O_RDONLY | O_CLOEXEC);
 				if (devPt->event_fd == -1) {
 					mset_error(errno);
 					continue;
@@ -383,58 +955,74 @@ static bool device_is_event_me(struct mcr_Device *devPt,
 	return !strncmp(nameBuffer, devPt->device.name, UINPUT_MAX_NAME_SIZE);
 }
 
-static int device_write_bits(struct mcr_Device *devPt, int setBit,
-							 struct mcr_Array *bits)
+static const struct _bit_type *bit_type(int setBit)
 {
-	int fd = devPt->fd;
-	char *itPt, *end;
-	size_t bytes;
-	dassert(devPt);
-	dassert(bits);
-	if (!bits->used)
-		return 0;
-	mcr_Array_iter(bits, &itPt, &end, &bytes);
-	while (itPt < end) {
-		if (ioctl(fd, setBit, *(int *)itPt) < 0) {
-			mcr_errno(EINTR);
-			return mcr_err;
-		}
-		itPt += bytes;
+	size_t i;
+	for (i = 0; i < arrlen(_bitTypes); i++) {
+		if (_bitTypes[i].set_bit == setBit)
+			return _bitTypes + i;
 	}
-	return 0;
+	return NULL;
 }
 
-static int device_write_evbit(struct mcr_Device *devPt)
+static int device_write_bits(struct mcr_Device *devPt,
+							 const struct _bit_type *typePt)
 {
-	int evbit = UI_SET_EVBIT;
-	struct mcr_Array *evbit_arr = MCR_MAP_ELEMENT(devPt->type_value_map,
-								  &evbit);
+	const unsigned char *bitArr = (unsigned char *)&devPt->capabilities +
+								  typePt->offset;
+	int byte, code;
 	dassert(devPt);
-	evbit_arr = MCR_MAP_VALUEOF(devPt->type_value_map, evbit_arr);
-	return evbit_arr
-		   && evbit_arr->used ? device_write_bits(devPt, evbit,
-				   evbit_arr) : EINVAL;
+	for (byte = 0; byte < MCR_DEVICE_BYTES(typePt->count); byte++) {
+		/* Most of a bit array is empty */
+		if (!bitArr[byte])
+			continue;
+		for (code = byte * 8; code < byte * 8 + 8; code++) {
+			if (MCR_DEVICE_ISSET(bitArr, code)
+				&& ioctl(devPt->fd, typePt->set_bit, code) < 0) {
+				mcr_errno(EINTR);
+				return mcr_err;
+			}
+		}
+	}
+	return 0;
 }
 
-static int device_write_non_evbit(struct mcr_Device *devPt)
+static int device_setup(struct mcr_Device *devPt)
 {
+	struct uinput_setup setup;
+	struct uinput_abs_setup absSetup;
+	int i;
 	dassert(devPt);
-	int evBit;
-	struct mcr_Array *evbitArr;
-	char *itPt, *end;
-	size_t bytes;
-	/* All non-evbits. */
-	if (!devPt->type_value_map.set.used)
-		mset_error_return(EINVAL);
-	mcr_Map_iter(&devPt->type_value_map, &itPt, &end, &bytes);
-	while (itPt < end) {
-		evBit = *(int *)itPt;
-		if (evBit != UI_SET_EVBIT) {
-			evbitArr = MCR_MAP_VALUEOF(devPt->type_value_map, itPt);
-			if (device_write_bits(devPt, evBit, evbitArr))
-				return mcr_err;
+	memset(&setup, 0, sizeof(setup));
+	setup.id = devPt->device.id;
+	memcpy(setup.name, devPt->device.name, UINPUT_MAX_NAME_SIZE);
+	setup.ff_effects_max = devPt->device.ff_effects_max;
+	if (ioctl(devPt->fd, UI_DEV_SETUP, &setup) < 0) {
+		/* uinput before version 5, write the whole device instead */
+		if (errno != EINVAL && errno != ENOTTY) {
+			mcr_errno(EINTR);
+			return mcr_err;
+		}
+		if (write(devPt->fd, &devPt->device, sizeof(devPt->device)) !=
+			sizeof(devPt->device)) {
+			mcr_errno(EINTR);
+			return mcr_err;
+		}
+		return 0;
+	}
+	memset(&absSetup, 0, sizeof(absSetup));
+	for (i = 0; i < ABS_CNT; i++) {
+		if (!MCR_DEVICE_ISSET(devPt->capabilities.abs, i))
+			continue;
+		absSetup.code = i;
+		absSetup.absinfo.minimum = devPt->device.absmin[i];
+		absSetup.absinfo.maximum = devPt->device.absmax[i];
+		absSetup.absinfo.fuzz = devPt->device.absfuzz[i];
+		absSetup.absinfo.flat = devPt->device.absflat[i];
+		if (ioctl(devPt->fd, UI_ABS_SETUP, &absSetup) < 0) {
+			mcr_errno(EINTR);
+			return mcr_err;
 		}
-		itPt += bytes;
 	}
 	return 0;
 }
@@ -449,111 +1037,110 @@ static int device_create(struct mcr_Device *devPt)
 	return 0;
 }
 
-static inline int gen_dev_set(int arr[], size_t count, int uibit)
+static int device_profile(struct mcr_Device *devPt, const char *name,
+						  const struct mcr_DeviceCapabilities *profilePt)
 {
-	return mcr_Device_set_bits(&mcr_genDev, uibit, arr, count);
+	if (mcr_Device_init(devPt))
+		return mcr_err;
+	snprintf(devPt->device.name, UINPUT_MAX_NAME_SIZE, "%s", name);
+	devPt->device.id.bustype = BUS_VIRTUAL;
+	devPt->device.id.vendor = 1;
+	devPt->device.id.product = 1;
+	devPt->device.id.version = 1;
+	devPt->capabilities = *profilePt;
+	return 0;
 }
 
-static int genDevice_init()
+/* Devices of one output, named by output after the first */
+static int output_init(struct mcr_standard_platform *platformPt,
+					   struct mcr_Device *genPt, struct mcr_Device *absPt,
+					   unsigned int output)
 {
-	int i, err = 0;
-	int evbits[KEY_CNT];
-	int uibits[] = {
-		EV_SYN, EV_KEY, EV_REL, EV_MSC, EV_SND, EV_REP
-	};
-	/* Does not handle abs, sw, led, ff, ff_status */
-	for (i = 0; i < KEY_CNT; i++) {
-		evbits[i] = i;
+	char name[UINPUT_MAX_NAME_SIZE];
+	int i;
+	if (output)
+		snprintf(name, sizeof(name), "libmacro-gen-%u", output);
+	if (device_profile(genPt, output ? name : "libmacro-gen", &_genProfile))
+		return mcr_err;
+	if (output)
+		snprintf(name, sizeof(name), "libmacro-abs-%u", output);
+	if (device_profile(absPt, output ? name : "libmacro-abs", &_absProfile)) {
+		mcr_Device_deinit(genPt);
+		return mcr_err;
 	}
-
-	mcr_Device_init(&mcr_genDev);
-
-	snprintf(mcr_genDev.device.name, UINPUT_MAX_NAME_SIZE, "libmacro-gen");
-
-	mcr_genDev.device.id.bustype = BUS_VIRTUAL;
-	mcr_genDev.device.id.vendor = 1;
-	mcr_genDev.device.id.product = 1;
-	mcr_genDev.device.id.version = 1;
-
-	if ((err = gen_dev_set(uibits, arrlen(uibits), UI_SET_EVBIT)))
-		return err;
-	/* Do not write 0 value */
-	if ((err = gen_dev_set(evbits + 1, KEY_CNT - 1, UI_SET_KEYBIT)))
-		return err;
-	if ((err = gen_dev_set(evbits, REL_CNT, UI_SET_RELBIT)))
-		return err;
-	if ((err = gen_dev_set(evbits, MSC_CNT, UI_SET_MSCBIT)))
-		return err;
-	if ((err = gen_dev_set(evbits, SND_CNT, UI_SET_SNDBIT)))
-		return err;
-	/* On-screen pointer and mapped directly to screen coordinates */
-	evbits[0] = INPUT_PROP_POINTER;
-	evbits[1] = INPUT_PROP_DIRECT;
-	return gen_dev_set(evbits, 2, UI_SET_PROPBIT);
+	for (i = 0; i <= ABS_MISC; i++) {
+		absPt->device.absmax[i] = platformPt->abs_resolution;
+	}
+	if (platformPt->sink_type != MCR_SINK_UINPUT
+		&& (mcr_Device_set_sink(genPt, platformPt->sink_type,
+								platformPt->sink_capacity)
+			|| mcr_Device_set_sink(absPt, platformPt->sink_type,
+								   platformPt->sink_capacity))) {
+		mcr_Device_deinit(genPt);
+		mcr_Device_deinit(absPt);
+		return mcr_err;
+	}
+	return 0;
 }
 
-static int absDevice_init()
+/* Enable devices of an added output at first use. */
+static void output_create(struct mcr_standard_platform *platformPt,
+						  struct mcr_OutputDevice *outPt)
 {
-	int i, err = 0;
-	int evbits[] = { EV_SYN, EV_KEY, EV_ABS };
-	int absbits[ABS_MISC + 1];
-	mcr_Device_init(&mcr_absDev);
-
-	snprintf(mcr_absDev.device.name, UINPUT_MAX_NAME_SIZE, "libmacro-abs");
-
-	mcr_absDev.device.id.bustype = BUS_VIRTUAL;
-	mcr_absDev.device.id.vendor = 1;
-	mcr_absDev.device.id.product = 1;
-	mcr_absDev.device.id.version = 1;
-
-	for (i = 0; i <= ABS_MISC; i++) {
-		mcr_absDev.device.absmax[i] = mcr_abs_resolution;
+	if (mtx_lock(&platformPt->lock) != thrd_success)
+		return;
+	if (!outPt->created) {
+		if (!access(_uinputPath, W_OK | R_OK)) {
+			if (mcr_Device_enable(outPt->gen, true)
+				|| mcr_Device_enable(outPt->abs, true)) {
+				dmsg;
+			}
+		}
+		outPt->created = true;
 	}
+	mtx_unlock(&platformPt->lock);
+}
 
-	if ((err = mcr_Device_set_bits(&mcr_absDev, UI_SET_EVBIT, evbits, 3)))
-		return err;
-	/* Not used, but required to be set up correctly */
-	evbits[0] = BTN_LEFT;
-	if ((err = mcr_Device_set_bits(&mcr_absDev, UI_SET_KEYBIT, evbits, 1)))
-		return err;
-	/* On-screen pointer and mapped directly to screen coordinates */
-	evbits[0] = INPUT_PROP_POINTER;
-	evbits[1] = INPUT_PROP_DIRECT;
-	if ((err = mcr_Device_set_bits(&mcr_absDev, UI_SET_PROPBIT, evbits, 2)))
-		return err;
-	for (i = 0; i <= ABS_MISC; i++) {
-		absbits[i] = i;
-	}
+static void output_free(struct mcr_OutputDevice *outPt)
+{
+	struct _output *pt = (struct _output *)outPt;
+	mcr_Device_deinit(&pt->gen);
+	mcr_Device_deinit(&pt->abs);
+	free(pt);
+}
 
-	if ((err = mcr_Device_set_bits(&mcr_absDev, UI_SET_ABSBIT, absbits,
-								   ABS_MISC + 1))) {
-		return err;
-	}
-	return err;
+static int set_path(char *buffer, const char *path)
+{
+	if (!path || path[0] == '\0')
+		return ENODEV;
+	if (strlen(path) >= PATH_MAX)
+		mset_error_return(ENAMETOOLONG);
+	strcpy(buffer, path);
+	return 0;
 }
 
 int mcr_Device_initialize(struct mcr_context *context)
 {
-	int mtxErr = mtx_init(&_deviceLock, mtx_plain);
-	UNUSED(context);
+	struct mcr_standard_platform *platformPt = context->standard.platform;
+	int mtxErr = mtx_init(&platformPt->lock, mtx_plain);
 	if (mtxErr != thrd_success) {
 		mtxErr = mcr_thrd_errno(mtxErr);
 		mset_error_return(mtxErr);
 	}
-	mcr_String_init(&_uinputPath);
-	mcr_String_init(&_eventPath);
-	if (mcr_String_replace(&_uinputPath, MCR_STR(MCR_UINPUT_PATH)))
-		return mcr_err;
-	if (mcr_String_replace(&_eventPath, MCR_STR(MCR_EVENT_PATH)))
-		return mcr_err;
+	platformPt->abs_resolution = MCR_ABS_RESOLUTION;
+	platformPt->default_output.gen = &platformPt->gen_dev;
+	platformPt->default_output.abs = &platformPt->abs_dev;
+	platformPt->default_output.created = true;
+	platformPt->outputs[0] = &platformPt->default_output;
+	platformPt->output_count = 1;
 	/* ioctl is unpredictable for valgrind. The first ioctl will
 	 * be uninitialized, and others should not cause errors. */
-	if (genDevice_init())
-		return mcr_err;
-	if (absDevice_init())
+	if (output_init(platformPt, &platformPt->gen_dev, &platformPt->abs_dev,
+					0)) {
 		return mcr_err;
-	if (!access(MCR_STR(MCR_UINPUT_PATH), W_OK | R_OK)) {
-		if (mcr_Device_enable_all(true))
+	}
+	if (!access(_uinputPath, W_OK | R_OK)) {
+		if (mcr_Device_enable_all(context, true))
 			return mcr_err;
 	}
 	return 0;
@@ -561,11 +1148,13 @@ int mcr_Device_initialize(struct mcr_context *context)
 
 int mcr_Device_deinitialize(struct mcr_context *context)
 {
-	UNUSED(context);
-	mcr_Device_deinit(&mcr_genDev);
-	mcr_Device_deinit(&mcr_absDev);
-	mcr_Array_deinit(&_uinputPath);
-	mcr_Array_deinit(&_eventPath);
-	mtx_destroy(&_deviceLock);
+	struct mcr_standard_platform *platformPt = context->standard.platform;
+	while (platformPt->output_count > 1) {
+		output_free(platformPt->outputs[--platformPt->output_count]);
+		platformPt->outputs[platformPt->output_count] = NULL;
+	}
+	mcr_Device_deinit(&platformPt->gen_dev);
+	mcr_Device_deinit(&platformPt->abs_dev);
+	mtx_destroy(&platformPt->lock);
 	return 0;
 }
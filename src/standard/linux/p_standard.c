@@ -21,163 +21,238 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-MCR_API struct mcr_Array mcr_echoEvents;
-MCR_API struct mcr_Map mcr_keyToEcho[2];
-MCR_API mcr_SpacePosition mcr_cursor = { 0 };
-
-static size_t _initialize_count = 0;
+#include "mcr/libmacro.h"
+#include "mcr/util/atomic.h"
 
 static int mcr_Modifier_load_key_contract(struct mcr_context *ctx);
 static int add_key_names(struct mcr_context *context);
-static int add_echo_keys(void);
+static int add_echo_keys(struct mcr_context *ctx);
 static int add_echo_names(struct mcr_context *context);
+static int key_send(const struct mcr_Key *keyPt, struct mcr_Device *devPt);
+
+void mcr_cursor_position(struct mcr_context *ctx, mcr_SpacePosition buffer)
+{
+	struct mcr_standard_platform *platformPt = ctx->standard.platform;
+	struct mcr_CursorState *curPt = &platformPt->cursor;
+	size_t seq;
+	int i;
+	do {
+		/* Wait for the writer to finish */
+		while ((seq = mcr_atomic_load(&curPt->sequence)) & 1)
+			thrd_yield();
+		for (i = MCR_DIMENSION_CNT; i--;)
+			buffer[i] = __atomic_load_n(curPt->pos + i, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while (__atomic_load_n(&curPt->sequence, __ATOMIC_RELAXED) != seq);
+}
 
-void mcr_cursor_position(mcr_SpacePosition buffer)
+void mcr_cursor_apply(struct mcr_context *ctx,
+					  const struct mcr_MoveCursor *mcPt)
 {
+	struct mcr_standard_platform *platformPt = ctx->standard.platform;
+	struct mcr_CursorState *curPt = &platformPt->cursor;
+	__s32 resolution = platformPt->abs_resolution;
+	long long value;
+	size_t seq;
 	int i;
-	for (i = MCR_DIMENSION_CNT; i--;)
-		buffer[i] = mcr_cursor[i];
+	/* Odd sequence to own the position, full barrier before writing */
+	for (;;) {
+		seq = mcr_atomic_load(&curPt->sequence);
+		if (!(seq & 1) && mcr_atomic_cas(&curPt->sequence, seq, seq + 1))
+			break;
+		thrd_yield();
+	}
+	for (i = MCR_DIMENSION_CNT; i--;) {
+		value = mcPt->pos[i];
+		if (mcPt->is_justify) {
+			value += __atomic_load_n(curPt->pos + i, __ATOMIC_RELAXED);
+			if (value > resolution) {
+				value = resolution;
+			} else if (value < 0) {
+				value = 0;
+			}
+		}
+		__atomic_store_n(curPt->pos + i, value, __ATOMIC_RELAXED);
+	}
+	mcr_atomic_store(&curPt->sequence, seq + 2);
 }
 
-int mcr_Echo_set_key(size_t echoCode, struct mcr_Key *keyPt)
+int mcr_Echo_set_key(struct mcr_context *ctx, size_t echoCode,
+					 struct mcr_Key *keyPt)
 {
-	int kVal;
+	struct mcr_standard_platform *platformPt = ctx->standard.platform;
 	struct mcr_Key initial = { 0 };
-	struct mcr_Map *mapPt;
 	dassert(keyPt);
-	if (echoCode == MCR_ECHO_ANY)
+	if (echoCode == MCR_ECHO_ANY || keyPt->key < 0 || keyPt->key >= KEY_CNT)
 		mset_error_return(EINVAL);
-	if (mcr_Array_minfill(&mcr_echoEvents, echoCode + 1, &initial)
-		|| mcr_Array_set(&mcr_echoEvents, echoCode, keyPt)) {
+	if (mcr_Array_minfill(&platformPt->echo_events, echoCode + 1, &initial)
+		|| mcr_Array_set(&platformPt->echo_events, echoCode, keyPt)) {
 		return mcr_err;
 	}
-	mapPt = mcr_keyToEcho + (keyPt->apply ? 1 : 0);
-	kVal = keyPt->key;
-	return mcr_Map_map(mapPt, &kVal, &echoCode);
+	platformPt->key_echo[keyPt->apply == MCR_SET ? 0 : 1][keyPt->key] =
+		echoCode;
+	return 0;
 }
 
-int mcr_HidEcho_send_data(struct mcr_HidEcho *echoPt)
+int mcr_HidEcho_send_data(struct mcr_context *ctx, struct mcr_HidEcho *echoPt)
 {
-	if (echoPt->echo < mcr_echoEvents.used) {
-		if (mcr_Key_send_data((struct mcr_Key *)
-							  MCR_ARR_ELEMENT(mcr_echoEvents,
-											  echoPt->echo))) {
-			return mcr_err;
-		}
-		mcr_err = 0;
-	} else {
+	const struct mcr_Key *keyPt = mcr_Echo_key(ctx->standard.platform,
+								  echoPt->echo);
+	if (!keyPt)
 		mset_error_return(EFAULT);
-	}
+	if (key_send(keyPt, mcr_output_routed(ctx, MCR_OUTPUT_HID_ECHO)->gen))
+		return mcr_err;
+	mcr_err = 0;
 	return 0;
 }
 
-int mcr_Key_send_data(struct mcr_Key *keyPt)
+int mcr_Key_send_data(struct mcr_context *ctx, struct mcr_Key *keyPt)
+{
+	return key_send(keyPt, mcr_output_routed(ctx, MCR_OUTPUT_KEY)->gen);
+}
+
+static int key_send(const struct mcr_Key *keyPt, struct mcr_Device *devPt)
 {
-	struct input_event events[2] = { 0 };
-	int err;
-	events[0].type = EV_KEY;
-	events[0].code = keyPt->key;
-	events[1].type = EV_SYN;
-	events[1].code = SYN_REPORT;
+	struct input_event events[4] = { 0 };
+	size_t count = 0;
+	/* Press and release together in one write */
 	if (keyPt->apply != MCR_UNSET) {
-		events[0].value = 1;
-		err = MCR_DEV_SEND(mcr_genDev, events, sizeof(events));
-		if (err == -1)
-			mset_error_return(EINTR);
-		mcr_err = 0;
+		events[count].type = EV_KEY;
+		events[count].code = keyPt->key;
+		events[count++].value = 1;
+		events[count].type = EV_SYN;
+		events[count++].code = SYN_REPORT;
 	}
 	if (keyPt->apply != MCR_SET) {
-		events[0].value = 0;
-		err = MCR_DEV_SEND(mcr_genDev, events, sizeof(events));
-		if (err == -1)
-			mset_error_return(EINTR);
-		mcr_err = 0;
+		events[count].type = EV_KEY;
+		events[count++].code = keyPt->key;
+		events[count].type = EV_SYN;
+		events[count++].code = SYN_REPORT;
 	}
-	return 0;
+	return mcr_Device_send(devPt, events, count);
 }
 
-static inline void localJustify(struct mcr_MoveCursor *mcPt, int pos)
+int mcr_MoveCursor_send_data(struct mcr_context *ctx,
+							 struct mcr_MoveCursor *mcPt)
 {
-	mcr_cursor[pos] += mcPt->pos[pos];
-	if (mcr_cursor[pos] > mcr_abs_resolution) {
-		mcr_cursor[pos] = mcr_abs_resolution;
-	} else if (mcr_cursor[pos] < 0) {
-		mcr_cursor[pos] = 0;
+	const int relCodes[] = { REL_X, REL_Y, REL_Z };
+	const int absCodes[] = { ABS_X, ABS_Y, ABS_Z };
+	struct input_event events[MCR_DIMENSION_CNT + 1] = { 0 };
+	struct mcr_OutputDevice *outPt = mcr_output_routed(ctx,
+									 MCR_OUTPUT_MOVE_CURSOR);
+	size_t count = 0;
+	int i;
+	for (i = 0; i < MCR_DIMENSION_CNT; i++) {
+		/* No relative movement is not written. */
+		if (mcPt->is_justify && !mcPt->pos[i])
+			continue;
+		events[count].type = mcPt->is_justify ? EV_REL : EV_ABS;
+		events[count].code = mcPt->is_justify ? relCodes[i] : absCodes[i];
+		events[count++].value = mcPt->pos[i];
+	}
+	if (count) {
+		events[count].type = EV_SYN;
+		events[count++].code = SYN_REPORT;
+		if (mcr_Device_send(mcPt->is_justify ? outPt->gen : outPt->abs,
+							events, count)) {
+			return mcr_err;
+		}
 	}
+	mcr_cursor_apply(ctx, mcPt);
+	return 0;
 }
 
-int mcr_MoveCursor_send_data(struct mcr_MoveCursor *mcPt)
+/* Detents at or below a high resolution wheel total, rounded toward
+ * negative infinity so crossing zero counts the same as other detents. */
+static inline long long wheel_detents(long long total)
 {
-	int err;
-	struct input_event events[MCR_DIMENSION_CNT + 1] = { 0 };
-	events[MCR_X].value = mcPt->pos[MCR_X];
-	events[MCR_Y].value = mcPt->pos[MCR_Y];
-	events[MCR_Z].value = mcPt->pos[MCR_Z];
-	events[MCR_DIMENSION_CNT].type = EV_SYN;
-	events[MCR_DIMENSION_CNT].code = SYN_REPORT;
-	if (mcPt->is_justify) {
-		events[0].type = events[1].type = events[2].type = EV_REL;
-		events[MCR_X].code = REL_X;
-		events[MCR_Y].code = REL_Y;
-		events[MCR_Z].code = REL_Z;
-		err = MCR_DEV_SEND(mcr_genDev, events, sizeof(events));
-		if (err == -1)
-			mset_error_return(EINTR);
-		localJustify(mcPt, MCR_X);
-		localJustify(mcPt, MCR_Y);
-		localJustify(mcPt, MCR_Z);
+	return total / MCR_WHEEL_HI_RES - (total % MCR_WHEEL_HI_RES < 0);
+}
+
+/* High resolution and detent events of one wheel axis
+ * \return Number of events */
+static size_t wheel_events(struct mcr_standard_platform *platformPt,
+						   struct input_event *events, int axis, long long value)
+{
+	const int codes[] = { REL_HWHEEL, REL_WHEEL };
+	const int hiResCodes[] = { REL_HWHEEL_HI_RES, REL_WHEEL_HI_RES };
+	long long hiRes = value, detents = value, previous;
+	size_t count = 0;
+	if (platformPt->scroll_hi_res) {
+		/* Detents crossed by all scrolling, so partial detents of
+		 * concurrent senders still add up. */
+		previous = __atomic_fetch_add(platformPt->wheel_total + axis, value,
+									  __ATOMIC_RELAXED);
+		detents = wheel_detents(previous + value) - wheel_detents(previous);
 	} else {
-		events[0].type = events[1].type = events[2].type = EV_ABS;
-		events[MCR_X].code = ABS_X;
-		events[MCR_Y].code = ABS_Y;
-		events[MCR_Z].code = ABS_Z;
-		err = MCR_DEV_SEND(mcr_absDev, events, sizeof(events));
-		if (err == -1)
-			mset_error_return(EINTR);
-		mcr_cursor[MCR_X] = mcPt->pos[MCR_X];
-		mcr_cursor[MCR_Y] = mcPt->pos[MCR_Y];
-		mcr_cursor[MCR_Z] = mcPt->pos[MCR_Z];
+		hiRes *= MCR_WHEEL_HI_RES;
 	}
-	return 0;
+	events[count].type = EV_REL;
+	events[count].code = hiResCodes[axis];
+	events[count++].value = hiRes;
+	if (detents) {
+		events[count].type = EV_REL;
+		events[count].code = codes[axis];
+		events[count++].value = detents;
+	}
+	return count;
 }
 
-int mcr_Scroll_send_data(struct mcr_Scroll *scrPt)
+int mcr_Scroll_send_data(struct mcr_context *ctx, struct mcr_Scroll *scrPt)
 {
-	int err;
-	struct input_event events[MCR_DIMENSION_CNT + 1] = { 0 };
-	events[0].type = events[1].type = events[2].type = EV_REL;
-	events[MCR_X].code = REL_HWHEEL;
-	events[MCR_Y].code = REL_WHEEL;
-	events[MCR_Z].code = REL_DIAL;
-	events[MCR_X].value = scrPt->dm[MCR_X];
-	events[MCR_Y].value = scrPt->dm[MCR_Y];
-	events[MCR_Z].value = scrPt->dm[MCR_Z];
-	events[MCR_DIMENSION_CNT].type = EV_SYN;
-	events[MCR_DIMENSION_CNT].code = SYN_REPORT;
-	err = MCR_DEV_SEND(mcr_genDev, events, sizeof(events));
-	if (err == -1)
-		mset_error_return(EINTR);
-	return 0;
+	struct input_event events[MCR_DIMENSION_CNT * 2 + 1] = { 0 };
+	size_t count = 0;
+	int i;
+	for (i = MCR_X; i <= MCR_Y; i++) {
+		if (scrPt->dm[i]) {
+			count += wheel_events(ctx->standard.platform, events + count, i,
+								  scrPt->dm[i]);
+		}
+	}
+	if (scrPt->dm[MCR_Z]) {
+		events[count].type = EV_REL;
+		events[count].code = REL_DIAL;
+		events[count++].value = scrPt->dm[MCR_Z];
+	}
+	/* No scrolling is not written. */
+	if (!count)
+		return 0;
+	events[count].type = EV_SYN;
+	events[count++].code = SYN_REPORT;
+	return mcr_Device_send(mcr_output_routed(ctx, MCR_OUTPUT_SCROLL)->gen,
+						   events, count);
+}
+
+bool mcr_Scroll_is_hi_res(struct mcr_context *ctx)
+{
+	return ((struct mcr_standard_platform *)
+			ctx->standard.platform)->scroll_hi_res;
+}
+
+void mcr_Scroll_set_hi_res(struct mcr_context *ctx, bool enable)
+{
+	((struct mcr_standard_platform *)
+	 ctx->standard.platform)->scroll_hi_res = enable;
 }
 
 int mcr_standard_platform_initialize(struct mcr_context *context)
 {
-	UNUSED(context);
-	if (_initialize_count) {
-		++_initialize_count;
-		return 0;
+	struct mcr_standard_platform *platformPt = malloc(sizeof(
+				struct mcr_standard_platform));
+	int i;
+	if (!platformPt)
+		mset_error_return(ENOMEM);
+	memset(platformPt, 0, sizeof(struct mcr_standard_platform));
+	context->standard.platform = platformPt;
+	mcr_Array_init(&platformPt->echo_events);
+	platformPt->echo_events.element_size = sizeof(struct mcr_Key);
+	for (i = KEY_CNT; i--;) {
+		platformPt->key_echo[0][i] = platformPt->key_echo[1][i] =
+										 MCR_ECHO_ANY;
 	}
-	++_initialize_count;
-	mcr_Array_init(&mcr_echoEvents);
-	mcr_echoEvents.element_size = sizeof(struct mcr_Key);
-	mcr_Map_init(mcr_keyToEcho);
-	mcr_Map_set_all(mcr_keyToEcho, sizeof(int), sizeof(size_t),
-					mcr_int_compare, NULL, NULL);
-	mcr_Map_init(mcr_keyToEcho + 1);
-	mcr_Map_set_all(mcr_keyToEcho + 1, sizeof(int), sizeof(size_t),
-					mcr_int_compare, NULL, NULL);
 	if (mcr_Device_initialize(context))
 		return mcr_err;
 	return mcr_Modifier_load_key_contract(context);
@@ -185,15 +260,14 @@ int mcr_standard_platform_initialize(struct mcr_context *context)
 
 int mcr_standard_platform_deinitialize(struct mcr_context *context)
 {
-	UNUSED(context);
-	/* Remove an initialized reference of internal modifiers */
-	if (!_initialize_count || --_initialize_count)
+	struct mcr_standard_platform *platformPt = context->standard.platform;
+	if (!platformPt)
 		return 0;
 	if (mcr_Device_deinitialize(context))
 		return mcr_err;
-	mcr_Array_deinit(&mcr_echoEvents);
-	mcr_Map_deinit(mcr_keyToEcho);
-	mcr_Map_deinit(mcr_keyToEcho + 1);
+	mcr_Array_deinit(&platformPt->echo_events);
+	free(platformPt);
+	context->standard.platform = NULL;
 	return 0;
 }
 
@@ -201,7 +275,7 @@ int mcr_standard_platform_load_contract(struct mcr_context *ctx)
 {
 	if (add_key_names(ctx))
 		return mcr_err;
-	if (add_echo_keys())
+	if (add_echo_keys(ctx))
 		return mcr_err;
 	return add_echo_names(ctx);
 }
@@ -514,7 +588,7 @@ static int add_key_names(struct mcr_context *context)
 	return 0;
 }
 
-static int add_echo_keys()
+static int add_echo_keys(struct mcr_context *ctx)
 {
 	const int echokeys[] = {
 		BTN_0, BTN_1, BTN_2, BTN_3, BTN_4, BTN_5, BTN_6, BTN_7,
@@ -533,10 +607,10 @@ static int add_echo_keys()
 	for (i = 0; i < count; i++) {
 		k.key = echokeys[i];
 		k.apply = MCR_SET;
-		if ((ret = mcr_Echo_set_key(echoCode++, &k)))
+		if ((ret = mcr_Echo_set_key(ctx, echoCode++, &k)))
 			return ret;
 		k.apply = MCR_UNSET;
-		if ((ret = mcr_Echo_set_key(echoCode++, &k)))
+		if ((ret = mcr_Echo_set_key(ctx, echoCode++, &k)))
 			return ret;
 	}
 	return 0;
@@ -34,7 +34,8 @@ int mcr_MoveCursor_send(struct mcr_Signal *sigPt)
 {
 	dassert(sigPt);
 	mcr_MC *mcPt = mcr_MC_data(sigPt);
-	return mcPt ? mcr_MoveCursor_send_data(mcPt) : 0;
+	return mcPt ? mcr_MoveCursor_send_data(
+			   sigPt->isignal->interface.context, mcPt) : 0;
 }
 
 bool mcr_resembles(const struct mcr_MoveCursor * lhs,
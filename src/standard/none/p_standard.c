@@ -19,9 +19,60 @@
 #include "mcr/signal/none/p_signal.h"
 #include "mcr/signal/signal.h"
 
-void mcr_cursor_position(mcr_SpacePosition buffer)
+void mcr_cursor_position(struct mcr_context *ctx, mcr_SpacePosition buffer)
 {
-	memcpy(buffer, mcr_cursor, sizeof(mcr_SpacePosition));
+	UNUSED(ctx);
+	memset(buffer, 0, sizeof(mcr_SpacePosition));
+}
+
+void mcr_output_begin(bool mergeFrames)
+{
+	UNUSED(mergeFrames);
+}
+
+int mcr_output_flush(void)
+{
+	return 0;
+}
+
+int mcr_output_end(void)
+{
+	return 0;
+}
+
+bool mcr_output_is_buffering(void)
+{
+	return false;
+}
+
+/* All input is sent to the one system output. */
+int mcr_output_add(struct mcr_context *ctx, unsigned int *outputPt)
+{
+	UNUSED(ctx);
+	UNUSED(outputPt);
+	mset_error_return(ENOTSUP);
+}
+
+unsigned int mcr_output_count(struct mcr_context *ctx)
+{
+	UNUSED(ctx);
+	return 1;
+}
+
+int mcr_output_set_signal_route(struct mcr_context *ctx,
+								struct mcr_ISignal *isigPt, unsigned int output)
+{
+	UNUSED(ctx);
+	UNUSED(isigPt);
+	if (output)
+		mset_error_return(ENOENT);
+	return 0;
+}
+
+unsigned int mcr_output_set_thread_route(unsigned int output)
+{
+	UNUSED(output);
+	return 0;
 }
 
 int mcr_standard_platform_initialize()
@@ -40,12 +40,15 @@ int mcr_NoOp_send_data(struct mcr_NoOp *noopPt)
 	struct timespec val;
 	if (!noopPt)
 		return 0;
+	/* Buffered events are sent before a delay. */
+	if ((noopPt->sec || noopPt->msec) && mcr_output_flush())
+		return mcr_err;
 	// # seconds contained in msec
 	val.tv_sec = noopPt->sec + noopPt->msec / 1000;
 	// # nanoseconds in msec, not including seconds left over
 	val.tv_nsec = (noopPt->msec % 1000) * 1000000;
-	thrd_sleep(&val, NULL);
-	return 0;
+	/* Cancellation point if sending from a macro */
+	return mcr_Macro_sleep(&val);
 }
 
 struct mcr_ISignal *mcr_iNoOp(struct mcr_context *ctx)
@@ -0,0 +1,288 @@
+/* Libmacro - A multi-platform, extendable macro and hotkey C library
+  Copyright (C) 2013 Jonathan Pelletier, New Paradigm Software
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "mcr/standard/standard.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mcr/libmacro.h"
+#include "mcr/util/atomic.h"
+
+static void monotonic_now(struct timespec *timePt)
+{
+#ifdef CLOCK_MONOTONIC
+	clock_gettime(CLOCK_MONOTONIC, timePt);
+#else
+	timespec_get(timePt, TIME_UTC);
+#endif
+}
+
+/* Milliseconds from first to second, 0 if second is earlier. */
+static long long elapsed_msec(const struct timespec *first,
+							  const struct timespec *second)
+{
+	long long msec = (long long)(second->tv_sec - first->tv_sec) * 1000 +
+					 (second->tv_nsec - first->tv_nsec) / 1000000;
+	return msec > 0 ? msec : 0;
+}
+
+static void reset_sequence(struct mcr_Recorder *recPt)
+{
+	size_t i;
+	for (i = 0; i < recPt->capacity; i++) {
+		recPt->ring[i].sequence = i;
+	}
+	recPt->head = recPt->tail = recPt->dropped = 0;
+}
+
+int mcr_Recorder_init(void *recPt)
+{
+	struct mcr_Recorder *localPt = recPt;
+	if (!localPt)
+		return 0;
+	memset(localPt, 0, sizeof(struct mcr_Recorder));
+	localPt->min_delay_msec = MCR_RECORDER_MIN_DELAY;
+	return 0;
+}
+
+int mcr_Recorder_deinit(void *recPt)
+{
+	struct mcr_Recorder *localPt = recPt;
+	if (!localPt)
+		return 0;
+	if (localPt->recording && mcr_Recorder_set_enabled(localPt, false))
+		return mcr_err;
+	free(localPt->ring);
+	localPt->ring = NULL;
+	localPt->capacity = 0;
+	return 0;
+}
+
+int mcr_Recorder_set_all(struct mcr_Recorder *recPt,
+						 struct mcr_context *ctx, size_t capacity)
+{
+	size_t roundCap = 1;
+	struct mcr_RecordEvent *ringPt;
+	dassert(recPt);
+	dassert(ctx);
+	if (recPt->recording)
+		mset_error_return(EBUSY);
+	if (!capacity)
+		capacity = MCR_RECORDER_CAPACITY;
+	while (roundCap < capacity) {
+		roundCap <<= 1;
+		if (!roundCap)
+			mset_error_return(EINVAL);
+	}
+	if (roundCap != recPt->capacity) {
+		ringPt = malloc(roundCap * sizeof(struct mcr_RecordEvent));
+		if (!ringPt)
+			mset_error_return(ENOMEM);
+		free(recPt->ring);
+		recPt->ring = ringPt;
+		recPt->capacity = roundCap;
+	}
+	recPt->ctx = ctx;
+	reset_sequence(recPt);
+	return 0;
+}
+
+int mcr_Recorder_set_enabled(struct mcr_Recorder *recPt, bool enable)
+{
+	dassert(recPt);
+	if (enable == recPt->recording)
+		return 0;
+	if (enable) {
+		if (!recPt->ctx || !recPt->ring)
+			mset_error_return(EINVAL);
+		if (mcr_Dispatcher_add_generic(recPt->ctx, NULL, recPt,
+									   mcr_Recorder_receive)) {
+			return mcr_err;
+		}
+		mcr_Dispatcher_set_enabled(recPt->ctx, NULL, true);
+		recPt->recording = true;
+	} else {
+		recPt->recording = false;
+		if (mcr_Dispatcher_remove(recPt->ctx, NULL, recPt))
+			return mcr_err;
+	}
+	return 0;
+}
+
+bool mcr_Recorder_receive(void *recPt, struct mcr_Signal *sigPt,
+						  unsigned int mods)
+{
+	struct mcr_Recorder *localPt = recPt;
+	struct mcr_standard *stdPt;
+	struct mcr_RecordEvent *slotPt;
+	size_t pos, seq, dataSize;
+	void *dataPt;
+	UNUSED(mods);
+	dassert(localPt);
+	if (!localPt->recording || !sigPt || !sigPt->isignal)
+		return false;
+	stdPt = &localPt->ctx->standard;
+	if (sigPt->isignal == &stdPt->ikey) {
+		dataSize = sizeof(struct mcr_Key);
+	} else if (sigPt->isignal == &stdPt->imove_cursor) {
+		dataSize = sizeof(struct mcr_MoveCursor);
+	} else if (sigPt->isignal == &stdPt->iscroll) {
+		dataSize = sizeof(struct mcr_Scroll);
+	} else {
+		/* A HidEcho is dispatched before the Key of the same event,
+		 * and the Key alone sends that event again. */
+		return false;
+	}
+	if (!(dataPt = mcr_Instance_data(sigPt)))
+		return false;
+	/* Claim a slot that the reader has released. */
+	pos = mcr_atomic_load(&localPt->head);
+	for (;;) {
+		slotPt = localPt->ring + (pos & (localPt->capacity - 1));
+		seq = mcr_atomic_load(&slotPt->sequence);
+		if (seq == pos) {
+			if (mcr_atomic_cas(&localPt->head, pos, pos + 1))
+				break;
+			pos = mcr_atomic_load(&localPt->head);
+		} else if ((ptrdiff_t)(seq - pos) < 0) {
+			/* Full, reader has not caught up */
+			mcr_atomic_fetch_add(&localPt->dropped, 1);
+			return false;
+		} else {
+			pos = mcr_atomic_load(&localPt->head);
+		}
+	}
+	monotonic_now(&slotPt->time);
+	slotPt->isignal = sigPt->isignal;
+	memcpy(&slotPt->data, dataPt, dataSize);
+	/* Publish to reader */
+	mcr_atomic_store(&slotPt->sequence, pos + 1);
+	return false;
+}
+
+size_t mcr_Recorder_count(struct mcr_Recorder *recPt)
+{
+	dassert(recPt);
+	return mcr_atomic_load(&recPt->head) - recPt->tail;
+}
+
+size_t mcr_Recorder_dropped(struct mcr_Recorder *recPt)
+{
+	dassert(recPt);
+	return mcr_atomic_load(&recPt->dropped);
+}
+
+void mcr_Recorder_clear(struct mcr_Recorder *recPt)
+{
+	struct mcr_RecordEvent *slotPt;
+	size_t pos;
+	dassert(recPt);
+	if (!recPt->ring)
+		return;
+	/* Release every published slot back to writers. */
+	for (pos = recPt->tail;; pos++) {
+		slotPt = recPt->ring + (pos & (recPt->capacity - 1));
+		if (mcr_atomic_load(&slotPt->sequence) != pos + 1)
+			break;
+		mcr_atomic_store(&slotPt->sequence, pos + recPt->capacity);
+	}
+	recPt->tail = pos;
+	mcr_atomic_store(&recPt->dropped, 0);
+}
+
+int mcr_Recorder_to_macro(struct mcr_Recorder *recPt,
+						  struct mcr_Macro *mcrPt)
+{
+	struct mcr_RecordEvent *events = NULL, *slotPt;
+	struct mcr_Signal *signals = NULL;
+	struct mcr_NoOp *delays = NULL;
+	struct timespec last;
+	size_t i, count, pos, mask, sigCount = 0, delayCount = 0;
+	long long msec;
+	dassert(recPt);
+	dassert(mcrPt);
+	if (!recPt->ring)
+		mset_error_return(EINVAL);
+	pos = recPt->tail;
+	mask = recPt->capacity - 1;
+	memset(&last, 0, sizeof(last));
+	count = mcr_Recorder_count(recPt);
+	if (count) {
+		events = malloc(count * sizeof(struct mcr_RecordEvent));
+		/* Every signal may have a delay before it */
+		signals = malloc(count * 2 * sizeof(struct mcr_Signal));
+		delays = malloc(count * sizeof(struct mcr_NoOp));
+		if (!events || !signals || !delays) {
+			free(events);
+			free(signals);
+			free(delays);
+			mset_error_return(ENOMEM);
+		}
+	}
+	/* Copy out and release slots before building signals, so writers may
+	 * continue. Stop at the first slot still being written. */
+	for (i = 0; i < count; i++, pos++) {
+		slotPt = recPt->ring + (pos & mask);
+		if (mcr_atomic_load(&slotPt->sequence) != pos + 1)
+			break;
+		events[i] = *slotPt;
+		mcr_atomic_store(&slotPt->sequence, pos + recPt->capacity);
+	}
+	recPt->tail = pos;
+	count = i;
+	for (i = 0; i < count; i++) {
+		if (i) {
+			/* Delay from the end of the last inserted delay, so short
+			 * delays accumulate instead of being lost. */
+			msec = elapsed_msec(&last, &events[i].time);
+			if (msec >= recPt->min_delay_msec) {
+				mcr_NoOp_set_all(delays + delayCount, (int)(msec / 1000),
+								 (int)(msec % 1000));
+				mcr_Signal_init(signals + sigCount);
+				mcr_Instance_set_all(signals + sigCount,
+									 mcr_iNoOp(recPt->ctx), delays + delayCount, NULL);
+				++delayCount;
+				++sigCount;
+				last.tv_sec += (time_t)(msec / 1000);
+				last.tv_nsec += (long)(msec % 1000) * 1000000;
+				if (last.tv_nsec >= 1000000000) {
+					last.tv_nsec -= 1000000000;
+					++last.tv_sec;
+				}
+			}
+		} else {
+			last = events[i].time;
+		}
+		mcr_Signal_init(signals + sigCount);
+		mcr_Instance_set_all(signals + sigCount, events[i].isignal,
+							 &events[i].data, NULL);
+		/* Do not record, or trigger from, our own playback. */
+		signals[sigCount].is_dispatch = false;
+		++sigCount;
+	}
+	mcr_err = 0;
+	mcr_Macro_set_signals(mcrPt, signals, sigCount);
+	free(events);
+	free(signals);
+	free(delays);
+	return mcr_err;
+}
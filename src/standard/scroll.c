@@ -24,7 +24,8 @@ int mcr_Scroll_send(struct mcr_Signal *sigPt)
 {
 	dassert(sigPt);
 	struct mcr_Scroll *scrPt = mcr_Scroll_data(sigPt);
-	return scrPt ? mcr_Scroll_send_data(scrPt) : 0;
+	return scrPt ? mcr_Scroll_send_data(
+			   sigPt->isignal->interface.context, scrPt) : 0;
 }
 
 struct mcr_ISignal *mcr_iScroll(struct mcr_context *ctx)
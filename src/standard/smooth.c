@@ -0,0 +1,112 @@
+/* Libmacro - A multi-platform, extendable macro and hotkey C library
+  Copyright (C) 2013 Jonathan Pelletier, New Paradigm Software
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "mcr/standard/standard.h"
+
+#include <string.h>
+
+#include "mcr/libmacro.h"
+
+static void monotonic_now(struct timespec *timePt)
+{
+#ifdef CLOCK_MONOTONIC
+	clock_gettime(CLOCK_MONOTONIC, timePt);
+#else
+	timespec_get(timePt, TIME_UTC);
+#endif
+}
+
+/* Sleep until usec after start, interrupted with the current macro. */
+static int sleep_until(const struct timespec *start, long long usec)
+{
+	struct timespec now, wait;
+	long long nsec;
+	monotonic_now(&now);
+	nsec = (long long)(start->tv_sec - now.tv_sec) * 1000000000 +
+		   (start->tv_nsec - now.tv_nsec) + usec * 1000;
+	/* Already late, send the next frame now. */
+	if (nsec <= 0)
+		return 0;
+	wait.tv_sec = nsec / 1000000000;
+	wait.tv_nsec = nsec % 1000000000;
+	return mcr_Macro_sleep(&wait);
+}
+
+void mcr_Smooth_set_all(struct mcr_Smooth *smPt, const mcr_Dimensions dm,
+						bool isScroll, unsigned int frames, unsigned int intervalUsec)
+{
+	dassert(smPt);
+	memcpy(smPt->dm, dm, sizeof(mcr_Dimensions));
+	smPt->is_scroll = isScroll;
+	smPt->frames = frames;
+	smPt->interval_usec = intervalUsec;
+}
+
+int mcr_Smooth_send(struct mcr_Signal *sigPt)
+{
+	dassert(sigPt);
+	struct mcr_Smooth *smPt = mcr_Smooth_data(sigPt);
+	return smPt ? mcr_Smooth_send_data(
+			   sigPt->isignal->interface.context, smPt) : 0;
+}
+
+int mcr_Smooth_send_data(struct mcr_context *ctx, struct mcr_Smooth *smPt)
+{
+	unsigned int frames = smPt->frames ? smPt->frames : 1, i;
+	struct timespec start;
+	monotonic_now(&start);
+	for (i = 1; i <= frames; i++) {
+		if (mcr_Smooth_send_frame(ctx, smPt, i))
+			return mcr_err;
+		if (i == frames)
+			break;
+		/* Buffered events are sent before a delay. */
+		if (mcr_output_flush()
+			|| sleep_until(&start, (long long)smPt->interval_usec * i)) {
+			return mcr_err;
+		}
+		if (mcr_Macro_is_interrupted())
+			break;
+	}
+	return 0;
+}
+
+int mcr_Smooth_send_frame(struct mcr_context *ctx,
+						  const struct mcr_Smooth *smPt, unsigned int frame)
+{
+	struct mcr_Scroll scroll;
+	struct mcr_MoveCursor move = { .is_justify = true };
+	long long *framePos = smPt->is_scroll ? scroll.dm : move.pos;
+	unsigned int frames = smPt->frames ? smPt->frames : 1;
+	int j;
+	dassert(frame && frame <= frames);
+	/* Each frame reaches its part of the total, so rounding does not
+	 * accumulate. */
+	for (j = 0; j < MCR_DIMENSION_CNT; j++) {
+		framePos[j] = smPt->dm[j] * frame / frames -
+					  smPt->dm[j] * (frame - 1) / frames;
+	}
+	return smPt->is_scroll ? mcr_Scroll_send_data(ctx, &scroll) :
+		   mcr_MoveCursor_send_data(ctx, &move);
+}
+
+struct mcr_ISignal *mcr_iSmooth(struct mcr_context *ctx)
+{
+	dassert(ctx);
+	return &ctx->standard.ismooth;
+}
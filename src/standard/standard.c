@@ -62,16 +62,20 @@ bool mcr_resembles_absolute(const mcr_Dimensions first,
 #define SEND(s) s ## _send
 int mcr_standard_initialize(struct mcr_context *ctx)
 {
+	/* Registered in reverse, Smooth is last to keep ids of the others */
 	struct mcr_ISignal *sigs[] = {
+		mcr_iSmooth(ctx),
 		mcr_iEcho(ctx), mcr_iKey(ctx), mcr_iModifier(ctx),
 		mcr_iMC(ctx), mcr_iNoOp(ctx), mcr_iScroll(ctx)
 	};
 	size_t sigSizes[] = {
+		SIZE(mcr_Smooth),
 		SIZE(mcr_HidEcho), SIZE(mcr_Key),
 		SIZE(mcr_Modifier), SIZE(mcr_MoveCursor),
 		SIZE(mcr_NoOp), SIZE(mcr_Scroll)
 	};
 	mcr_signal_fnc sendFns[] = {
+		SEND(mcr_Smooth),
 		SEND(mcr_HidEcho), SEND(mcr_Key), SEND(mcr_Modifier),
 		SEND(mcr_MoveCursor), SEND(mcr_NoOp), SEND(mcr_Scroll)
 	};
@@ -130,7 +134,7 @@ int mcr_standard_load_contract(struct mcr_context *ctx)
 {
 	struct mcr_ISignal *sigs[] = {
 		mcr_iEcho(ctx), mcr_iKey(ctx), mcr_iModifier(ctx),
-		mcr_iMC(ctx), mcr_iNoOp(ctx), mcr_iScroll(ctx)
+		mcr_iMC(ctx), mcr_iNoOp(ctx), mcr_iScroll(ctx), mcr_iSmooth(ctx)
 	};
 	struct mcr_ITrigger *trigs[] = {
 		mcr_iAction(ctx), mcr_iStaged(ctx)
@@ -140,7 +144,7 @@ int mcr_standard_load_contract(struct mcr_context *ctx)
 	struct mcr_IRegistry *regPt = mcr_ISignal_reg(ctx);
 	const char *names[] = {
 		"HidEcho", "Key", "Modifier",
-		"MoveCursor", "NoOp", "Scroll"
+		"MoveCursor", "NoOp", "Scroll", "Smooth"
 	};
 	const char *echoAdd[] = {
 		"Echo", "HidEcho", "HID Echo", "hid_echo"
@@ -62,9 +62,10 @@ int mcr_Echo_set_mouse_flag(size_t echoCode, int mouseEventFlags)
 	return mcr_Map_map(&mcr_flagToEcho, &mouseEventFlags, &echoCode);
 }
 
-void mcr_cursor_position(mcr_SpacePosition buffer)
+void mcr_cursor_position(struct mcr_context *ctx, mcr_SpacePosition buffer)
 {
 	POINT p;
+	UNUSED(ctx);
 	if (GetCursorPos(&p)) {
 		buffer[MCR_X] = p.x;
 		buffer[MCR_Y] = p.y;
@@ -74,8 +75,9 @@ void mcr_cursor_position(mcr_SpacePosition buffer)
 	}
 }
 
-int mcr_HidEcho_send_data(struct mcr_HidEcho *echoPt)
+int mcr_HidEcho_send_data(struct mcr_context *ctx, struct mcr_HidEcho *echoPt)
 {
+	UNUSED(ctx);
 	if (echoPt->echo < mcr_echoEvents.used) {
 		mouse_event((DWORD)*(int *)MCR_ARR_ELEMENT(mcr_echoEvents,
 					echoPt->echo), 0, 0, 0, 0);
@@ -83,8 +85,9 @@ int mcr_HidEcho_send_data(struct mcr_HidEcho *echoPt)
 	return 0;
 }
 
-int mcr_Key_send_data(struct mcr_Key *keyPt)
+int mcr_Key_send_data(struct mcr_context *ctx, struct mcr_Key *keyPt)
 {
+	UNUSED(ctx);
 	if (keyPt->apply != MCR_UNSET) {
 		keybd_event((BYTE) keyPt->key, (BYTE) keyPt->key,
 					KEYEVENTF_EXTENDEDKEY, 0);
@@ -96,16 +99,19 @@ int mcr_Key_send_data(struct mcr_Key *keyPt)
 	return 0;
 }
 
-int mcr_MoveCursor_send_data(struct mcr_MoveCursor *mcPt)
+int mcr_MoveCursor_send_data(struct mcr_context *ctx,
+							 struct mcr_MoveCursor *mcPt)
 {
+	UNUSED(ctx);
 	mouse_event(mcPt->is_justify ? MOUSEEVENTF_MOVE :
 				MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE,
 				(DWORD) mcPt->pos[MCR_X], (DWORD) mcPt->pos[MCR_Y], 0, 0);
 	return 0;
 }
 
-int mcr_Scroll_send_data(struct mcr_Scroll *scrPt)
+int mcr_Scroll_send_data(struct mcr_context *ctx, struct mcr_Scroll *scrPt)
 {
+	UNUSED(ctx);
 	if (scrPt->dm[MCR_Y])
 		mouse_event(MOUSEEVENTF_WHEEL, 0, 0, (DWORD) scrPt->dm[MCR_Y], 0);
 	if (scrPt->dm[MCR_X])
@@ -113,6 +119,57 @@ int mcr_Scroll_send_data(struct mcr_Scroll *scrPt)
 	return 0;
 }
 
+/* Input is sent immediately, there is no output to buffer. */
+void mcr_output_begin(bool mergeFrames)
+{
+	UNUSED(mergeFrames);
+}
+
+int mcr_output_flush(void)
+{
+	return 0;
+}
+
+int mcr_output_end(void)
+{
+	return 0;
+}
+
+bool mcr_output_is_buffering(void)
+{
+	return false;
+}
+
+/* All input is sent to the one system output. */
+int mcr_output_add(struct mcr_context *ctx, unsigned int *outputPt)
+{
+	UNUSED(ctx);
+	UNUSED(outputPt);
+	mset_error_return(ENOTSUP);
+}
+
+unsigned int mcr_output_count(struct mcr_context *ctx)
+{
+	UNUSED(ctx);
+	return 1;
+}
+
+int mcr_output_set_signal_route(struct mcr_context *ctx,
+								struct mcr_ISignal *isigPt, unsigned int output)
+{
+	UNUSED(ctx);
+	UNUSED(isigPt);
+	if (output)
+		mset_error_return(ENOENT);
+	return 0;
+}
+
+unsigned int mcr_output_set_thread_route(unsigned int output)
+{
+	UNUSED(output);
+	return 0;
+}
+
 int mcr_standard_platform_initialize(struct mcr_context *context)
 {
 	if (_initialize_count) {
@@ -112,7 +112,8 @@ int thrd_join(thrd_t thr, int *res)
 	dassert(thr);
 	static_cast<std::thread *>(thr)->join();
 	delete static_cast<std::thread *>(thr);
-	*res = thrd_success;
+	if (res)
+		*res = thrd_success;
 	return thrd_success;
 }
 
@@ -319,6 +320,8 @@ int cnd_wait(cnd_t * cond, mtx_t * mutex)
 	std::unique_lock<std::mutex> lock
 	(*static_cast<std::mutex *>(mutex->mtx), std::adopt_lock_t());
 	caster->wait(lock);
+	/* Mutex is still owned by caller */
+	lock.release();
 	return thrd_success;
 }
 
@@ -335,17 +338,18 @@ int cnd_timedwait(cnd_t * __restrict cond, mtx_t * __restrict mutex,
 
 	std::condition_variable * caster = static_cast<std::condition_variable *>
 									   (*cond);
-	std::chrono::seconds sec = std::chrono::seconds(time_point->tv_sec);
-	std::chrono::nanoseconds nsec = std::chrono::nanoseconds
-									(time_point->tv_nsec);
+	/* C11 time_point is absolute TIME_UTC, the same epoch as system_clock */
+	std::chrono::system_clock::time_point until =
+		std::chrono::system_clock::time_point(
+			std::chrono::duration_cast<std::chrono::system_clock::duration>(
+				std::chrono::seconds(time_point->tv_sec) +
+				std::chrono::nanoseconds(time_point->tv_nsec)));
 	std::cv_status ret = std::cv_status::no_timeout;
 	std::unique_lock < std::mutex > lock
 	(*static_cast<std::mutex *>(mutex->mtx), std::adopt_lock_t());
-	ret = caster->wait_for(lock, sec);
-	/* Timed out seconds, try for nsec */
-	if (ret != std::cv_status::no_timeout)
-		ret = caster->wait_for(lock, nsec);
-	/* Condition has been met for either sec or nsec. */
+	ret = caster->wait_until(lock, until);
+	/* Mutex is still owned by caller */
+	lock.release();
 	if (ret == std::cv_status::no_timeout)
 		return thrd_success;
 	return thrd_timedout;
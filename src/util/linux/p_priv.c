@@ -16,12 +16,20 @@
   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+/* sched_setaffinity and cpu_set_t */
+#ifndef _GNU_SOURCE
+	#define _GNU_SOURCE
+#endif
+
 #include "mcr/util/linux/p_util.h"
 #include "mcr/util/util.h"
 
 #include <errno.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 
 static int _uid = 1000;
 void mcr_setuid(int uid)
@@ -60,3 +68,59 @@ int mcr_privilege_deactivate()
 	dassert(getuid() && geteuid());
 	return 0;
 }
+
+static int set_policy(int policy, int priority)
+{
+	struct sched_param param;
+	int err, nativePolicy = policy == MCR_SCHED_RR ? SCHED_RR : SCHED_FIFO;
+	if (policy != MCR_SCHED_FIFO && policy != MCR_SCHED_RR)
+		return EINVAL;
+	if (priority < sched_get_priority_min(nativePolicy) ||
+		priority > sched_get_priority_max(nativePolicy)) {
+		return EINVAL;
+	}
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = priority;
+	/* EPERM without CAP_SYS_NICE or RLIMIT_RTPRIO */
+	if ((err = pthread_setschedparam(pthread_self(), nativePolicy, &param)))
+		return err;
+	return 0;
+}
+
+static int set_affinity(unsigned long long cpuMask)
+{
+	cpu_set_t cpus;
+	int i, bitCount = (int)(sizeof(cpuMask) * 8);
+	CPU_ZERO(&cpus);
+	for (i = 0; i < bitCount && i < CPU_SETSIZE; i++) {
+		if (cpuMask & (1ULL << i))
+			CPU_SET(i, &cpus);
+	}
+	/* 0 is the calling thread. EINVAL if no CPU in the mask exists */
+	if (sched_setaffinity(0, sizeof(cpus), &cpus) == -1)
+		return errno ? errno : EINVAL;
+	return 0;
+}
+
+int mcr_thrd_set_options(const struct mcr_ThreadOptions *optionsPt)
+{
+	int err = 0, optErr;
+	if (!optionsPt)
+		return 0;
+	if (optionsPt->policy != MCR_SCHED_DEFAULT &&
+		(optErr = set_policy(optionsPt->policy, optionsPt->priority))) {
+		err = optErr;
+	}
+	if (optionsPt->cpu_mask && (optErr = set_affinity(optionsPt->cpu_mask)) &&
+		!err) {
+		err = optErr;
+	}
+	/* EPERM or ENOMEM past RLIMIT_MEMLOCK without CAP_IPC_LOCK */
+	if (optionsPt->lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) == -1 &&
+		!err) {
+		err = errno ? errno : EPERM;
+	}
+	if (err)
+		mset_error_return(err);
+	return 0;
+}
@@ -19,7 +19,16 @@
 #include "mcr/util/none/p_util.h"
 #include "mcr/util/util.h"
 
+#include <errno.h>
+
 int mcr_privilege_deactivate()
 {
 	return 0;
 }
+
+int mcr_thrd_set_options(const struct mcr_ThreadOptions *optionsPt)
+{
+	if (optionsPt && mcr_ThreadOptions_isset(optionsPt))
+		mset_error_return(ENOTSUP);
+	return 0;
+}
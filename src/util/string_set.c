@@ -197,7 +197,7 @@ int mcr_StringSet_set(mcr_StringSet * setPt, size_t pos, const char *copyStr)
 {
 	dassert(setPt);
 	dassert(pos <= setPt->used);
-	if (mcr_StringSet_minused(setPt, pos))
+	if (mcr_StringSet_minused(setPt, pos + 1))
 		return mcr_err;
 	if (copyStr) {
 		return mcr_String_replace(MCR_STRINGSET_ELEMENT(*setPt, pos),
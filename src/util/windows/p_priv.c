@@ -19,7 +19,35 @@
 #include "mcr/util/windows/p_util.h"
 #include "mcr/util/util.h"
 
+#include <errno.h>
+
 int mcr_privilege_deactivate()
 {
 	return 0;
 }
+
+int mcr_thrd_set_options(const struct mcr_ThreadOptions *optionsPt)
+{
+	int err = 0;
+	if (!optionsPt)
+		return 0;
+	if (optionsPt->policy != MCR_SCHED_DEFAULT) {
+		/* No real-time policies, closest is a raised thread priority. */
+		if (!SetThreadPriority(GetCurrentThread(),
+							   optionsPt->policy == MCR_SCHED_FIFO ?
+							   THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST)) {
+			err = EPERM;
+		}
+	}
+	if (optionsPt->cpu_mask &&
+		!SetThreadAffinityMask(GetCurrentThread(),
+							   (DWORD_PTR)optionsPt->cpu_mask) && !err) {
+		err = EINVAL;
+	}
+	/* VirtualLock is per-region, there is no whole-process lock. */
+	if (optionsPt->lock_memory && !err)
+		err = ENOTSUP;
+	if (err)
+		mset_error_return(err);
+	return 0;
+}
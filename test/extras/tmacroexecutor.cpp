@@ -0,0 +1,117 @@
+#include "tmacroexecutor.h"
+
+/* QCOMPARE = {actual, expected} */
+
+void TMacroExecutor::initTestCase()
+{
+	_context = new mcr::Libmacro(false);
+	_executor = new mcr::MacroExecutor(2);
+}
+
+void TMacroExecutor::cleanupTestCase()
+{
+	delete _executor;
+	delete _context;
+}
+
+void TMacroExecutor::init()
+{
+	_mcrPt = new mcr_Macro;
+	QCOMPARE(mcr_Macro_init(_mcrPt), 0);
+	QCOMPARE(mcr_Macro_set_all(_mcrPt, false, false, 1, true, _context->ptr()), 0);
+}
+
+void TMacroExecutor::cleanup()
+{
+	QCOMPARE(mcr_Macro_deinit(_mcrPt), 0);
+	delete _mcrPt;
+	_mcrPt = nullptr;
+}
+
+void TMacroExecutor::setDelays(int count, int msec)
+{
+	mcr_NoOp delay = {};
+	mcr_Signal delaySig;
+	mcr_Signal_init(&delaySig);
+	delay.msec = msec;
+	delaySig.isignal = mcr_iNoOp(_context->ptr());
+	delaySig.instance.data.data = &delay;
+	for (int i = 0; i < count; i++) {
+		QCOMPARE(mcr_Macro_push_signal(_mcrPt, &delaySig), 0);
+	}
+}
+
+void TMacroExecutor::waitTasks()
+{
+	while (_executor->taskCount())
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void TMacroExecutor::pauseContinue()
+{
+	setDelays(4, 100);
+	auto start = std::chrono::steady_clock::now();
+	QVERIFY(_executor->trigger(_mcrPt));
+	std::this_thread::sleep_for(std::chrono::milliseconds(150));
+	QCOMPARE(mcr_Macro_interrupt(_mcrPt, MCR_PAUSE), 0);
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	QCOMPARE(mcr_Macro_interrupt(_mcrPt, MCR_CONTINUE), 0);
+	waitTasks();
+	/* 400 msec of delays and 300 msec paused, not the maximum pause */
+	QVERIFY(std::chrono::steady_clock::now() - start <
+			std::chrono::milliseconds(MCR_MAX_PAUSE_COUNT * 1000));
+	QCOMPARE(_mcrPt->thread_count, 0);
+}
+
+void TMacroExecutor::queuePolicy()
+{
+	mcr_MacroStats stats;
+	setDelays(1, 50);
+	QCOMPARE(mcr_Macro_set_queue_policy(_mcrPt, MCR_QUEUE_LIMIT, 2), 0);
+	QVERIFY(_executor->trigger(_mcrPt));
+	QVERIFY(_executor->trigger(_mcrPt));
+	QVERIFY(_executor->trigger(_mcrPt));
+	QVERIFY(!_executor->trigger(_mcrPt));
+	waitTasks();
+	QCOMPARE(mcr_Macro_stats(_mcrPt, &stats), 0);
+	QCOMPARE(stats.triggers, 4ull);
+	QCOMPARE(stats.executions, 3ull);
+	QCOMPARE(stats.coalesced, 1ull);
+	QCOMPARE(_mcrPt->queued, 0u);
+}
+
+void TMacroExecutor::disableWakes()
+{
+	setDelays(1, 5000);
+	QVERIFY(_executor->trigger(_mcrPt));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	auto start = std::chrono::steady_clock::now();
+	QCOMPARE(mcr_Macro_disable_confirmed(_mcrPt), 0);
+	/* Notified, not waiting for the delay or polling */
+	QVERIFY(std::chrono::steady_clock::now() - start <
+			std::chrono::milliseconds(500));
+	QCOMPARE(_mcrPt->thread_count, 0);
+	waitTasks();
+}
+
+void TMacroExecutor::smoothWakes()
+{
+	mcr_Signal smoothSig;
+	mcr_Dimensions dm = {0, 50, 0};
+	mcr_Signal_init(&smoothSig);
+	QCOMPARE(mcr_Instance_set_interface(&smoothSig,
+										 mcr_iSmooth(_context->ptr())), 0);
+	QCOMPARE(mcr_Instance_reset(&smoothSig), 0);
+	mcr_Smooth_set_all(mcr_Smooth_data(&smoothSig), dm, true, 50, 100000);
+	QCOMPARE(mcr_Macro_push_signal(_mcrPt, &smoothSig), 0);
+	mcr_Instance_deinit(&smoothSig);
+	QVERIFY(_executor->trigger(_mcrPt));
+	std::this_thread::sleep_for(std::chrono::milliseconds(150));
+	auto start = std::chrono::steady_clock::now();
+	QCOMPARE(mcr_Macro_disable_confirmed(_mcrPt), 0);
+	/* Frames wait on a timer, not blocking the executor thread */
+	QVERIFY(std::chrono::steady_clock::now() - start <
+			std::chrono::milliseconds(500));
+	QCOMPARE(_mcrPt->thread_count, 0);
+	waitTasks();
+}
@@ -0,0 +1,31 @@
+#include <QtTest/QtTest>
+
+#include "mcr/extras/extras.h"
+
+class TMacroExecutor : public QObject
+{
+	Q_OBJECT
+public:
+	TMacroExecutor() : _context(nullptr), _executor(nullptr), _mcrPt(nullptr)
+	{
+	}
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void init();
+	void cleanup();
+
+	void pauseContinue();
+	void queuePolicy();
+	void disableWakes();
+	void smoothWakes();
+
+private:
+	mcr::Libmacro *_context;
+	mcr::MacroExecutor *_executor;
+	mcr_Macro *_mcrPt;
+
+	void setDelays(int count, int msec);
+	void waitTasks();
+};
@@ -0,0 +1,113 @@
+#include "treplay.h"
+
+#include <poll.h>
+#include <unistd.h>
+
+/* QCOMPARE = {actual, expected} */
+
+/* Each test has its own context, reactors are only stopped
+ * synchronously when deallocated. */
+void TReplay::init()
+{
+	_ctx = mcr_allocate();
+	QVERIFY(_ctx);
+	QCOMPARE(mcr_Dispatcher_add_generic(_ctx, nullptr, this, receive), 0);
+	mcr_Dispatcher_set_enabled(_ctx, nullptr, true);
+	mcr_intercept_set_blockable(_ctx, true);
+}
+
+void TReplay::cleanup()
+{
+	QCOMPARE(mcr_Dispatcher_remove(_ctx, nullptr, this), 0);
+	QCOMPARE(mcr_deallocate(_ctx), 0);
+}
+
+/* Block KEY_B */
+bool TReplay::receive(void *receiver, mcr_Signal *sigPt, unsigned int mods)
+{
+	Q_UNUSED(mods);
+	return sigPt && sigPt->isignal == mcr_iKey(static_cast<TReplay *>
+			(receiver)->_ctx) && mcr_Key_data(sigPt)->key == KEY_B;
+}
+
+void TReplay::writeEvents(int fd, const input_event *events, size_t count)
+{
+	QCOMPARE(write(fd, events, count * sizeof(input_event)),
+			 static_cast<ssize_t>(count * sizeof(input_event)));
+}
+
+/* Read until count events, or nothing is written for timeout
+ * milliseconds */
+size_t TReplay::readEvents(int fd, input_event *events, size_t count,
+						   int timeout)
+{
+	pollfd pfd = { fd, POLLIN, 0 };
+	size_t bytes = 0;
+	ssize_t got;
+	while (bytes < count * sizeof(input_event) && poll(&pfd, 1, timeout) > 0) {
+		got = read(fd, reinterpret_cast<char *>(events) + bytes,
+				   count * sizeof(input_event) - bytes);
+		if (got <= 0)
+			break;
+		bytes += got;
+	}
+	return bytes / sizeof(input_event);
+}
+
+void TReplay::compareEvent(const input_event &event, int type, int code,
+						   int value)
+{
+	QCOMPARE(static_cast<int>(event.type), type);
+	QCOMPARE(static_cast<int>(event.code), code);
+	QCOMPARE(event.value, value);
+}
+
+void TReplay::passthrough_data()
+{
+	QTest::addColumn<bool>("ring");
+	QTest::newRow("epoll") << false;
+	QTest::newRow("io_uring") << true;
+}
+
+/* Replay through a pipe, written in pieces that split frames, and read
+ * the passthrough.  Each frame is written together with events of the
+ * blocked key removed, and frames of only blocked events are not
+ * written. */
+void TReplay::passthrough()
+{
+	QFETCH(bool, ring);
+	mcr_GrabberCapabilities caps = {};
+	input_event events[] = {
+		{ {}, EV_KEY, KEY_A, 1 }, { {}, EV_KEY, KEY_B, 1 },
+		{ {}, EV_SYN, SYN_REPORT, 0 },
+		{ {}, EV_KEY, KEY_B, 0 }, { {}, EV_SYN, SYN_REPORT, 0 },
+		{ {}, EV_REL, REL_X, 3 }, { {}, EV_REL, REL_Y, -2 },
+		{ {}, EV_SYN, SYN_REPORT, 0 },
+		{ {}, EV_KEY, KEY_A, 0 }, { {}, EV_SYN, SYN_REPORT, 0 }
+	};
+	input_event read[16];
+	int in[2], out[2];
+	QVERIFY(!pipe(in));
+	QVERIFY(!pipe(out));
+	QCOMPARE(mcr_intercept_set_ring_enabled(_ctx, ring), 0);
+	QCOMPARE(mcr_intercept_set_passthrough_fd(_ctx, out[1]), 0);
+	QCOMPARE(mcr_Trace_write_header(in[1], &caps, CLOCK_MONOTONIC), 0);
+	QCOMPARE(mcr_intercept_add_replay(_ctx, in[0]), 0);
+	/* First frame in two reads, not written until complete */
+	writeEvents(in[1], events, 1);
+	QCOMPARE(readEvents(out[0], read, 16, 100), static_cast<size_t>(0));
+	writeEvents(in[1], events + 1, 6);
+	writeEvents(in[1], events + 7, 3);
+	close(in[1]);
+	QCOMPARE(readEvents(out[0], read, 16, 1000), static_cast<size_t>(7));
+	compareEvent(read[0], EV_KEY, KEY_A, 1);
+	compareEvent(read[1], EV_SYN, SYN_REPORT, 0);
+	compareEvent(read[2], EV_REL, REL_X, 3);
+	compareEvent(read[3], EV_REL, REL_Y, -2);
+	compareEvent(read[4], EV_SYN, SYN_REPORT, 0);
+	compareEvent(read[5], EV_KEY, KEY_A, 0);
+	compareEvent(read[6], EV_SYN, SYN_REPORT, 0);
+	QCOMPARE(mcr_intercept_set_passthrough_fd(_ctx, -1), 0);
+	close(out[0]);
+	close(out[1]);
+}
@@ -0,0 +1,32 @@
+#include <QtTest/QtTest>
+
+#include "mcr/libmacro.h"
+#include "mcr/intercept/linux/p_intercept.h"
+#include "mcr/intercept/linux/p_trace.h"
+
+class TReplay : public QObject
+{
+	Q_OBJECT
+public:
+	TReplay() : _ctx(nullptr)
+	{
+	}
+
+private slots:
+	void init();
+	void cleanup();
+
+	void passthrough_data();
+	void passthrough();
+
+private:
+	mcr_context *_ctx;
+
+	static bool receive(void *receiver, mcr_Signal *sigPt,
+						unsigned int mods);
+	void writeEvents(int fd, const input_event *events, size_t count);
+	size_t readEvents(int fd, input_event *events, size_t count,
+					  int timeout);
+	void compareEvent(const input_event &event, int type, int code,
+					  int value);
+};
@@ -46,3 +46,18 @@ void TMacroReceive::receive()
 	/* Macro contains 3 1-second pauses. */
 	std::this_thread::sleep_for(std::chrono::seconds(4));
 }
+
+void TMacroReceive::disableConfirmed()
+{
+	mcr_Macro_receive(_mcrPt, nullptr, 0);
+	/* Wait to be inside the first 1-second pause. */
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	QCOMPARE(_mcrPt->thread_count, 1);
+	auto start = std::chrono::steady_clock::now();
+	QCOMPARE(mcr_Macro_disable_confirmed(_mcrPt), 0);
+	/* Pause is cancelled, not waited for. */
+	QVERIFY(std::chrono::steady_clock::now() - start <
+			std::chrono::milliseconds(500));
+	QCOMPARE(_mcrPt->thread_count, 0);
+	QCOMPARE(mcr_Macro_set_enabled(_mcrPt, true), 0);
+}
@@ -15,6 +15,7 @@ private slots:
 	void cleanupTestCase();
 
 	void receive();
+	void disableConfirmed();
 private:
 	mcr_context *_ctx;
 	mcr_Macro *_mcrPt;
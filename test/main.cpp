@@ -3,14 +3,32 @@
 #include "tlibmacro.h"
 #include "signal/tgendispatch.h"
 #include "macro/tmacroreceive.h"
+#include "standard/trecorder.h"
+#include "extras/tmacroexecutor.h"
+#ifdef __linux__
+	#include "standard/linux/toutput.h"
+	#include "intercept/linux/treplay.h"
+#endif
 
 int main(int argc, char **argv)
 {
 	TLibmacro tlibmacro;
 	TGenDispatch tgendispatch;
 	TMacroReceive tmacroreceive;
+	TRecorder trecorder;
+	TMacroExecutor tmacroexecutor;
+#ifdef __linux__
+	TOutput toutput;
+	TReplay treplay;
+#endif
 	QTest::qExec(&tlibmacro, argc, argv);
 	QTest::qExec(&tgendispatch, argc, argv);
 	QTest::qExec(&tmacroreceive, argc, argv);
+	QTest::qExec(&trecorder, argc, argv);
+	QTest::qExec(&tmacroexecutor, argc, argv);
+#ifdef __linux__
+	QTest::qExec(&toutput, argc, argv);
+	QTest::qExec(&treplay, argc, argv);
+#endif
 	return 0;
 }
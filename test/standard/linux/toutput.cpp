@@ -0,0 +1,241 @@
+#include "toutput.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/* QCOMPARE = {actual, expected} */
+
+void TOutput::initTestCase()
+{
+	_ctx = mcr_allocate();
+	QVERIFY(_ctx);
+	_gen = mcr_Device_gen(_ctx);
+	QVERIFY(_gen);
+	QCOMPARE(mcr_output_set_sink(_ctx, MCR_SINK_RING, 64), 0);
+}
+
+void TOutput::cleanupTestCase()
+{
+	QCOMPARE(mcr_output_set_sink(_ctx, MCR_SINK_UINPUT, 0), 0);
+	mcr_deallocate(_ctx);
+	QCOMPARE(mcr_err, 0);
+}
+
+void TOutput::init()
+{
+	mcr_Device_sink_reset(_gen);
+}
+
+void TOutput::sendKey(int key, mcr_ApplyType apply)
+{
+	mcr_Key keyData = {};
+	keyData.key = key;
+	keyData.apply = apply;
+	QCOMPARE(mcr_Key_send_data(_ctx, &keyData), 0);
+}
+
+void TOutput::sendScroll(long long x, long long y, long long z)
+{
+	mcr_Scroll scroll = {};
+	scroll.dm[MCR_X] = x;
+	scroll.dm[MCR_Y] = y;
+	scroll.dm[MCR_Z] = z;
+	QCOMPARE(mcr_Scroll_send_data(_ctx, &scroll), 0);
+}
+
+size_t TOutput::read(input_event *events, size_t count)
+{
+	return mcr_Device_sink_read(_gen, events, count);
+}
+
+size_t TOutput::writes()
+{
+	mcr_SinkCounts counts;
+	mcr_Device_sink_counts(_gen, &counts);
+	return counts.writes;
+}
+
+void TOutput::compareEvent(const input_event &event, int type, int code,
+						   int value)
+{
+	QCOMPARE(static_cast<int>(event.type), type);
+	QCOMPARE(static_cast<int>(event.code), code);
+	QCOMPARE(event.value, value);
+}
+
+void TOutput::keyPressRelease()
+{
+	input_event events[16];
+	sendKey(KEY_A, MCR_SET);
+	sendKey(KEY_A, MCR_UNSET);
+	QCOMPARE(read(events, 16), static_cast<size_t>(4));
+	compareEvent(events[0], EV_KEY, KEY_A, 1);
+	compareEvent(events[1], EV_SYN, SYN_REPORT, 0);
+	compareEvent(events[2], EV_KEY, KEY_A, 0);
+	compareEvent(events[3], EV_SYN, SYN_REPORT, 0);
+	/* Both is one write of two frames */
+	sendKey(KEY_B, MCR_BOTH);
+	QCOMPARE(writes(), static_cast<size_t>(3));
+	QCOMPARE(read(events, 16), static_cast<size_t>(4));
+	compareEvent(events[0], EV_KEY, KEY_B, 1);
+	compareEvent(events[1], EV_SYN, SYN_REPORT, 0);
+	compareEvent(events[2], EV_KEY, KEY_B, 0);
+	compareEvent(events[3], EV_SYN, SYN_REPORT, 0);
+}
+
+void TOutput::moveCursorElision()
+{
+	input_event events[16];
+	mcr_MoveCursor move = {};
+	move.is_justify = true;
+	move.pos[MCR_Y] = -3;
+	QCOMPARE(mcr_MoveCursor_send_data(_ctx, &move), 0);
+	QCOMPARE(read(events, 16), static_cast<size_t>(2));
+	compareEvent(events[0], EV_REL, REL_Y, -3);
+	compareEvent(events[1], EV_SYN, SYN_REPORT, 0);
+	/* No movement is not written */
+	move.pos[MCR_Y] = 0;
+	QCOMPARE(mcr_MoveCursor_send_data(_ctx, &move), 0);
+	QCOMPARE(writes(), static_cast<size_t>(1));
+	QCOMPARE(read(events, 16), static_cast<size_t>(0));
+}
+
+void TOutput::scrollElision()
+{
+	input_event events[16];
+	/* Each detent is also written in high resolution */
+	sendScroll(0, 2, 0);
+	QCOMPARE(read(events, 16), static_cast<size_t>(3));
+	compareEvent(events[0], EV_REL, REL_WHEEL_HI_RES, 2 * MCR_WHEEL_HI_RES);
+	compareEvent(events[1], EV_REL, REL_WHEEL, 2);
+	compareEvent(events[2], EV_SYN, SYN_REPORT, 0);
+	/* Only axes that scroll are written */
+	sendScroll(0, 0, -1);
+	QCOMPARE(read(events, 16), static_cast<size_t>(2));
+	compareEvent(events[0], EV_REL, REL_DIAL, -1);
+	compareEvent(events[1], EV_SYN, SYN_REPORT, 0);
+	sendScroll(0, 0, 0);
+	QCOMPARE(writes(), static_cast<size_t>(2));
+	QCOMPARE(read(events, 16), static_cast<size_t>(0));
+}
+
+void TOutput::scrollHiRes()
+{
+	input_event events[16];
+	mcr_Scroll_set_hi_res(_ctx, true);
+	/* Half of a detent from the last detent is not a detent */
+	sendScroll(MCR_WHEEL_HI_RES / 2, 0, 0);
+	QCOMPARE(read(events, 16), static_cast<size_t>(2));
+	compareEvent(events[0], EV_REL, REL_HWHEEL_HI_RES, MCR_WHEEL_HI_RES / 2);
+	compareEvent(events[1], EV_SYN, SYN_REPORT, 0);
+	/* Crossing zero is a detent in either direction */
+	sendScroll(-MCR_WHEEL_HI_RES, 0, 0);
+	QCOMPARE(read(events, 16), static_cast<size_t>(3));
+	compareEvent(events[0], EV_REL, REL_HWHEEL_HI_RES, -MCR_WHEEL_HI_RES);
+	compareEvent(events[1], EV_REL, REL_HWHEEL, -1);
+	sendScroll(MCR_WHEEL_HI_RES, 0, 0);
+	QCOMPARE(read(events, 16), static_cast<size_t>(3));
+	compareEvent(events[1], EV_REL, REL_HWHEEL, 1);
+	/* Partial detents add up */
+	sendScroll(MCR_WHEEL_HI_RES / 2, 0, 0);
+	QCOMPARE(read(events, 16), static_cast<size_t>(3));
+	compareEvent(events[1], EV_REL, REL_HWHEEL, 1);
+	mcr_Scroll_set_hi_res(_ctx, false);
+}
+
+void TOutput::bufferedFlush()
+{
+	input_event events[16];
+	mcr_output_begin(false);
+	QVERIFY(mcr_output_is_buffering());
+	sendKey(KEY_A, MCR_BOTH);
+	sendKey(KEY_B, MCR_BOTH);
+	QCOMPARE(writes(), static_cast<size_t>(0));
+	/* Flushing continues buffering */
+	QCOMPARE(mcr_output_flush(), 0);
+	QCOMPARE(writes(), static_cast<size_t>(1));
+	QCOMPARE(read(events, 16), static_cast<size_t>(8));
+	QVERIFY(mcr_output_is_buffering());
+	sendKey(KEY_C, MCR_BOTH);
+	QCOMPARE(writes(), static_cast<size_t>(1));
+	QCOMPARE(mcr_output_end(), 0);
+	QVERIFY(!mcr_output_is_buffering());
+	QCOMPARE(writes(), static_cast<size_t>(2));
+	QCOMPARE(read(events, 16), static_cast<size_t>(4));
+	compareEvent(events[0], EV_KEY, KEY_C, 1);
+}
+
+void TOutput::mergeFrames()
+{
+	input_event events[16];
+	mcr_output_begin(true);
+	sendKey(KEY_A, MCR_SET);
+	/* Nested calls continue merging */
+	mcr_output_begin(false);
+	sendKey(KEY_B, MCR_SET);
+	QCOMPARE(mcr_output_end(), 0);
+	QCOMPARE(read(events, 16), static_cast<size_t>(0));
+	QCOMPARE(mcr_output_end(), 0);
+	QCOMPARE(writes(), static_cast<size_t>(1));
+	QCOMPARE(read(events, 16), static_cast<size_t>(3));
+	compareEvent(events[0], EV_KEY, KEY_A, 1);
+	compareEvent(events[1], EV_KEY, KEY_B, 1);
+	compareEvent(events[2], EV_SYN, SYN_REPORT, 0);
+}
+
+void TOutput::splitConflicts()
+{
+	input_event events[16];
+	mcr_output_begin(true);
+	sendKey(KEY_A, MCR_SET);
+	sendKey(KEY_B, MCR_SET);
+	/* Releasing A in the frame that pressed it would lose the press. */
+	sendKey(KEY_A, MCR_UNSET);
+	QCOMPARE(mcr_output_end(), 0);
+	QCOMPARE(read(events, 16), static_cast<size_t>(5));
+	compareEvent(events[0], EV_KEY, KEY_A, 1);
+	compareEvent(events[1], EV_KEY, KEY_B, 1);
+	compareEvent(events[2], EV_SYN, SYN_REPORT, 0);
+	compareEvent(events[3], EV_KEY, KEY_A, 0);
+	compareEvent(events[4], EV_SYN, SYN_REPORT, 0);
+	/* Without merging every signal has its own frame */
+	mcr_output_begin(false);
+	sendKey(KEY_A, MCR_SET);
+	sendKey(KEY_B, MCR_SET);
+	QCOMPARE(mcr_output_end(), 0);
+	QCOMPARE(read(events, 16), static_cast<size_t>(4));
+	compareEvent(events[1], EV_SYN, SYN_REPORT, 0);
+	compareEvent(events[3], EV_SYN, SYN_REPORT, 0);
+}
+
+void TOutput::writeLatency_data()
+{
+	QTest::addColumn<bool>("synchronous");
+	QTest::newRow("O_WRONLY") << false;
+	QTest::newRow("O_WRONLY | O_SYNC") << true;
+}
+
+/* Per-event write latency of a device written to a regular file, the
+ * only writes changed by mcr_Device.synchronous */
+void TOutput::writeLatency()
+{
+	QFETCH(bool, synchronous);
+	input_event events[2] = { mcr_syncer, mcr_syncer };
+	QTemporaryFile file;
+	int fd;
+	events[0].type = EV_KEY;
+	events[0].code = KEY_A;
+	events[0].value = 1;
+	QVERIFY(file.open());
+	fd = open(QFile::encodeName(file.fileName()).constData(),
+			  synchronous ? O_WRONLY | O_SYNC : O_WRONLY);
+	QVERIFY(fd != -1);
+	QCOMPARE(mcr_Device_set_sink(_gen, MCR_SINK_UINPUT, 0), 0);
+	_gen->fd = fd;
+	QBENCHMARK {
+		QCOMPARE(mcr_Device_send(_gen, events, 2), 0);
+	}
+	_gen->fd = -1;
+	close(fd);
+	QCOMPARE(mcr_Device_set_sink(_gen, MCR_SINK_RING, 64), 0);
+}
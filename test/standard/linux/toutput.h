@@ -0,0 +1,39 @@
+#include <QtTest/QtTest>
+
+#include "mcr/libmacro.h"
+#include "mcr/standard/linux/p_standard.h"
+
+class TOutput : public QObject
+{
+	Q_OBJECT
+public:
+	TOutput() : _ctx(nullptr), _gen(nullptr)
+	{
+	}
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void init();
+
+	void keyPressRelease();
+	void moveCursorElision();
+	void scrollElision();
+	void scrollHiRes();
+	void bufferedFlush();
+	void mergeFrames();
+	void splitConflicts();
+	void writeLatency_data();
+	void writeLatency();
+
+private:
+	mcr_context *_ctx;
+	mcr_Device *_gen;
+
+	void sendKey(int key, mcr_ApplyType apply);
+	void sendScroll(long long x, long long y, long long z);
+	size_t read(input_event *events, size_t count);
+	size_t writes();
+	void compareEvent(const input_event &event, int type, int code,
+					  int value);
+};
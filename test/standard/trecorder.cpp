@@ -0,0 +1,51 @@
+#include "trecorder.h"
+
+/* QCOMPARE = {actual, expected} */
+
+void TRecorder::initTestCase()
+{
+	_ctx = mcr_allocate();
+	QVERIFY(_ctx);
+}
+
+void TRecorder::cleanupTestCase()
+{
+	QCOMPARE(mcr_deallocate(_ctx), 0);
+}
+
+void TRecorder::echoKeyOnce()
+{
+	mcr_Recorder recorder;
+	mcr_Macro macro;
+	mcr_Signal echoSig, keySig;
+	mcr_HidEcho echo = {};
+	mcr_Key key = {};
+	mcr_Key *recordedPt;
+	QCOMPARE(mcr_Recorder_init(&recorder), 0);
+	QCOMPARE(mcr_Macro_init(&macro), 0);
+	QCOMPARE(mcr_Recorder_set_all(&recorder, _ctx, 16), 0);
+	QCOMPARE(mcr_Recorder_set_enabled(&recorder, true), 0);
+	/* Intercept dispatches the echo of a key before the key */
+	echo.echo = 0;
+	key.key = 0x110;
+	key.apply = MCR_SET;
+	mcr_Signal_init(&echoSig);
+	echoSig.isignal = mcr_iHidEcho(_ctx);
+	echoSig.instance.data.data = &echo;
+	mcr_Signal_init(&keySig);
+	keySig.isignal = mcr_iKey(_ctx);
+	keySig.instance.data.data = &key;
+	mcr_dispatch(_ctx, &echoSig);
+	mcr_dispatch(_ctx, &keySig);
+	QCOMPARE(mcr_Recorder_set_enabled(&recorder, false), 0);
+	QCOMPARE(mcr_Recorder_count(&recorder), static_cast<size_t>(1));
+	QCOMPARE(mcr_Recorder_to_macro(&recorder, &macro), 0);
+	QCOMPARE(macro.signal_set.used, static_cast<size_t>(1));
+	QCOMPARE(mcr_Macro_signal(&macro, 0)->isignal, mcr_iKey(_ctx));
+	recordedPt = mcr_Key_data(mcr_Macro_signal(&macro, 0));
+	QVERIFY(recordedPt);
+	QCOMPARE(recordedPt->key, 0x110);
+	QCOMPARE(recordedPt->apply, MCR_SET);
+	QCOMPARE(mcr_Macro_deinit(&macro), 0);
+	QCOMPARE(mcr_Recorder_deinit(&recorder), 0);
+}
@@ -0,0 +1,21 @@
+#include <QtTest/QtTest>
+
+#include "mcr/libmacro.h"
+
+class TRecorder : public QObject
+{
+	Q_OBJECT
+public:
+	TRecorder() : _ctx(nullptr)
+	{
+	}
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+
+	void echoKeyOnce();
+
+private:
+	mcr_context *_ctx;
+};
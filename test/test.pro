@@ -22,10 +22,20 @@ windows {
     !static:!staticlib: LIBS += -l$$qtLibraryTarget(crypto)
 }
 
-HEADERS += $$files(*.h, true)
+HEADERS += $$files(*.h)
+HEADERS += $$files(signal/*.h) $$files(macro/*.h) $$files(standard/*.h) \
+	$$files(extras/*.h)
 
 SOURCES += main.cpp \
 	tlibmacro.cpp \
 	signal/tgendispatch.cpp \
-	macro/tmacroreceive.cpp
+	macro/tmacroreceive.cpp \
+	standard/trecorder.cpp \
+	extras/tmacroexecutor.cpp
 
+linux {
+	HEADERS += standard/linux/toutput.h \
+		intercept/linux/treplay.h
+	SOURCES += standard/linux/toutput.cpp \
+		intercept/linux/treplay.cpp
+}